@@ -0,0 +1,9 @@
+# Timing specs of pilight pulse width protocols, compiled to the builtin
+# table of 'decode -X', 'encode -X' and 'spec' commands. Line format is
+# described in src/picoder-spec.h, for instance:
+#
+# protocol   pulse=300 bits=13 zero=1,3 one=3,1 footer=1,30 fields=id:0:8,unit:8:4,state:12:1:off/on
+#
+# A spec named as a PiCode protocol replaces its decoder and encoder only if
+# 'picoder spec -c -p protocol' shows every sample code decodes and encodes
+# the same. Add verified specs below.
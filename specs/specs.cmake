@@ -0,0 +1,140 @@
+# "picoder"
+# Simple standalone command line tool to manage OOK protocols
+# supported by "pilight" project, PiCode library based.
+#
+# Copyright (c) 2021 Jorge Rivera. All right reserved.
+# License GNU Lesser General Public License v3.0.
+#
+# Generate builtin table of protocol timing specs from specs/*.spec files,
+# see src/picoder-spec.h for the line format. Each spec becomes a constant
+# initializer, pulse bounds are computed by the compiler from SPEC_SYMBOL()
+# and SPEC_FOOTER() macros, and checked again on startup.
+
+# Symbol list "1,3" to SPEC_SYMBOL() arguments, count and 4 lengths
+function(spec_symbol value out_count out_args)
+  if(value STREQUAL "")
+    set(lengths "")
+  else()
+    string(REPLACE "," ";" lengths "${value}")
+  endif()
+  list(LENGTH lengths count)
+  if(count GREATER 4)
+    message(FATAL_ERROR "Spec symbol '${value}' has more than 4 pulses")
+  endif()
+  set(padded ${count})
+  while(padded LESS 4)
+    list(APPEND lengths 0)
+    math(EXPR padded "${padded} + 1")
+  endwhile()
+  string(REPLACE ";" ", " args "${lengths}")
+  set(${out_count} ${count} PARENT_SCOPE)
+  set(${out_args} "${count}, ${args}" PARENT_SCOPE)
+endfunction()
+
+# Field "name:offset:width[:last]" to SPEC_FIELD() arguments
+function(spec_field value out_args)
+  string(REPLACE ":" ";" parts "${value}")
+  list(LENGTH parts count)
+  if(count LESS 3 OR count GREATER 4)
+    message(FATAL_ERROR "Spec field '${value}' invalid")
+  endif()
+  list(GET parts 0 name)
+  list(GET parts 1 offset)
+  list(GET parts 2 width)
+  set(flags 0)
+  set(const 0)
+  set(labels NULL)
+  if(count EQUAL 4)
+    list(GET parts 3 last)
+    if(last STREQUAL "r")
+      set(flags SPEC_FIELD_REVERSE)
+    elseif(last MATCHES "^=(.+)$")
+      set(flags SPEC_FIELD_CONST)
+      set(const ${CMAKE_MATCH_1})
+    elseif(last MATCHES "/")
+      set(flags SPEC_FIELD_LABELS)
+      set(labels "\"${last}\"")
+    else()
+      message(FATAL_ERROR "Spec field '${value}' invalid")
+    endif()
+  endif()
+  set(${out_args} "SPEC_FIELD(\"${name}\", ${offset}, ${width}, ${flags}, ${const}, ${labels})" PARENT_SCOPE)
+endfunction()
+
+function(picoder_generate_specs output)
+
+  file(GLOB spec_files CONFIGURE_DEPENDS ${CMAKE_CURRENT_SOURCE_DIR}/specs/*.spec)
+
+  set(table "")
+  set(count 0)
+
+  foreach(spec_file ${spec_files})
+    # GLOB only notices added or removed files, reconfigure on edits too
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${spec_file})
+    file(STRINGS ${spec_file} lines)
+    foreach(line ${lines})
+      string(REGEX REPLACE "^[ \t]+" "" line "${line}")
+      if(line STREQUAL "" OR line MATCHES "^#")
+        continue()
+      endif()
+
+      string(REGEX MATCHALL "[^ \t]+" tokens "${line}")
+      list(GET tokens 0 protocol)
+      list(REMOVE_AT tokens 0)
+
+      foreach(key pulse bits tolerance header zero one footer fields)
+        set(spec_${key} "")
+      endforeach()
+      set(spec_tolerance 35)  # DEFAULT_SPEC_TOLERANCE
+
+      foreach(token ${tokens})
+        if(NOT token MATCHES "^(pulse|bits|tolerance|header|zero|one|footer|fields)=(.*)$")
+          message(FATAL_ERROR "${spec_file}: ${protocol} '${token}' invalid")
+        endif()
+        set(spec_${CMAKE_MATCH_1} "${CMAKE_MATCH_2}")
+      endforeach()
+
+      if(spec_pulse STREQUAL "" OR spec_bits STREQUAL "" OR spec_zero STREQUAL "" OR spec_one STREQUAL "" OR spec_footer STREQUAL "")
+        message(FATAL_ERROR "${spec_file}: ${protocol} requires pulse, bits, zero, one and footer")
+      endif()
+
+      spec_symbol("${spec_header}" header_count header)
+      spec_symbol("${spec_zero}"   zero_count   zero)
+      spec_symbol("${spec_one}"    one_count    one)
+      spec_symbol("${spec_footer}" footer_count footer)
+      math(EXPR n_pulses "${header_count} + ${spec_bits} * ${zero_count} + ${footer_count}")
+
+      set(fields "")
+      set(n_fields 0)
+      if(NOT spec_fields STREQUAL "")
+        string(REPLACE "," ";" field_list "${spec_fields}")
+        foreach(field ${field_list})
+          spec_field("${field}" args)
+          string(APPEND fields "        ${args}, \\\n")
+          math(EXPR n_fields "${n_fields} + 1")
+        endforeach()
+      else()
+        set(fields "        SPEC_FIELD(NULL, 0, 0, 0, 0, NULL), \\\n")
+      endif()
+
+      set(p "${spec_pulse}, ${spec_tolerance}")
+      string(APPEND table "    { \"${protocol}\", ${p}, ${spec_bits}, ${n_pulses}, \\\n")
+      string(APPEND table "      SPEC_SYMBOL(${p}, ${header}), \\\n")
+      string(APPEND table "      SPEC_SYMBOL(${p}, ${zero}), \\\n")
+      string(APPEND table "      SPEC_SYMBOL(${p}, ${one}), \\\n")
+      string(APPEND table "      SPEC_FOOTER(${p}, ${footer}), \\\n")
+      string(APPEND table "      ${n_fields}, { \\\n${fields}      }, NULL }, \\\n")
+      math(EXPR count "${count} + 1")
+    endforeach()
+  endforeach()
+
+  set(content "/* Generated from the spec files of specs/ by specs/specs.cmake, do not edit */\n\n")
+  string(APPEND content "#define SPEC_BUILTIN \\\n${table}\n")
+
+  # Rewrite only on changes, sources including it are not rebuilt otherwise
+  file(WRITE ${output}.tmp "${content}")
+  configure_file(${output}.tmp ${output} COPYONLY)
+  file(REMOVE ${output}.tmp)
+
+  MESSAGE( STATUS "Protocol specs: ${count}")
+endfunction()
@@ -0,0 +1,548 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-analyze.h"
+#include "picoder-input.h"
+#include "picoder-stats.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef MAX_PULSE_LENGTH
+#define MAX_PULSE_LENGTH    100000UL
+#endif
+
+#ifndef MAX_FRAME_LENGTH
+#define MAX_FRAME_LENGTH    1024
+#endif
+
+#ifndef MAX_CLUSTERS
+#define MAX_CLUSTERS          16
+#endif
+
+#define ANALYZE_BLOCK       INPUT_BLOCK    /* pulses per vectorized block */
+#define DEFAULT_BUCKET        50    /* pulse histogram bucket width uSecs */
+#define DEFAULT_GAP         5000    /* pulses from this length are frame gaps */
+#define GAP_BUCKET          1000    /* gap histogram bucket width uSecs */
+#define GAP_BUCKETS         (MAX_PULSE_LENGTH / GAP_BUCKET)
+#define CLUSTER_TOLERANCE   0.2     /* bucket joins cluster if within 20% of its center */
+#define CLUSTER_MIN_SHARE   0.005   /* clusters below 0.5% of pulses are noise */
+#define BAR_WIDTH             40
+
+typedef struct {
+    uint32_t      bucket;           /* pulse histogram bucket width */
+    uint32_t      gap;              /* gap threshold */
+    double        inv_bucket;       /* 1/bucket rounded up, exact floor for any pulse */
+
+    uint64_t      pulses;
+    uint64_t      frames;
+    uint32_t      pulse_min;
+    uint32_t      pulse_max;
+
+    size_t        n_buckets;        /* pulses below gap threshold, one extra bucket for gaps */
+    uint64_t*     hist_count;
+    double*       hist_sum;
+    double*       hist_sumsq;
+
+    uint64_t      gaps;
+    uint32_t      gap_min;
+    uint32_t      gap_max;
+    double        gap_sum;
+    uint64_t      gap_hist[GAP_BUCKETS + 1];
+
+    uint32_t      frame_len;        /* pulses of current frame */
+    uint64_t      frame_hist[MAX_FRAME_LENGTH + 1];
+
+    size_t        n_protocols;
+    protocol_t**  protocols;
+    uint64_t*     matches;
+} analyze_t;
+
+typedef struct {
+    uint64_t  count;
+    double    sum;
+    double    sumsq;
+    uint32_t  min;
+    uint32_t  max;
+} cluster_t;
+
+static struct option list_options[] = {
+  { "input",      required_argument, NULL,      'i' },
+  { "bucket",     required_argument, NULL,      'b' },
+  { "gap",        required_argument, NULL,      'g' },
+  { "json",       no_argument,       NULL,      'j' },
+  { "help",       no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void analyze_help(FILE* out){
+    fprintf(out,"         analyze [-h] -i capture [-j]                 --> show pulse timing statistics of a capture\n");
+    fprintf(out,"                 [-h | --help]                        --> show command options\n");
+    fprintf(out,"                 [-i | --input capture]               --> pulse durations file ('-' stdin)\n");
+    fprintf(out,"                 [-b | --bucket uSecs]                --> pulse histogram bucket width (default %d)\n", DEFAULT_BUCKET);
+    fprintf(out,"                 [-g | --gap uSecs]                   --> min length of frame gaps (default %d)\n", DEFAULT_GAP);
+    fprintf(out,"                 [-j | --json]                        --> show results as json\n");
+}
+
+static bool analyze_init(analyze_t* a, uint32_t bucket, uint32_t gap){
+
+    protocols_t* pnode = usedProtocols();
+
+    memset(a, 0, sizeof(*a));
+
+    a->bucket     = bucket;
+    a->gap        = gap;
+    a->inv_bucket = nextafter(1.0 / bucket, 1.0);
+    a->pulse_min  = UINT32_MAX;
+    a->gap_min    = UINT32_MAX;
+
+    a->n_buckets  = (gap - 1) / bucket + 1;
+    a->hist_count = (uint64_t*)calloc(a->n_buckets + 1, sizeof(*a->hist_count));
+    a->hist_sum   = (double*)calloc(a->n_buckets + 1, sizeof(*a->hist_sum));
+    a->hist_sumsq = (double*)calloc(a->n_buckets + 1, sizeof(*a->hist_sumsq));
+
+    for (protocols_t* p = pnode; p != NULL; p = p->next){
+        a->n_protocols++;
+    }
+    a->protocols = (protocol_t**)calloc(a->n_protocols + 1, sizeof(*a->protocols));
+    a->matches   = (uint64_t*)calloc(a->n_protocols + 1, sizeof(*a->matches));
+
+    if (a->protocols != NULL){
+        size_t i = 0;
+        for (protocols_t* p = pnode; p != NULL; p = p->next){
+            a->protocols[i++] = p->listener;
+        }
+    }
+
+    return a->hist_count && a->hist_sum && a->hist_sumsq && a->protocols && a->matches;
+}
+
+static void analyze_free(analyze_t* a){
+    free(a->hist_count);
+    free(a->hist_sum);
+    free(a->hist_sumsq);
+    free(a->protocols);
+    free(a->matches);
+}
+
+/* Frame ends at gap pulse, rawlen includes the footer */
+static void analyze_frame(analyze_t* a, uint32_t gap){
+
+    uint32_t length = a->frame_len + 1;
+
+    a->frames++;
+    a->frame_hist[length < MAX_FRAME_LENGTH ? length : MAX_FRAME_LENGTH]++;
+
+    a->gaps++;
+    a->gap_sum += gap;
+    if (gap < a->gap_min) a->gap_min = gap;
+    if (gap > a->gap_max) a->gap_max = gap;
+    a->gap_hist[gap / GAP_BUCKET < GAP_BUCKETS ? gap / GAP_BUCKET : GAP_BUCKETS]++;
+
+    for (size_t i = 0; i < a->n_protocols; i++){
+        protocol_t* p = a->protocols[i];
+        if ((int)length >= p->minrawlen && (int)length <= p->maxrawlen && (int)gap >= p->mingaplen && (int)gap <= p->maxgaplen){
+            a->matches[i]++;
+        }
+    }
+
+    a->frame_len = 0;
+}
+
+/*
+    Reduce a block of pulses. The first loop is branch free so the compiler
+    vectorizes min/max, gap count and bucket indexes, histogram scatter and
+    frame walk run after it, the walk only for blocks holding a gap.
+*/
+static void analyze_block(void* ctx, const uint32_t* restrict pulses, size_t n){
+
+    analyze_t*     a       = (analyze_t*)ctx;
+    uint32_t       idx[ANALYZE_BLOCK];
+    uint32_t       vmin    = UINT32_MAX;
+    uint32_t       vmax    = 0;
+    uint32_t       n_gaps  = 0;
+    const uint32_t gap     = a->gap;
+    const uint32_t gap_idx = (uint32_t)a->n_buckets;
+    const double   inv     = a->inv_bucket;
+
+    for (size_t i = 0; i < n; i++){
+        uint32_t p  = pulses[i];
+        uint32_t g  = p >= gap;
+        vmin    = p < vmin ? p : vmin;
+        vmax    = p > vmax ? p : vmax;
+        n_gaps += g;
+        idx[i]  = g ? gap_idx : (uint32_t)((double)p * inv);
+    }
+
+    for (size_t i = 0; i < n; i++){
+        double p = (double)pulses[i];
+        a->hist_count[idx[i]]++;
+        a->hist_sum[idx[i]]   += p;
+        a->hist_sumsq[idx[i]] += p * p;
+    }
+
+    if (vmin < a->pulse_min) a->pulse_min = vmin;
+    if (vmax > a->pulse_max) a->pulse_max = vmax;
+    a->pulses += n;
+
+    if (n_gaps == 0){
+        a->frame_len += (uint32_t)n;
+    }else{
+        for (size_t i = 0; i < n; i++){
+            if (idx[i] == gap_idx){
+                analyze_frame(a, pulses[i]);
+            }else{
+                a->frame_len++;
+            }
+        }
+    }
+}
+
+/* Merge adjacent histogram buckets into clusters, returns number of clusters */
+static int analyze_clusters(const analyze_t* a, cluster_t* clusters){
+
+    int n = 0;
+
+    for (size_t b = 0; b < a->n_buckets; b++){
+        if (a->hist_count[b] == 0){
+            continue;
+        }
+        double center = a->hist_sum[b] / (double)a->hist_count[b];
+        cluster_t* c  = (n > 0) ? &clusters[n-1] : NULL;
+
+        if (c == NULL || center > (c->sum / (double)c->count) * (1.0 + CLUSTER_TOLERANCE)){
+            if (n == MAX_CLUSTERS){
+                break;
+            }
+            c = &clusters[n++];
+            memset(c, 0, sizeof(*c));
+            c->min = (uint32_t)(b * a->bucket);
+        }
+        c->count += a->hist_count[b];
+        c->sum   += a->hist_sum[b];
+        c->sumsq += a->hist_sumsq[b];
+        c->max    = (uint32_t)((b + 1) * a->bucket - 1);
+    }
+
+    /* Drop noise clusters */
+    int kept = 0;
+    uint64_t short_pulses = a->pulses - a->gaps;
+    for (int i = 0; i < n; i++){
+        if ((double)clusters[i].count >= (double)short_pulses * CLUSTER_MIN_SHARE){
+            clusters[kept++] = clusters[i];
+        }
+    }
+    return kept;
+}
+
+static double cluster_center(const cluster_t* c){
+    return c->sum / (double)c->count;
+}
+
+static double cluster_jitter(const cluster_t* c){
+    double mean = cluster_center(c);
+    double var  = c->sumsq / (double)c->count - mean * mean;
+    return var > 0 ? sqrt(var) : 0;
+}
+
+static void print_bar(uint64_t count, uint64_t max){
+    int width = max ? (int)((count * BAR_WIDTH + max - 1) / max) : 0;
+    for (int i = 0; i < width; i++){
+        putchar('#');
+    }
+    putchar('\n');
+}
+
+static void analyze_print(const analyze_t* a){
+
+    cluster_t clusters[MAX_CLUSTERS];
+    int       n_clusters = analyze_clusters(a, clusters);
+    uint64_t  max;
+
+    printf("Pulses:      %llu (min %u, max %u uSecs)\n", (unsigned long long)a->pulses, a->pulses ? a->pulse_min : 0, a->pulse_max);
+    printf("Frames:      %llu (gap >= %u uSecs)\n", (unsigned long long)a->frames, a->gap);
+
+    printf("Pulse histogram (bucket %u uSecs):\n", a->bucket);
+    max = 0;
+    for (size_t b = 0; b < a->n_buckets; b++){
+        if (a->hist_count[b] > max) max = a->hist_count[b];
+    }
+    for (size_t b = 0; b < a->n_buckets; b++){
+        if (a->hist_count[b] > 0){
+            printf("  %6u-%-6u %12llu  ", (unsigned)(b * a->bucket), (unsigned)((b + 1) * a->bucket - 1), (unsigned long long)a->hist_count[b]);
+            print_bar(a->hist_count[b], max);
+        }
+    }
+
+    printf("Clusters:    Center  Jitter     Range        Count  Share\n");
+    for (int i = 0; i < n_clusters; i++){
+        printf("  %2d        %7.1f %7.1f  %5u-%-5u %12llu  %5.1f%%\n", i, cluster_center(&clusters[i]), cluster_jitter(&clusters[i]),
+               clusters[i].min, clusters[i].max, (unsigned long long)clusters[i].count,
+               100.0 * (double)clusters[i].count / (double)(a->pulses - a->gaps));
+    }
+
+    printf("Gaps:        %llu", (unsigned long long)a->gaps);
+    if (a->gaps > 0){
+        printf(" (min %u, max %u, mean %.1f uSecs)", a->gap_min, a->gap_max, a->gap_sum / (double)a->gaps);
+    }
+    printf("\n");
+    max = 0;
+    for (size_t b = 0; b <= GAP_BUCKETS; b++){
+        if (a->gap_hist[b] > max) max = a->gap_hist[b];
+    }
+    for (size_t b = 0; b <= GAP_BUCKETS; b++){
+        if (a->gap_hist[b] > 0){
+            if (b < GAP_BUCKETS){
+                printf("  %6u-%-6u %12llu  ", (unsigned)(b * GAP_BUCKET), (unsigned)((b + 1) * GAP_BUCKET - 1), (unsigned long long)a->gap_hist[b]);
+            }else{
+                printf("  %6lu+       %12llu  ", MAX_PULSE_LENGTH, (unsigned long long)a->gap_hist[b]);
+            }
+            print_bar(a->gap_hist[b], max);
+        }
+    }
+
+    printf("Frame lengths:\n");
+    max = 0;
+    for (size_t l = 0; l <= MAX_FRAME_LENGTH; l++){
+        if (a->frame_hist[l] > max) max = a->frame_hist[l];
+    }
+    for (size_t l = 0; l <= MAX_FRAME_LENGTH; l++){
+        if (a->frame_hist[l] > 0){
+            printf("  %5u%c       %12llu  ", (unsigned)l, l == MAX_FRAME_LENGTH ? '+' : ' ', (unsigned long long)a->frame_hist[l]);
+            print_bar(a->frame_hist[l], max);
+        }
+    }
+
+    printf("Candidate protocols:\n");
+    for (size_t i = 0; i < a->n_protocols; i++){
+        if (a->matches[i] > 0){
+            printf("  %-20s %12llu  %5.1f%%\n", a->protocols[i]->id, (unsigned long long)a->matches[i], 100.0 * (double)a->matches[i] / (double)a->frames);
+        }
+    }
+}
+
+static void json_add_number(JsonNode* node, const char* key, double value, int decimals){
+    json_append_member(node, key, json_mknumber(value, decimals));
+}
+
+static int analyze_print_json(const analyze_t* a){
+
+    cluster_t clusters[MAX_CLUSTERS];
+    int       n_clusters = analyze_clusters(a, clusters);
+    JsonNode* root       = json_mkobject();
+    JsonNode* array;
+    JsonNode* item;
+
+    json_add_number(root, "pulses", (double)a->pulses, 0);
+    json_add_number(root, "frames", (double)a->frames, 0);
+    json_add_number(root, "pulse_min", a->pulses ? a->pulse_min : 0, 0);
+    json_add_number(root, "pulse_max", a->pulse_max, 0);
+    json_add_number(root, "bucket", a->bucket, 0);
+    json_add_number(root, "gap", a->gap, 0);
+
+    array = json_mkarray();
+    for (size_t b = 0; b < a->n_buckets; b++){
+        if (a->hist_count[b] > 0){
+            item = json_mkobject();
+            json_add_number(item, "from", (double)(b * a->bucket), 0);
+            json_add_number(item, "count", (double)a->hist_count[b], 0);
+            json_append_element(array, item);
+        }
+    }
+    json_append_member(root, "histogram", array);
+
+    array = json_mkarray();
+    for (int i = 0; i < n_clusters; i++){
+        item = json_mkobject();
+        json_add_number(item, "center", cluster_center(&clusters[i]), 1);
+        json_add_number(item, "jitter", cluster_jitter(&clusters[i]), 1);
+        json_add_number(item, "min", clusters[i].min, 0);
+        json_add_number(item, "max", clusters[i].max, 0);
+        json_add_number(item, "count", (double)clusters[i].count, 0);
+        json_append_element(array, item);
+    }
+    json_append_member(root, "clusters", array);
+
+    item = json_mkobject();
+    json_add_number(item, "count", (double)a->gaps, 0);
+    json_add_number(item, "min", a->gaps ? a->gap_min : 0, 0);
+    json_add_number(item, "max", a->gap_max, 0);
+    json_add_number(item, "mean", a->gaps ? a->gap_sum / (double)a->gaps : 0, 1);
+    array = json_mkarray();
+    for (size_t b = 0; b <= GAP_BUCKETS; b++){
+        if (a->gap_hist[b] > 0){
+            JsonNode* bucket = json_mkobject();
+            json_add_number(bucket, "from", (double)(b * GAP_BUCKET), 0);
+            json_add_number(bucket, "count", (double)a->gap_hist[b], 0);
+            json_append_element(array, bucket);
+        }
+    }
+    json_append_member(item, "histogram", array);
+    json_append_member(root, "gaps", item);
+
+    array = json_mkarray();
+    for (size_t l = 0; l <= MAX_FRAME_LENGTH; l++){
+        if (a->frame_hist[l] > 0){
+            item = json_mkobject();
+            json_add_number(item, "length", (double)l, 0);
+            json_add_number(item, "count", (double)a->frame_hist[l], 0);
+            json_append_element(array, item);
+        }
+    }
+    json_append_member(root, "frame_lengths", array);
+
+    array = json_mkarray();
+    for (size_t i = 0; i < a->n_protocols; i++){
+        if (a->matches[i] > 0){
+            item = json_mkobject();
+            json_append_member(item, "protocol", json_mkstring(a->protocols[i]->id));
+            json_add_number(item, "frames", (double)a->matches[i], 0);
+            json_append_element(array, item);
+        }
+    }
+    json_append_member(root, "candidates", array);
+
+    char* json = json_stringify(root, "  ");
+    json_delete(root);
+
+    if (json != NULL){
+        printf("%s\n", json);
+        free(json);
+        return 0;
+    }
+    return -1;
+}
+
+int analyze_cmd(int argc, char** argv){
+
+    char*     input      = NULL;
+    uint32_t  bucket     = DEFAULT_BUCKET;
+    uint32_t  gap        = DEFAULT_GAP;
+    bool      show_json  = false;
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    if (argc > 1){
+        while ((ch = getopt_long(argc, argv, "i:b:g:jh", list_options, NULL)) != -1) {
+
+            switch (ch) {
+                case 'i':
+                    if (input == NULL){
+                        input = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one input file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'b':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_PULSE_LENGTH)){
+                        bucket = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: bucket must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                        error_flag--;
+                    }
+                    break;
+                case 'g':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_PULSE_LENGTH)){
+                        gap = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: gap must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                        error_flag--;
+                    }
+                    break;
+                case 'j':
+                    show_json = true;
+                    break;
+                case 'h':
+                    help_flag = true;
+                    break;
+                case 1:
+                    /*
+                    * Use this case if getopt_long() should go through all
+                    * arguments. If so, add a leading '-' character to optstring.
+                    * Actual code, if any, goes here.
+                    */
+                    break;
+                case ':':   /* missing option argument */
+                    //fprintf(stderr, "error: option '-%c' requires an argument\n", optopt);
+                    error_flag--;
+                    break;
+                case '?':
+                default:    /* invalid option */
+                    //fprintf(stderr, "error: option '-%c' is invalid\n", optopt);
+                    error_flag--;
+                    break;
+            }
+        }
+
+        if (optind < argc) {
+            fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+            while (optind < argc){
+                fprintf(stderr," %s", argv[optind++]);
+                error_flag--;
+            }
+            fprintf(stderr,"\n");
+        }
+
+        if (help_flag){
+            printf("command:\n");
+            analyze_help(stdout);
+        }else{
+
+            if (input == NULL){
+                fprintf(stderr,"error: -i capture is required\n");
+                error_flag--;
+            }
+
+            if (error_flag == 0){
+
+                analyze_t analyze;
+
+                if (analyze_init(&analyze, bucket, gap)){
+
+                    FILE* in = strcmp(input, "-") == 0 ? stdin : fopen(input, "rb");
+
+                    if (in != NULL){
+                        stats_phase(STATS_CODEC);
+                        if (input_read_pulses(in, MAX_PULSE_LENGTH, analyze_block, &analyze) == 0){
+                            stats_phase(STATS_OUTPUT);
+                            if (show_json){
+                                error_flag = analyze_print_json(&analyze);
+                            }else{
+                                analyze_print(&analyze);
+                            }
+                        }else{
+                            fprintf(stderr,"error: reading '%s'\n",input);
+                            error_flag--;
+                        }
+                        if (in != stdin){
+                            fclose(in);
+                        }
+                    }else{
+                        fprintf(stderr,"error: unable to open '%s'\n",input);
+                        error_flag--;
+                    }
+                }else{
+                    fprintf(stderr,"error: malloc fail!\n");
+                    error_flag--;
+                }
+                analyze_free(&analyze);
+            }
+        }
+    }else{
+        fprintf(stderr,"error: -i capture is required\n");
+        error_flag--;
+    }
+
+    return error_flag;
+}
@@ -0,0 +1,500 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-bench.h"
+#include "picoder-sample.h"
+#include "picoder-noise.h"
+#include "picoder-frame.h"
+#include "picoder-match.h"
+#include "picoder-stats.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef MAX_PULSES
+#define MAX_PULSES    255
+#endif
+
+#ifndef MAX_BENCH_REPEATS
+#define MAX_BENCH_REPEATS    1000
+#endif
+
+#define DEFAULT_BENCH_LEVELS     6
+#define DEFAULT_BENCH_REPEATS   20
+#define DEFAULT_BENCH_TOP        5
+
+/* Sample frame and its decode without noise */
+typedef struct {
+    size_t   offset;
+    int      count;
+    int      protocol;
+    char*    expected;
+} bench_frame_t;
+
+typedef struct {
+    protocol_t*    protocol;
+    size_t         first;           /* frames of protocol are contiguous */
+    size_t         count;
+    double         cpu[MAX_BENCH_LEVELS];       /* secs */
+    unsigned long  decoded[MAX_BENCH_LEVELS];
+} bench_protocol_t;
+
+typedef struct {
+    uint32_t*          pulses;
+    size_t             n_pulses;
+    size_t             size;
+    bench_frame_t*     frames;
+    size_t             n_frames;
+    size_t             frames_size;
+    bench_protocol_t*  protocols;
+    int                n_protocols;
+    match_set_t        match;           /* prefilter, NULL descs if disabled */
+    unsigned long      lost;            /* frames the prefilter rejected and a parser decodes */
+    bool               failed;
+} bench_t;
+
+static struct option list_options[] = {
+  { "proto",      required_argument, NULL,      'p' },
+  { "levels",     required_argument, NULL,      'l' },
+  { "noise",      required_argument, NULL,      'N' },
+  { "repeats",    required_argument, NULL,      'n' },
+  { "seed",       required_argument, NULL,      'S' },
+  { "top",        required_argument, NULL,      'k' },
+  { "glitch",     required_argument, NULL,      'G' },
+  { "snap",       no_argument,       NULL,      'Z' },
+  { "prefilter",  no_argument,       NULL,      'P' },
+  { "help",       no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void bench_help(FILE* out){
+    fprintf(out,"         bench [-h] [-p protocol] [-l levels]         --> decode sample codes under increasing noise\n");
+    fprintf(out,"               [-h | --help]                          --> show command options\n");
+    fprintf(out,"               [-p | --proto protocol]                --> bench one protocol (default every encodable)\n");
+    fprintf(out,"               [-l | --levels levels]                 --> noise levels from 0 to 1 (default %d, max %d)\n", DEFAULT_BENCH_LEVELS, MAX_BENCH_LEVELS);
+    fprintf(out,"               [-N | --noise profile]                 --> noise at level 1, 'jitter=0.2,drop=0.02,...'\n");
+    fprintf(out,"               [-n | --repeats repeats]               --> perturbed copies of every sample (default %d)\n", DEFAULT_BENCH_REPEATS);
+    fprintf(out,"               [-S | --seed seed]                     --> set noise seed (default 1)\n");
+    fprintf(out,"               [-k | --top number]                    --> show slowest protocols at last level (default %d)\n", DEFAULT_BENCH_TOP);
+    fprintf(out,"               [-G | --glitch uSecs]                  --> merge shorter pulses before decode, as decode -G\n");
+    fprintf(out,"               [-Z | --snap]                          --> snap pulses to cluster centers before decode, as decode -Z\n");
+    fprintf(out,"               [-P | --prefilter]                     --> skip frames no match descriptor accepts, as decode -P, fails if a parser decodes one\n");
+}
+
+static void bench_add(void* ctx, protocol_t* protocol, const char* json, const uint32_t* pulses, int n_pulses){
+
+    bench_t* bench = (bench_t*)ctx;
+
+    if (bench->failed || n_pulses <= 0 || n_pulses > MAX_PULSES){
+        return;
+    }
+    if (bench->n_pulses + (size_t)n_pulses > bench->size){
+        size_t    size  = bench->size ? bench->size * 2 : 65536;
+        uint32_t* grown = (uint32_t*)realloc(bench->pulses, sizeof(*grown) * size);
+        if (grown == NULL){
+            bench->failed = true;
+            return;
+        }
+        bench->pulses = grown;
+        bench->size   = size;
+    }
+    if (bench->n_frames == bench->frames_size){
+        size_t         size  = bench->frames_size ? bench->frames_size * 2 : 1024;
+        bench_frame_t* grown = (bench_frame_t*)realloc(bench->frames, sizeof(*grown) * size);
+        if (grown == NULL){
+            bench->failed = true;
+            return;
+        }
+        bench->frames      = grown;
+        bench->frames_size = size;
+    }
+
+    bench_frame_t* frame = &bench->frames[bench->n_frames++];
+
+    memcpy(bench->pulses + bench->n_pulses, pulses, sizeof(*pulses) * (size_t)n_pulses);
+    frame->offset   = bench->n_pulses;
+    frame->count    = n_pulses;
+    frame->protocol = bench->n_protocols - 1;
+    frame->expected = decodePulseTrain(bench->pulses + bench->n_pulses, (uint8_t)n_pulses, NULL);
+
+    bench->n_pulses += (size_t)n_pulses;
+    bench->protocols[frame->protocol].count++;
+}
+
+/* Encode sample codes of protocol, or every encodable one if NULL */
+static bool bench_load(bench_t* bench, protocol_t* only){
+
+    uint16_t  max_pulses = protocol_maxrawlen();
+    uint32_t* pulses     = (uint32_t*)malloc(sizeof(*pulses) * (max_pulses + 1));
+    int       count      = 0;
+
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL; pnode = pnode->next){
+        count++;
+    }
+    bench->protocols = (bench_protocol_t*)calloc((size_t)count, sizeof(*bench->protocols));
+
+    if (pulses == NULL || bench->protocols == NULL){
+        free(pulses);
+        return false;
+    }
+
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL && !bench->failed; pnode = pnode->next){
+        if ((only != NULL && pnode->listener != only) || pnode->listener->createCode == NULL){
+            continue;
+        }
+        bench_protocol_t* protocol = &bench->protocols[bench->n_protocols++];
+        protocol->protocol = pnode->listener;
+        protocol->first    = bench->n_frames;
+        sample_codes(pnode->listener, pulses, max_pulses, bench_add, bench);
+        if (protocol->count == 0){
+            bench->n_protocols--;
+        }
+    }
+    free(pulses);
+
+    return !bench->failed;
+}
+
+static void bench_free(bench_t* bench){
+    for (size_t i = 0; i < bench->n_frames; i++){
+        free(bench->frames[i].expected);
+    }
+    free(bench->frames);
+    free(bench->pulses);
+    free(bench->protocols);
+    match_set_free(&bench->match);
+}
+
+/*
+    Perturb repeats copies of every sample of protocol, then decode them all
+    timed as a block so clock resolution and noise generation are out of the
+    per frame cpu, filter and prefilter included. Returns number of exact decodes.
+*/
+static unsigned long bench_protocol(bench_t* bench, bench_protocol_t* protocol, int level, noise_t* noise, int repeats, const frame_filter_t* filter, uint32_t* work, int* counts){
+
+    size_t        n_work = 0;
+    unsigned long exact  = 0;
+
+    for (size_t f = protocol->first; f < protocol->first + protocol->count; f++){
+        const bench_frame_t* frame = &bench->frames[f];
+        for (int r = 0; r < repeats; r++){
+            counts[n_work] = noise_apply(noise, bench->pulses + frame->offset, frame->count, work + n_work * MAX_PULSES, MAX_PULSES);
+            n_work++;
+        }
+    }
+
+    size_t  n_frames = n_work;
+    clock_t start    = clock();
+
+    for (size_t w = 0; w < n_frames; w++){
+
+        const bench_frame_t* frame    = &bench->frames[protocol->first + w / (size_t)repeats];
+        uint32_t*            pulses   = work + w * MAX_PULSES;
+        int                  n_pulses = counts[w];
+
+        frame_view_t         view;
+
+        view.n_clusters = 0;
+        if (filter->glitch > 0 || filter->snap){
+            n_pulses = frame_filter(filter, pulses, n_pulses, &view);
+        }
+        if (bench->match.descs != NULL){
+            if (view.n_clusters == 0 && bench->match.views){
+                frame_view_build(&view, pulses, n_pulses);
+            }
+            if (!match_any(&bench->match, &view, pulses, n_pulses)){
+                counts[w] = -n_pulses;      /* rejected, checked after timing */
+                continue;
+            }
+        }
+
+        char* json = decodePulseTrain(pulses, (uint8_t)n_pulses, NULL);
+
+        if (json != NULL){
+            if (strcmp(json, "[]") != 0){
+                protocol->decoded[level]++;
+            }
+            if (frame->expected != NULL && strcmp(json, frame->expected) == 0){
+                exact++;
+            }
+            free(json);
+        }
+    }
+    protocol->cpu[level] = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* Prefilter must never reject a frame the parsers decode */
+    for (size_t w = 0; w < n_frames; w++){
+        if (counts[w] < 0){
+            char* json = decodePulseTrain(work + w * MAX_PULSES, (uint8_t)-counts[w], NULL);
+            if (json != NULL && strcmp(json, "[]") != 0){
+                bench->lost++;
+            }
+            free(json);
+        }
+    }
+
+    return exact;
+}
+
+/* FNV-1a of protocol name */
+static uint64_t bench_hash(const char* name){
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    while (*name != '\0'){
+        hash = (hash ^ (uint8_t)*name++) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static int bench_run(bench_t* bench, const noise_profile_t* profile, int levels, int repeats, unsigned long seed, int top, const frame_filter_t* filter){
+
+    size_t max_count = 0;
+    for (int p = 0; p < bench->n_protocols; p++){
+        if (bench->protocols[p].count > max_count){
+            max_count = bench->protocols[p].count;
+        }
+    }
+
+    size_t    n_work = max_count * (size_t)repeats;
+    uint32_t* work   = (uint32_t*)malloc(sizeof(*work) * MAX_PULSES * n_work);
+    int*      counts = (int*)malloc(sizeof(*counts) * n_work);
+
+    if (work == NULL || counts == NULL){
+        fprintf(stderr,"error: malloc(%lu) fail!\n", (unsigned long)(sizeof(*work) * MAX_PULSES * n_work));
+        free(work);
+        free(counts);
+        return -1;
+    }
+
+    printf("bench: %lu samples of %d protocols, %d repeats, seed %lu\n", (unsigned long)bench->n_frames, bench->n_protocols, repeats, seed);
+    printf("level  jitter   drop  split glitch  trunc   frames  decoded    exact  usec/frame  x clean\n");
+
+    double clean = 0;
+
+    for (int level = 0; level < levels; level++){
+
+        double          value = (levels > 1) ? (double)level / (levels - 1) : 1.0;
+        noise_profile_t scaled;
+        noise_t         noise;
+        unsigned long   frames  = 0;
+        unsigned long   decoded = 0;
+        unsigned long   exact   = 0;
+        double          cpu     = 0;
+
+        noise_profile_scale(profile, value, &scaled);
+
+        for (int p = 0; p < bench->n_protocols; p++){
+            bench_protocol_t* protocol = &bench->protocols[p];
+
+            /* Seed per protocol and level, results do not depend on protocol set */
+            noise_seed(&noise, &scaled, seed + bench_hash(protocol->protocol->id) + (uint64_t)level * 0x9E3779B97F4A7C15ULL);
+
+            exact   += bench_protocol(bench, protocol, level, &noise, repeats, filter, work, counts);
+            frames  += (unsigned long)(protocol->count * (size_t)repeats);
+            decoded += protocol->decoded[level];
+            cpu     += protocol->cpu[level];
+        }
+
+        double usec = frames ? cpu * 1e6 / frames : 0;
+        if (level == 0){
+            clean = usec;
+        }
+
+        printf("%5.2f  %6.3f %6.3f %6.3f %6.3f %6.3f %8lu  %6.1f%%  %6.1f%%  %10.2f  %7.2f\n",
+               value, scaled.jitter, scaled.drop, scaled.split, scaled.glitch, scaled.truncate,
+               frames, frames ? 100.0 * decoded / frames : 0, frames ? 100.0 * exact / frames : 0,
+               usec, clean > 0 ? usec / clean : 0);
+        fflush(stdout);
+    }
+
+    if (bench->match.descs != NULL){
+        printf("prefilter: %llu accepted, %llu rejected (%.1f%% parsers skipped), %lu decodable rejected\n",
+               (unsigned long long)bench->match.accepted, (unsigned long long)bench->match.rejected,
+               100.0 * (double)bench->match.rejected / (double)(bench->match.accepted + bench->match.rejected), bench->lost);
+    }
+
+    /* Protocols whose noisy frames cost most cpu, relative to their clean frames */
+    if (top > 0 && levels > 1 && bench->n_protocols > 1){
+
+        int last = levels - 1;
+
+        printf("slowest protocols at level 1.00:\n");
+        printf("protocol                        usec/frame  x clean  decoded\n");
+
+        for (int shown = 0; shown < top && shown < bench->n_protocols; shown++){
+
+            /* Selection of next slowest, n_protocols is small */
+            int    best = -1;
+            double best_usec = -1;
+            for (int p = 0; p < bench->n_protocols; p++){
+                bench_protocol_t* protocol = &bench->protocols[p];
+                double usec = protocol->cpu[last] * 1e6 / (double)(protocol->count * (size_t)repeats);
+                if (protocol->cpu[last] >= 0 && usec > best_usec){
+                    best      = p;
+                    best_usec = usec;
+                }
+            }
+
+            bench_protocol_t* protocol = &bench->protocols[best];
+            double frames = (double)(protocol->count * (size_t)repeats);
+            double base   = protocol->cpu[0] * 1e6 / frames;
+
+            printf("%-30s  %10.2f  %7.2f  %6.1f%%\n", protocol->protocol->id, best_usec,
+                   base > 0 ? best_usec / base : 0, 100.0 * protocol->decoded[last] / frames);
+
+            protocol->cpu[last] = -1;
+        }
+    }
+
+    free(work);
+    free(counts);
+
+    if (bench->lost > 0){
+        fprintf(stderr,"error: prefilter rejected %lu frames the parsers decode\n", bench->lost);
+        return -1;
+    }
+    return 0;
+}
+
+int bench_cmd(int argc, char** argv){
+
+    protocol_t*     protocol  = NULL;
+    const char*     spec      = DEFAULT_NOISE_PROFILE;
+    int             levels    = DEFAULT_BENCH_LEVELS;
+    int             repeats   = DEFAULT_BENCH_REPEATS;
+    unsigned long   seed      = 1;
+    int             top       = DEFAULT_BENCH_TOP;
+    noise_profile_t profile;
+    frame_filter_t  filter    = { 0, false };
+    bool            prefilter = false;
+    bench_t         bench;
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    memset(&bench, 0, sizeof(bench));
+
+    while ((ch = getopt_long(argc, argv, "p:l:N:n:S:k:G:ZPh", list_options, NULL)) != -1) {
+
+        switch (ch) {
+            case 'p':
+                if (protocol == NULL){
+                    protocol = findProtocol(optarg);
+                    if (protocol == NULL){
+                        fprintf(stderr, "error: protocol '%s' invalid\n", optarg);
+                        error_flag--;
+                    }else if (protocol->createCode == NULL){
+                        fprintf(stderr, "error: protocol '%s' no encode support\n", optarg);
+                        error_flag--;
+                    }
+                }else{
+                    fprintf(stderr,"error: only one protocol is allowed\n");
+                    error_flag--;
+                }
+                break;
+            case 'l':
+                if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_BENCH_LEVELS)){
+                    levels = atoi(optarg);
+                }else{
+                    fprintf(stderr,"error: levels must be > 0 and <= %d\n",MAX_BENCH_LEVELS);
+                    error_flag--;
+                }
+                break;
+            case 'N':
+                spec = optarg;
+                break;
+            case 'n':
+                if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_BENCH_REPEATS)){
+                    repeats = atoi(optarg);
+                }else{
+                    fprintf(stderr,"error: repeats must be > 0 and <= %d\n",MAX_BENCH_REPEATS);
+                    error_flag--;
+                }
+                break;
+            case 'S':
+                seed = strtoul(optarg, NULL, 0);
+                break;
+            case 'k':
+                if (atoi(optarg) >= 0){
+                    top = atoi(optarg);
+                }else{
+                    fprintf(stderr,"error: top must be >= 0\n");
+                    error_flag--;
+                }
+                break;
+            case 'G':
+                if (atol(optarg) > 0){
+                    filter.glitch = (uint32_t)atol(optarg);
+                }else{
+                    fprintf(stderr,"error: glitch must be > 0\n");
+                    error_flag--;
+                }
+                break;
+            case 'Z':
+                filter.snap = true;
+                break;
+            case 'P':
+                prefilter = true;
+                break;
+            case 'h':
+                help_flag = true;
+                break;
+            case ':':   /* missing option argument */
+                error_flag--;
+                break;
+            case '?':
+            default:    /* invalid option */
+                error_flag--;
+                break;
+        }
+    }
+
+    if (optind < argc) {
+        fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+        while (optind < argc){
+            fprintf(stderr," %s", argv[optind++]);
+            error_flag--;
+        }
+        fprintf(stderr,"\n");
+    }
+
+    if (!noise_profile_parse(spec, &profile)){
+        fprintf(stderr,"error: noise profile '%s' invalid\n",spec);
+        error_flag--;
+    }
+
+    if (help_flag){
+        printf("command:\n");
+        bench_help(stdout);
+
+    }else if (error_flag == 0){
+
+        stats_phase(STATS_CODEC);
+
+        if (!bench_load(&bench, protocol)){
+            fprintf(stderr,"error: unable to encode sample codes\n");
+            error_flag--;
+        }else if (prefilter && !match_set_build(&bench.match)){
+            fprintf(stderr,"error: malloc fail!\n");
+            error_flag--;
+        }else if (bench.n_frames == 0){
+            fprintf(stderr,"error: no sample codes encoded\n");
+            error_flag--;
+        }else{
+            error_flag = bench_run(&bench, &profile, levels, repeats, seed, top, &filter);
+        }
+
+        stats_phase(STATS_OUTPUT);
+    }
+    bench_free(&bench);
+
+    return error_flag;
+}
@@ -0,0 +1,23 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_BENCH_H
+#define PICODER_BENCH_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#ifndef MAX_BENCH_LEVELS
+#define MAX_BENCH_LEVELS    64
+#endif
+
+void bench_help(FILE* out);
+
+int bench_cmd(int argc, char** argv);
+
+#endif
@@ -0,0 +1,666 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-codebook.h"
+#include "picoder-sample.h"
+#include "picoder-stats.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifndef MAX_PULSES
+#define MAX_PULSES    255
+#endif
+
+#ifndef MAX_CODEBOOK_THREADS
+#define MAX_CODEBOOK_THREADS   64
+#endif
+
+#ifndef MAX_CODEBOOK_CODES
+#define MAX_CODEBOOK_CODES  (1ULL << 28)    /* 2 GB of index */
+#endif
+
+#define CODEBOOK_BATCH      65536   /* combinations encoded between file writes */
+#define CODEBOOK_JSON         512
+
+typedef struct {
+    char*     name;
+    uint32_t  first;
+    uint32_t  last;
+} codebook_range_t;
+
+typedef struct {
+    protocol_t*       protocol;
+    const char*       fixed;        /* fixed json members, without braces */
+    size_t            fixed_len;
+    int               n_ranges;
+    codebook_range_t  ranges[MAX_CODEBOOK_RANGES];
+    int               n_states;
+    char*             states[MAX_CODEBOOK_STATES];
+    uint64_t          count;
+    uint16_t          max_pulses;
+    bool              decoded;      /* store decoded json of every code */
+
+    /* Current batch */
+    uint64_t          first;
+    size_t            n_batch;
+    char**            codes;
+    char**            jsons;
+    size_t            next;
+#ifndef _WIN32
+    pthread_mutex_t   next_lock;    /* also guards the pool state below */
+    pthread_mutex_t   encode_lock;
+
+    /* Worker pool started once per run */
+    pthread_cond_t    batch_ready;  /* new batch or stop */
+    pthread_cond_t    batch_done;   /* last worker finished the batch */
+    unsigned          batch;        /* batch number, workers wait for a new one */
+    int               busy;         /* pool workers on current batch */
+    bool              stop;
+#endif
+} codebook_t;
+
+static struct option list_options[] = {
+  { "proto",      required_argument, NULL,      'p' },
+  { "range",      required_argument, NULL,      'R' },
+  { "json",       required_argument, NULL,      'j' },
+  { "states",     no_argument,       NULL,      's' },
+  { "decoded",    no_argument,       NULL,      'd' },
+  { "output",     required_argument, NULL,      'o' },
+  { "threads",    required_argument, NULL,      'n' },
+  { "help",       no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void codebook_help(FILE* out){
+    fprintf(out,"         codebook [-h] -p protocol -R range -o file   --> generate every code of protocol ranges\n");
+    fprintf(out,"                  [-h | --help]                       --> show command options\n");
+    fprintf(out,"                  [-p | --proto protocol]             --> set protocol to encode\n");
+    fprintf(out,"                  [-R | --range option=first..last]   --> add option values range, up to %d\n", MAX_CODEBOOK_RANGES);
+    fprintf(out,"                  [-j | --json json-data]             --> set fixed json data of every code\n");
+    fprintf(out,"                  [-s | --states]                     --> enumerate every state option\n");
+    fprintf(out,"                  [-d | --decoded]                    --> store decoded json for decode lookup table\n");
+    fprintf(out,"                  [-o | --output file]                --> set codebook output file\n");
+    fprintf(out,"                  [-n | --threads threads]            --> set worker threads (default cpus), PiCode encodes one at a time\n");
+}
+
+/* Check protocol option name, returns option id or NULL */
+static char* option_by_name(protocol_t* protocol, const char* name, int* argtype, int* conftype){
+
+    int   option_index = 0;
+    char* option_id    = NULL;
+    char* option_name  = NULL;
+
+    while (options_list(protocol->options, option_index++, &option_id) == 0){
+        option_name = NULL;
+        options_get_name_by_id(protocol->options, option_id, &option_name);
+        if (option_name != NULL && strcmp(option_name, name) == 0){
+            options_get_argtype(protocol->options, option_id, 0, argtype);
+            options_get_conftype(protocol->options, option_id, 0, conftype);
+            return option_id;
+        }
+    }
+    return NULL;
+}
+
+/* Decimal uint32_t from start to end, no sign or spaces */
+static bool parse_u32(const char* start, const char* end, uint32_t* value){
+
+    char*              stop = NULL;
+    unsigned long long n;
+
+    if (start == end || *start < '0' || *start > '9'){
+        return false;
+    }
+    errno = 0;
+    n     = strtoull(start, &stop, 10);
+    if (stop != end || errno == ERANGE || n > UINT32_MAX){
+        return false;
+    }
+    *value = (uint32_t)n;
+    return true;
+}
+
+/* Parse "option=first..last", arg is left as is if invalid */
+static bool parse_range(char* arg, codebook_range_t* range){
+
+    char*    eq   = strchr(arg, '=');
+    char*    dots = eq ? strstr(eq, "..") : NULL;
+    uint32_t first;
+    uint32_t last;
+
+    if (eq == NULL || dots == NULL || eq == arg){
+        return false;
+    }
+    if (!parse_u32(eq + 1, dots, &first) || !parse_u32(dots + 2, dots + 2 + strlen(dots + 2), &last) || first > last){
+        return false;
+    }
+    *eq = '\0';
+    range->name  = arg;
+    range->first = first;
+    range->last  = last;
+
+    return true;
+}
+
+static void write_u16(FILE* out, uint16_t value){
+    uint8_t b[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+    fwrite(b, 1, 2, out);
+}
+
+static void write_u32(FILE* out, uint32_t value){
+    write_u16(out, (uint16_t)value);
+    write_u16(out, (uint16_t)(value >> 16));
+}
+
+static void write_u64(FILE* out, uint64_t value){
+    write_u32(out, (uint32_t)value);
+    write_u32(out, (uint32_t)(value >> 32));
+}
+
+static void write_string(FILE* out, const char* str, size_t len){
+    write_u16(out, (uint16_t)len);
+    fwrite(str, 1, len, out);
+}
+
+/* Json of combination 'code', mixed radix with last range fastest */
+static bool codebook_json(const codebook_t* cb, uint64_t code, char* json){
+
+    uint64_t values[MAX_CODEBOOK_RANGES];
+    size_t   len = 0;
+
+    for (int r = cb->n_ranges - 1; r >= 0; r--){
+        uint64_t radix = (uint64_t)cb->ranges[r].last - cb->ranges[r].first + 1;
+        values[r] = cb->ranges[r].first + code % radix;
+        code /= radix;
+    }
+
+    json[len++] = '{';
+    for (int r = 0; r < cb->n_ranges && len < CODEBOOK_JSON; r++){
+        len += (size_t)snprintf(json + len, CODEBOOK_JSON - len, "%s\"%s\":%llu", r ? "," : "", cb->ranges[r].name, (unsigned long long)values[r]);
+    }
+    if (cb->n_states > 0 && len < CODEBOOK_JSON){
+        len += (size_t)snprintf(json + len, CODEBOOK_JSON - len, ",\"%s\":1", cb->states[code]);
+    }
+    if (cb->fixed_len > 0 && len < CODEBOOK_JSON){
+        len += (size_t)snprintf(json + len, CODEBOOK_JSON - len, ",%.*s", (int)cb->fixed_len, cb->fixed);
+    }
+    if (len >= CODEBOOK_JSON - 1){
+        return false;
+    }
+    json[len++] = '}';
+    json[len]   = '\0';
+    return true;
+}
+
+/*
+    Encode combinations of current batch. pilight protocols keep the encoded
+    pulses in protocol globals, encodeToPulseTrain() runs one at a time while
+    json build and pulseTrainToString() run in parallel.
+*/
+static void codebook_worker(codebook_t* cb, uint32_t* pulses){
+
+    char json[CODEBOOK_JSON];
+
+    for (;;){
+
+        size_t i;
+#ifndef _WIN32
+        pthread_mutex_lock(&cb->next_lock);
+#endif
+        i = cb->next++;
+#ifndef _WIN32
+        pthread_mutex_unlock(&cb->next_lock);
+#endif
+        if (i >= cb->n_batch){
+            break;
+        }
+
+        int n_pulses = -1;
+        if (codebook_json(cb, cb->first + i, json)){
+#ifndef _WIN32
+            pthread_mutex_lock(&cb->encode_lock);
+#endif
+            n_pulses = encodeToPulseTrain(pulses, cb->max_pulses, cb->protocol, json);
+#ifndef _WIN32
+            pthread_mutex_unlock(&cb->encode_lock);
+#endif
+        }
+        cb->codes[i] = (n_pulses > 0) ? pulseTrainToString(pulses, (uint16_t)n_pulses, 0) : NULL;
+
+        /* Decoders also keep state in protocol globals */
+        if (cb->decoded && cb->codes[i] != NULL && n_pulses <= MAX_PULSES){
+#ifndef _WIN32
+            pthread_mutex_lock(&cb->encode_lock);
+#endif
+            cb->jsons[i] = decodePulseTrain(pulses, (uint8_t)n_pulses, NULL);
+#ifndef _WIN32
+            pthread_mutex_unlock(&cb->encode_lock);
+#endif
+        }
+    }
+}
+
+#ifndef _WIN32
+/* Pool worker, encodes its share of every batch until stop */
+static void* codebook_thread(void* arg){
+
+    codebook_t* cb     = (codebook_t*)arg;
+    uint32_t*   pulses = (uint32_t*)malloc(sizeof(*pulses) * (cb->max_pulses + 1));
+    unsigned    batch  = 0;
+
+    pthread_mutex_lock(&cb->next_lock);
+    for (;;){
+        while (cb->batch == batch && !cb->stop){
+            pthread_cond_wait(&cb->batch_ready, &cb->next_lock);
+        }
+        if (cb->stop){
+            break;
+        }
+        batch = cb->batch;
+        pthread_mutex_unlock(&cb->next_lock);
+
+        if (pulses != NULL){
+            codebook_worker(cb, pulses);
+        }
+
+        pthread_mutex_lock(&cb->next_lock);
+        if (--cb->busy == 0){
+            pthread_cond_signal(&cb->batch_done);
+        }
+    }
+    pthread_mutex_unlock(&cb->next_lock);
+
+    free(pulses);
+    return NULL;
+}
+#endif
+
+/* Wake pool workers on current batch, work it too and wait for them */
+static void codebook_run_batch(codebook_t* cb, int n_workers, uint32_t* pulses){
+
+#ifndef _WIN32
+    pthread_mutex_lock(&cb->next_lock);
+    cb->next = 0;
+    cb->busy = n_workers;
+    cb->batch++;
+    pthread_cond_broadcast(&cb->batch_ready);
+    pthread_mutex_unlock(&cb->next_lock);
+
+    codebook_worker(cb, pulses);
+
+    pthread_mutex_lock(&cb->next_lock);
+    while (cb->busy > 0){
+        pthread_cond_wait(&cb->batch_done, &cb->next_lock);
+    }
+    pthread_mutex_unlock(&cb->next_lock);
+#else
+    (void)n_workers;
+    cb->next = 0;
+    codebook_worker(cb, pulses);
+#endif
+}
+
+static int codebook_write(codebook_t* cb, FILE* out, int n_threads, uint64_t* failed){
+
+    uint64_t* index = cb->count <= SIZE_MAX / sizeof(uint64_t) ? (uint64_t*)malloc(sizeof(*index) * (size_t)cb->count) : NULL;
+    uint32_t* pulses = (uint32_t*)malloc(sizeof(*pulses) * (cb->max_pulses + 1));
+    uint64_t  offset;
+    int       n_workers = 0;
+
+    cb->codes = (char**)calloc(CODEBOOK_BATCH, sizeof(*cb->codes));
+    cb->jsons = (char**)calloc(CODEBOOK_BATCH, sizeof(*cb->jsons));
+
+    if (index == NULL || pulses == NULL || cb->codes == NULL || cb->jsons == NULL){
+        free(index);
+        free(pulses);
+        free(cb->codes);
+        free(cb->jsons);
+        fprintf(stderr,"error: malloc fail!\n");
+        return -1;
+    }
+
+#ifndef _WIN32
+    pthread_t threads[MAX_CODEBOOK_THREADS];
+
+    cb->batch = 0;
+    cb->stop  = false;
+    for (int t = 1; t < n_threads; t++){
+        if (pthread_create(&threads[n_workers], NULL, codebook_thread, cb) == 0){
+            n_workers++;
+        }
+    }
+#else
+    (void)n_threads;
+#endif
+
+    /* Header, index offset patched at end */
+    fwrite(CODEBOOK_MAGIC, 1, 4, out);
+    write_u16(out, CODEBOOK_VERSION);
+    write_u16(out, (uint16_t)cb->n_ranges);
+    write_u16(out, (uint16_t)cb->n_states);
+    write_u16(out, cb->decoded ? CODEBOOK_FLAG_DECODED : 0);
+    write_u64(out, cb->count);
+    write_u64(out, 0);
+    write_string(out, cb->protocol->id, strlen(cb->protocol->id));
+    write_string(out, cb->fixed ? cb->fixed : "", cb->fixed_len);
+    for (int r = 0; r < cb->n_ranges; r++){
+        write_string(out, cb->ranges[r].name, strlen(cb->ranges[r].name));
+        write_u32(out, cb->ranges[r].first);
+        write_u32(out, cb->ranges[r].last);
+    }
+    for (int s = 0; s < cb->n_states; s++){
+        write_string(out, cb->states[s], strlen(cb->states[s]));
+    }
+
+    offset = (uint64_t)ftell(out);
+
+    for (cb->first = 0; cb->first < cb->count; cb->first += cb->n_batch){
+
+        cb->n_batch = (cb->count - cb->first) < CODEBOOK_BATCH ? (size_t)(cb->count - cb->first) : CODEBOOK_BATCH;
+
+        codebook_run_batch(cb, n_workers, pulses);
+
+        for (size_t i = 0; i < cb->n_batch; i++){
+            if (cb->codes[i] != NULL){
+                size_t len = strlen(cb->codes[i]);
+                index[cb->first + i] = offset;
+                write_string(out, cb->codes[i], len);
+                offset += 2 + len;
+                free(cb->codes[i]);
+                cb->codes[i] = NULL;
+                if (cb->decoded){
+                    /* Empty json if not decoded back */
+                    len = (cb->jsons[i] != NULL && cb->jsons[i][0] == '{') ? strlen(cb->jsons[i]) : 0;
+                    write_string(out, len ? cb->jsons[i] : "", len);
+                    offset += 2 + len;
+                    free(cb->jsons[i]);
+                    cb->jsons[i] = NULL;
+                }
+            }else{
+                index[cb->first + i] = 0;
+                (*failed)++;
+            }
+        }
+    }
+
+#ifndef _WIN32
+    pthread_mutex_lock(&cb->next_lock);
+    cb->stop = true;
+    pthread_cond_broadcast(&cb->batch_ready);
+    pthread_mutex_unlock(&cb->next_lock);
+    for (int t = 0; t < n_workers; t++){
+        pthread_join(threads[t], NULL);
+    }
+#endif
+
+    for (uint64_t i = 0; i < cb->count; i++){
+        write_u64(out, index[i]);
+    }
+
+    /* Patch index offset */
+    fseek(out, 20, SEEK_SET);
+    write_u64(out, offset);
+
+    free(index);
+    free(pulses);
+    free(cb->codes);
+    free(cb->jsons);
+
+    return ferror(out) ? -1 : 0;
+}
+
+int codebook_cmd(int argc, char** argv){
+
+    codebook_t  cb;
+    char*       output     = NULL;
+    bool        states     = false;
+    int         n_threads  = 1;
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    memset(&cb, 0, sizeof(cb));
+
+#ifndef _WIN32
+    n_threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_threads < 1) n_threads = 1;
+    if (n_threads > MAX_CODEBOOK_THREADS) n_threads = MAX_CODEBOOK_THREADS;
+#endif
+
+    if (argc > 1){
+        while ((ch = getopt_long(argc, argv, "p:R:j:sdo:n:h", list_options, NULL)) != -1) {
+
+            switch (ch) {
+                case 'p':
+                    if (cb.protocol == NULL){
+                        cb.protocol = findProtocol(optarg);
+                        if (cb.protocol == NULL){
+                            fprintf(stderr, "error: protocol '%s' invalid\n", optarg);
+                            error_flag--;
+                        }else if (cb.protocol->createCode == NULL){
+                            fprintf(stderr, "error: protocol '%s' no encode support\n", optarg);
+                            error_flag--;
+                        }
+                    }else{
+                        fprintf(stderr,"error: only one protocol is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'R':
+                    if (cb.n_ranges < MAX_CODEBOOK_RANGES){
+                        if (parse_range(optarg, &cb.ranges[cb.n_ranges])){
+                            cb.n_ranges++;
+                        }else{
+                            fprintf(stderr,"error: range '%s' invalid, must be option=first..last, decimal first <= last <= %lu\n",optarg,(unsigned long)UINT32_MAX);
+                            error_flag--;
+                        }
+                    }else{
+                        fprintf(stderr,"error: max %d ranges are allowed\n",MAX_CODEBOOK_RANGES);
+                        error_flag--;
+                    }
+                    break;
+                case 'j':
+                    if (cb.fixed == NULL){
+                        if (json_validate(optarg)){
+                            /* Keep members only to append to every code */
+                            char* first = strchr(optarg, '{');
+                            char* last  = strrchr(optarg, '}');
+                            if (first != NULL && last != NULL && last > first){
+                                first++;
+                                while (first < last && (*first == ' ' || *first == '\t' || *first == '\n')) first++;
+                                cb.fixed     = first;
+                                cb.fixed_len = (size_t)(last - first);
+                            }else{
+                                fprintf(stderr,"error: json '%s' must be an object\n",optarg);
+                                error_flag--;
+                            }
+                        }else{
+                            fprintf(stderr,"error: json '%s' invalid\n",optarg);
+                            error_flag--;
+                        }
+                    }else{
+                        fprintf(stderr,"error: only one json is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 's':
+                    states = true;
+                    break;
+                case 'd':
+                    cb.decoded = true;
+                    break;
+                case 'o':
+                    if (output == NULL){
+                        output = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one output file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'n':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_CODEBOOK_THREADS)){
+                        n_threads = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: threads must be > 0 and <= %d\n",MAX_CODEBOOK_THREADS);
+                        error_flag--;
+                    }
+                    break;
+                case 'h':
+                    help_flag = true;
+                    break;
+                case 1:
+                    /*
+                    * Use this case if getopt_long() should go through all
+                    * arguments. If so, add a leading '-' character to optstring.
+                    * Actual code, if any, goes here.
+                    */
+                    break;
+                case ':':   /* missing option argument */
+                    //fprintf(stderr, "error: option '-%c' requires an argument\n", optopt);
+                    error_flag--;
+                    break;
+                case '?':
+                default:    /* invalid option */
+                    //fprintf(stderr, "error: option '-%c' is invalid\n", optopt);
+                    error_flag--;
+                    break;
+            }
+        }
+
+        if (optind < argc) {
+            fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+            while (optind < argc){
+                fprintf(stderr," %s", argv[optind++]);
+                error_flag--;
+            }
+            fprintf(stderr,"\n");
+        }
+
+        if (help_flag){
+            printf("command:\n");
+            codebook_help(stdout);
+        }else{
+
+            if ((cb.protocol == NULL) || (cb.n_ranges == 0) || (output == NULL)){
+                fprintf(stderr,"error: -p protocol, -R range and -o file are required\n");
+                error_flag--;
+            }
+
+            /* Check ranges against protocol options and count combinations */
+            if (error_flag == 0){
+                cb.count = 1;
+                for (int r = 0; r < cb.n_ranges && error_flag == 0; r++){
+                    int argtype = 0, conftype = 0;
+                    if (option_by_name(cb.protocol, cb.ranges[r].name, &argtype, &conftype) == NULL || argtype != OPTION_HAS_VALUE){
+                        fprintf(stderr,"error: protocol '%s' has no '%s' value option\n", cb.protocol->id, cb.ranges[r].name);
+                        error_flag--;
+                    }else{
+                        uint64_t values = (uint64_t)cb.ranges[r].last - cb.ranges[r].first + 1;
+                        if (values > MAX_CODEBOOK_CODES / cb.count){
+                            fprintf(stderr,"error: ranges exceed %llu codes\n", (unsigned long long)MAX_CODEBOOK_CODES);
+                            error_flag--;
+                        }else{
+                            cb.count *= values;
+                        }
+                    }
+                }
+            }
+
+            if (error_flag == 0 && states){
+                int   option_index = 0;
+                char* option_id    = NULL;
+                while (options_list(cb.protocol->options, option_index++, &option_id) == 0 && cb.n_states < MAX_CODEBOOK_STATES){
+                    char* option_name = NULL;
+                    int   argtype = 0, conftype = 0;
+                    options_get_name_by_id(cb.protocol->options, option_id, &option_name);
+                    options_get_argtype(cb.protocol->options, option_id, 0, &argtype);
+                    options_get_conftype(cb.protocol->options, option_id, 0, &conftype);
+                    if (option_name != NULL && argtype == OPTION_NO_VALUE && conftype == DEVICES_STATE){
+                        cb.states[cb.n_states++] = option_name;
+                    }
+                }
+                if (cb.n_states == 0){
+                    fprintf(stderr,"error: protocol '%s' has no state options\n", cb.protocol->id);
+                    error_flag--;
+                }else if ((uint64_t)cb.n_states > MAX_CODEBOOK_CODES / cb.count){
+                    fprintf(stderr,"error: ranges exceed %llu codes\n", (unsigned long long)MAX_CODEBOOK_CODES);
+                    error_flag--;
+                }else{
+                    cb.count *= (uint64_t)cb.n_states;
+                }
+            }
+
+            if (error_flag == 0){
+
+                FILE* out = fopen(output, "wb");
+
+                if (out != NULL){
+
+                    uint64_t failed = 0;
+                    clock_t  start  = clock();
+                    struct timespec t0, t1;
+
+                    timespec_get(&t0, TIME_UTC);
+                    cb.max_pulses = protocol_maxrawlen();
+#ifndef _WIN32
+                    pthread_mutex_init(&cb.next_lock, NULL);
+                    pthread_mutex_init(&cb.encode_lock, NULL);
+                    pthread_cond_init(&cb.batch_ready, NULL);
+                    pthread_cond_init(&cb.batch_done, NULL);
+#endif
+                    stats_phase(STATS_CODEC);
+                    error_flag = codebook_write(&cb, out, n_threads, &failed);
+#ifndef _WIN32
+                    pthread_mutex_destroy(&cb.next_lock);
+                    pthread_mutex_destroy(&cb.encode_lock);
+                    pthread_cond_destroy(&cb.batch_ready);
+                    pthread_cond_destroy(&cb.batch_done);
+#endif
+                    timespec_get(&t1, TIME_UTC);
+                    fclose(out);
+
+                    double wall = (double)(t1.tv_sec - t0.tv_sec) + (double)(t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+                    stats_phase(STATS_OUTPUT);
+                    if (error_flag == 0){
+                        printf("codebook: %llu codes (%llu unable to encode) in %.3f secs (%.3f cpu secs, %d threads)\n",
+                               (unsigned long long)cb.count, (unsigned long long)failed, wall,
+                               (double)(clock() - start) / CLOCKS_PER_SEC, n_threads);
+                    }else{
+                        fprintf(stderr,"error: writing '%s'\n",output);
+                        /* Partial codebook, never a device or pipe */
+                        struct stat st;
+                        if (stat(output, &st) == 0 && (st.st_mode & S_IFMT) == S_IFREG){
+                            remove(output);
+                        }
+                    }
+                }else{
+                    fprintf(stderr,"error: unable to open '%s'\n",output);
+                    error_flag--;
+                }
+            }
+        }
+    }else{
+        fprintf(stderr,"error: -p protocol, -R range and -o file are required\n");
+        error_flag--;
+    }
+
+    return error_flag;
+}
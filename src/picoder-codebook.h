@@ -0,0 +1,55 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_CODEBOOK_H
+#define PICODER_CODEBOOK_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+/*
+    Codebook file layout, all integers little-endian:
+
+        char[4]   magic "PICB"
+        uint16    version (1)
+        uint16    number of ranges
+        uint16    number of states (0 if not enumerated)
+        uint16    flags
+        uint64    number of codes
+        uint64    offset of the index
+        string    protocol name
+        string    fixed json members
+        ranges    string option name, uint32 first, uint32 last
+        states    string option name
+        records   string pilight code, one per combination, followed by
+                  string decoded json if CODEBOOK_FLAG_DECODED
+        index     uint64 offset of every record, 0 if unable to encode
+
+    Strings are uint16 length and bytes without '\0'. Code 'i' is the
+    combination of ranges in mixed radix, last range fastest, the state
+    (if enumerated) is the most significant digit.
+*/
+
+#define CODEBOOK_MAGIC       "PICB"
+#define CODEBOOK_VERSION     1
+
+#define CODEBOOK_FLAG_DECODED   0x0001   /* records carry decodePulseTrain() json */
+
+#ifndef MAX_CODEBOOK_RANGES
+#define MAX_CODEBOOK_RANGES  8
+#endif
+
+#ifndef MAX_CODEBOOK_STATES
+#define MAX_CODEBOOK_STATES  8
+#endif
+
+void codebook_help(FILE* out);
+
+int codebook_cmd(int argc, char** argv);
+
+#endif
@@ -7,6 +7,9 @@
 */
 
 #include "picoder-convert.h"
+#include "picoder-frame.h"
+#include "picoder-stats.h"
+#include "picoder-input.h"
 #include <getopt.h>
 
 typedef size_t rsize_t;
@@ -21,9 +24,22 @@ typedef size_t rsize_t;
 #define MAX_PULSE_LENGTH    100000UL
 #endif
 
+#ifndef MAX_FRAME_PULSES
+#define MAX_FRAME_PULSES    1024
+#endif
+
+#define REPEAT_TOLERANCE    0.15    /* timings of repeated frames within 15% */
+
 static struct option list_options[] = {
   { "string",     required_argument, NULL,      's' },
   { "train",      required_argument, NULL,      't' },
+  { "input",      required_argument, NULL,      'i' },
+  { "input-format", required_argument, NULL,    'f' },
+  { "channel",    required_argument, NULL,      'c' },
+  { "samplerate", required_argument, NULL,      'r' },
+  { "unitsize",   required_argument, NULL,      'u' },
+  { "gap",        required_argument, NULL,      'g' },
+  { "dedup",      no_argument,       NULL,      'd' },
   { "help",       no_argument,       NULL,      'h' },
   { NULL, 0, NULL, 0 }
  };
@@ -32,31 +48,165 @@ void convert_help(FILE* out){
     fprintf(out,"         convert [-h] [ -s string | -t train ]        --> coverts from/to pilight string to/from pulse train\n");
     fprintf(out,"                 [-h | --help]                        --> show command options\n");
     fprintf(out,"                 [-s | --string piligth-string]       --> pilight string to convert\n");
-    fprintf(out,"                 [-t | --train pulse-train]           --> pulse train to convert\n");
+    fprintf(out,"                 [-t | --train pulse-train]           --> pulse train to convert, one string per frame\n");
+    fprintf(out,"                 [-i | --input file]                  --> pulse durations file to convert ('-' stdin), one string per frame\n");
+    fprintf(out,"                 [-f | --input-format format]         --> set input format text (default), ook, vcd, logic, cu8, cs16 or am8\n");
+    fprintf(out,"                 [-c | --channel name]                --> vcd signal or logic channel bit (default first)\n");
+    fprintf(out,"                 [-r | --samplerate Hz]               --> logic and sdr samplerate (default %d, sdr %d)\n", DEFAULT_LOGIC_SAMPLERATE, DEFAULT_SDR_SAMPLERATE);
+    fprintf(out,"                 [-u | --unitsize bytes]              --> logic bytes per sample (default 1)\n");
+    fprintf(out,"                 [-g | --gap uSecs]                   --> min length of frame gaps (default %d)\n", DEFAULT_FRAME_GAP);
+    fprintf(out,"                 [-d | --dedup]                       --> join repeated frames adding repeats 'r:'\n");
+}
+
+/* Show pilight string, adding repeats when more than one */
+static void print_code(const char* code, int repeats){
+    size_t len = strlen(code);
+    if (repeats > 1 && len > 0 && code[len-1] == '@'){
+        printf("%.*s;r:%d@\n", (int)(len-1), code, repeats);
+    }else{
+        printf("%s\n", code);
+    }
+}
+
+/* Convert session state, frames of a pulse stream */
+typedef struct {
+    frame_splitter_t  fs;
+    bool              dedup;
+    char*             pending;    /* last frame string waiting for repeats */
+    int               repeats;
+    int               frames;
+    int               error;
+} converter_t;
+
+/*
+    Convert current frame, joined to pending string if repeated. The string
+    is allocated by pulseTrainToString(), PiCode has no variant writing to a
+    caller buffer, and is kept as pending without a copy. Frame views format
+    their own strings but cluster pulses differently, convert output stays
+    the PiCode one.
+*/
+static void convert_frame(converter_t* c){
+
+    stats_phase(STATS_CODEC);
+    char* code = pulseTrainToString(c->fs.pulses, (uint16_t)c->fs.count, 0);
+    stats_phase(STATS_OUTPUT);
+
+    if (code == NULL){
+        fprintf(stderr,"error: unable to encode pulse train\n");
+        c->error--;
+    }else if (c->dedup && c->pending != NULL && frame_same_code(c->pending, code, REPEAT_TOLERANCE)){
+        c->repeats++;
+        free(code);
+    }else{
+        if (c->pending != NULL){
+            print_code(c->pending, c->repeats);
+            free(c->pending);
+        }
+        c->pending = code;
+        c->repeats = 1;
+    }
+    c->frames++;
+}
+
+/* Push block of pulses, a packet end also ends the frame */
+static void convert_packet(void* ctx, const uint32_t* pulses, size_t n, bool end){
+
+    converter_t* c = (converter_t*)ctx;
+
+    for (size_t i = 0; i < n; i++){
+        if (frame_push(&c->fs, pulses[i])){
+            convert_frame(c);
+        }
+    }
+    if (end && frame_flush(&c->fs)){
+        convert_frame(c);
+    }
+}
+
+/* Flush trailing frame and pending string, returns error count */
+static int convert_end(converter_t* c){
+
+    if (frame_flush(&c->fs)){
+        convert_frame(c);
+    }
+    if (c->pending != NULL){
+        print_code(c->pending, c->repeats);
+        free(c->pending);
+        c->pending = NULL;
+    }
+
+    if (c->fs.dropped > 0){
+        fprintf(stderr,"error: %llu frames too long (max %d pulses)\n", (unsigned long long)c->fs.dropped, MAX_FRAME_PULSES);
+        c->error--;
+    }
+    if (c->error == 0 && c->frames == 0){
+        fprintf(stderr,"error: invalid pulse train (0)\n");
+        c->error--;
+    }
+
+    frame_splitter_free(&c->fs);
+
+    return c->error;
+}
+
+/* Convert pulse train of any length, one pilight string per frame */
+static int convert_train(converter_t* c, char* train){
+
+    char* pulse = strtok(train,",");
+
+    while (c->error == 0 && pulse != NULL){
+        if ((atol(pulse) > 0 ) && ((uint32_t)atol(pulse) <= MAX_PULSE_LENGTH)) {
+            if (frame_push(&c->fs, (uint32_t)atol(pulse))){
+                convert_frame(c);
+            }
+            pulse = strtok(NULL, ",");
+        }else{
+            fprintf(stderr,"error: pulses must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+            c->error--;
+        }
+    }
+
+    return convert_end(c);
+}
+
+/* Convert pulse durations file (as analyze reads), rtl_433 pulse data or logic captures */
+static int convert_input(converter_t* c, FILE* in, const input_options_t* options){
+
+    int result = input_read_stream(in, options, MAX_PULSE_LENGTH, convert_packet, c);
+    if (result != 0){
+        fprintf(stderr,"error: reading input\n");
+        c->error--;
+    }
+
+    return convert_end(c);
 }
 
 int convert_cmd(int argc, char** argv){
 
-    char*     pi_string         = NULL;
+    char*     train             = NULL;
+    char*     input             = NULL;
+    input_options_t input_options = { INPUT_TEXT, NULL, 0, 1 };
     uint32_t  pulses[MAX_PULSES] = {0};
     int       n_pulses           =  0;
+    uint32_t  gap                = DEFAULT_FRAME_GAP;
+    bool      dedup              = false;
 
     int  error_flag = 0;
     bool help_flag  = false;
     int  ch         = 1;
 
     if (argc > 1){
-        while ((ch = getopt_long(argc, argv, "s:t:h", list_options, NULL)) != -1) {
+        while ((ch = getopt_long(argc, argv, "s:t:i:f:c:r:u:g:dh", list_options, NULL)) != -1) {
 
             switch (ch) {
                 case 's':
-                    if (n_pulses == 0){
+                    if ((n_pulses == 0) && (train == NULL)){
+                        stats_phase(STATS_CODEC);
                         n_pulses = stringToPulseTrain(optarg, pulses, MAX_PULSES);
+                        stats_phase(STATS_PARSE);
                         if (n_pulses <= 0){
                             fprintf(stderr,"error: string to pulse train (%d)\n",n_pulses);
                             error_flag--;  
-                        }else{
-                            pi_string = optarg;
                         }
                     }else{
                         fprintf(stderr,"error: only one pilight string is allowed\n");
@@ -64,35 +214,59 @@ int convert_cmd(int argc, char** argv){
                     }
                     break;
                 case 't':  
-                    if (n_pulses == 0){
-
-                        char* pulse;
-                        pulse = strtok(optarg,",");
-
-                        while (pulse != NULL){
-
-                            if ((atol(pulse) > 0 ) && ((uint32_t)atol(pulse) <= MAX_PULSE_LENGTH)) { 
-                                pulses[n_pulses++] = (uint32_t)atol(pulse);
-                                if (n_pulses >= MAX_PULSES ){
-                                    pulse = NULL;
-                                    n_pulses = -1;
-                                    fprintf(stderr,"error: too many pulses (max %d)\n",MAX_PULSES);
-                                    error_flag--;
-                                }else{
-                                    pulse = strtok (NULL, ",");
-                                }
-                            }else{
-                                pulse = NULL;
-                                n_pulses = -1;
-                                fprintf(stderr,"error: pulses must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
-                                error_flag--;
-                            }
-                        }
+                    if ((n_pulses == 0) && (train == NULL)){
+                        train = optarg;
                     }else{
                         fprintf(stderr,"error: only one pulse train is allowed\n");
                         error_flag--;                        
                     }
                     break;
+                case 'i':
+                    if (input == NULL){
+                        input = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one input file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'f':
+                    if (input_format_by_name(optarg) >= 0){
+                        input_options.format = (input_format_t)input_format_by_name(optarg);
+                    }else{
+                        fprintf(stderr,"error: input format '%s' invalid\n",optarg);
+                        error_flag--;
+                    }
+                    break;
+                case 'c':
+                    input_options.channel = optarg;
+                    break;
+                case 'r':
+                    if (atof(optarg) > 0){
+                        input_options.samplerate = atof(optarg);
+                    }else{
+                        fprintf(stderr,"error: samplerate must be > 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'u':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= 8)){
+                        input_options.unitsize = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: unitsize must be > 0 and <= 8\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'g':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_PULSE_LENGTH)){
+                        gap = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: gap must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                        error_flag--;
+                    }
+                    break;
+                case 'd':
+                    dedup = true;
+                    break;
                 case 'h':
                     help_flag = true;
                     break;
@@ -129,29 +303,55 @@ int convert_cmd(int argc, char** argv){
             convert_help(stdout);
         }else{
 
-            if (error_flag == 0) {
+            converter_t converter;
+            memset(&converter, 0, sizeof(converter));
+            converter.dedup = dedup;
 
-                if (n_pulses > 0){
-                    if (pi_string == NULL){
-                        // Provide pulse train to convert to pilight string
-                        pi_string = pulseTrainToString(pulses,(uint16_t)n_pulses,0);
-                        if (pi_string != NULL){
-                            printf("%s\n",pi_string);
-                            free(pi_string);
-                        }else{
-                            fprintf(stderr,"error: unable to encode pulse train\n");
-                            error_flag--;    
+            if ((error_flag == 0) && (train != NULL || input != NULL) && !frame_splitter_init(&converter.fs, MAX_FRAME_PULSES, gap)){
+                fprintf(stderr,"error: malloc fail!\n");
+                error_flag--;
+            }
+
+            if ((error_flag == 0) && (input != NULL)) {
+
+                if ((n_pulses == 0) && (train == NULL)){
+                    FILE* in = strcmp(input, "-") == 0 ? stdin : fopen(input, "r");
+                    if (in != NULL){
+                        error_flag = convert_input(&converter, in, &input_options);
+                        if (in != stdin){
+                            fclose(in);
                         }
                     }else{
-                        // Provide pilight string to convert to pulse train
-                        printf("pulses[%d]={",n_pulses);
-                        for (int i = 0; i<n_pulses; i++){
-                            printf("%d",pulses[i]);
-                            if (i<n_pulses-1){
-                                printf(",");
-                            }else{
-                                printf("};\n");
-                            }
+                        fprintf(stderr,"error: unable to open '%s'\n",input);
+                        frame_splitter_free(&converter.fs);
+                        error_flag--;
+                    }
+                }else{
+                    fprintf(stderr,"error: input file not allowed with pilight string or pulse train\n");
+                    frame_splitter_free(&converter.fs);
+                    error_flag--;
+                }
+
+            }else if ((error_flag == 0) && (input_options.format != INPUT_TEXT)) {
+
+                fprintf(stderr,"error: input format requires -i input file\n");
+                error_flag--;
+
+            }else if (error_flag == 0) {
+
+                if (train != NULL){
+                    // Provide pulse train to convert to pilight strings
+                    error_flag = convert_train(&converter, train);
+                }else if (n_pulses > 0){
+                    // Provide pilight string to convert to pulse train
+                    stats_phase(STATS_OUTPUT);
+                    printf("pulses[%d]={",n_pulses);
+                    for (int i = 0; i<n_pulses; i++){
+                        printf("%d",pulses[i]);
+                        if (i<n_pulses-1){
+                            printf(",");
+                        }else{
+                            printf("};\n");
                         }
                     }
                 }else{
@@ -161,7 +361,7 @@ int convert_cmd(int argc, char** argv){
             }
         }
     }else{
-        fprintf(stderr,"error: -s pilight-string or -t pulse-train are required\n");
+        fprintf(stderr,"error: -s pilight-string, -t pulse-train or -i input file are required\n");
         error_flag--;
     }
 
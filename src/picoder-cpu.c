@@ -0,0 +1,279 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-cpu.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#define CPU_X86     1
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPU_X86     1
+#endif
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD     (1 << 1)
+#endif
+#endif
+
+#define CHECK_SIZE      4099    /* bytes, not a multiple of any vector */
+#define CHECK_ROUNDS      64
+
+cpu_kernels_t cpu_kernels = {
+    NULL, NULL, NULL
+};
+
+static const char* const isa_names[CPU_ISAS] = { "scalar", "sse4.2", "avx2", "neon" };
+
+static const cpu_kernels_t* const isa_kernels[CPU_ISAS] = {
+    &kernels_scalar, &kernels_sse42, &kernels_avx2, &kernels_neon
+};
+
+static int cpu_features = -1;   /* supported isa bits, -1 until detected */
+
+const char* cpu_isa_name(cpu_isa_t isa){
+    return (isa >= CPU_ISA_SCALAR && isa < CPU_ISAS) ? isa_names[isa] : "unknown";
+}
+
+#ifdef CPU_X86
+static void cpu_id(unsigned int leaf, unsigned int* regs){
+#if defined(_MSC_VER) && !defined(__clang__)
+    __cpuidex((int*)regs, (int)leaf, 0);
+#else
+    if (!__get_cpuid_count(leaf, 0, &regs[0], &regs[1], &regs[2], &regs[3])){
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+    }
+#endif
+}
+
+/* OS saves AVX registers on context switch, XCR0 bits of SSE and AVX state */
+static bool cpu_os_avx(void){
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (_xgetbv(0) & 6) == 6;
+#else
+    unsigned int eax, edx;
+    __asm__ volatile ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & 6) == 6;
+#endif
+}
+#endif
+
+static int cpu_detect(void){
+
+    int features = 1 << CPU_ISA_SCALAR;
+
+#ifdef CPU_X86
+    unsigned int regs[4] = { 0, 0, 0, 0 };
+
+    cpu_id(0, regs);
+    if (regs[0] >= 1){
+        cpu_id(1, regs);
+        bool sse42   = (regs[2] >> 20) & 1;
+        bool osxsave = (regs[2] >> 27) & 1;
+        bool avx     = (regs[2] >> 28) & 1;
+        if (sse42){
+            features |= 1 << CPU_ISA_SSE42;
+        }
+        cpu_id(0, regs);
+        if (sse42 && osxsave && avx && regs[0] >= 7 && cpu_os_avx()){
+            cpu_id(7, regs);
+            if ((regs[1] >> 5) & 1){
+                features |= 1 << CPU_ISA_AVX2;
+            }
+        }
+    }
+#elif defined(__aarch64__) && defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMD){
+        features |= 1 << CPU_ISA_NEON;
+    }
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    /* Advanced SIMD is part of every ARMv8-A */
+    features |= 1 << CPU_ISA_NEON;
+#endif
+
+    return features;
+}
+
+bool cpu_supported(cpu_isa_t isa){
+
+    if (cpu_features < 0){
+        cpu_features = cpu_detect();
+    }
+
+    return isa >= CPU_ISA_SCALAR && isa < CPU_ISAS && ((cpu_features >> isa) & 1) != 0;
+}
+
+/* Kernel of best supported isa up to max, every isa falls back to scalar */
+#define CPU_PICK(kernel, max)                                                                   \
+    for (int i = (max); i >= CPU_ISA_SCALAR; i--){                                             \
+        if (cpu_supported((cpu_isa_t)i) && isa_kernels[i]->kernel != NULL){                    \
+            cpu_kernels.kernel = isa_kernels[i]->kernel;                                        \
+            break;                                                                              \
+        }                                                                                       \
+    }
+
+bool cpu_select(const char* isa){
+
+    int max = CPU_ISAS - 1;
+
+    if (isa != NULL){
+        for (max = CPU_ISAS - 1; max >= CPU_ISA_SCALAR; max--){
+            if (strcmp(isa, isa_names[max]) == 0){
+                break;
+            }
+        }
+        if (max < CPU_ISA_SCALAR || !cpu_supported((cpu_isa_t)max)){
+            return false;
+        }
+    }
+
+    CPU_PICK(power_cu8,  max);
+    CPU_PICK(power_cs16, max);
+    CPU_PICK(level_run,  max);
+
+    return true;
+}
+
+/* Isa of active kernel, its set holding the same function */
+#define CPU_DESCRIBE(kernel)                                                                    \
+    for (int i = CPU_ISAS - 1; i >= CPU_ISA_SCALAR; i--){                                      \
+        if (isa_kernels[i]->kernel == cpu_kernels.kernel && len < size){                       \
+            len += (size_t)snprintf(text + len, size - len, "%s" #kernel " %s", len ? ", " : "", isa_names[i]); \
+            break;                                                                              \
+        }                                                                                       \
+    }
+
+void cpu_describe(char* text, size_t size){
+
+    size_t len = 0;
+
+    if (cpu_kernels.power_cu8 == NULL){
+        cpu_select(NULL);
+    }
+    text[0] = '\0';
+
+    CPU_DESCRIBE(power_cu8);
+    CPU_DESCRIBE(power_cs16);
+    CPU_DESCRIBE(level_run);
+}
+
+/* xorshift64, same check data on every run */
+static uint64_t check_random(uint64_t* state){
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+/*
+    Random IQ samples, and logic samples of random length runs of random
+    bytes, each kernel called at every offset and length mod 64 so every
+    vector width and tail is covered
+*/
+int cpu_check(FILE* out){
+
+    unsigned char* data   = (unsigned char*)malloc(CHECK_SIZE);
+    uint32_t*      expect = (uint32_t*)malloc(sizeof(*expect) * CHECK_SIZE);
+    uint32_t*      power  = (uint32_t*)malloc(sizeof(*power) * CHECK_SIZE);
+    uint64_t       state  = 0x9E3779B97F4A7C15ULL;
+    int            fails  = 0;
+    int            tested = 0;
+
+    if (data == NULL || expect == NULL || power == NULL){
+        free(data);
+        free(expect);
+        free(power);
+        fprintf(stderr,"error: malloc fail!\n");
+        return 1;
+    }
+
+    fprintf(out,"kernel        isa       cases  result\n");
+
+    for (int isa = CPU_ISA_SCALAR + 1; isa < CPU_ISAS; isa++){
+
+        const cpu_kernels_t* k      = isa_kernels[isa];
+        unsigned long        cases[3] = { 0, 0, 0 };
+        unsigned long        wrong[3] = { 0, 0, 0 };
+
+        if (!cpu_supported((cpu_isa_t)isa)){
+            continue;
+        }
+
+        for (int round = 0; round < CHECK_ROUNDS; round++){
+
+            size_t offset = (size_t)round % 64;
+            size_t len    = CHECK_SIZE - offset - (size_t)(check_random(&state) % 64);
+
+            for (size_t i = 0; i < CHECK_SIZE; i++){
+                data[i] = (unsigned char)check_random(&state);
+            }
+            if (k->power_cu8 != NULL){
+                size_t n = kernels_scalar.power_cu8(data + offset, len, expect);
+                cases[0]++;
+                if (k->power_cu8(data + offset, len, power) != n || memcmp(power, expect, sizeof(*power) * n) != 0){
+                    wrong[0]++;
+                }
+            }
+            if (k->power_cs16 != NULL){
+                size_t n = kernels_scalar.power_cs16(data + offset, len, expect);
+                cases[1]++;
+                if (k->power_cs16(data + offset, len, power) != n || memcmp(power, expect, sizeof(*power) * n) != 0){
+                    wrong[1]++;
+                }
+            }
+
+            /* Runs of one byte value up to 200 samples */
+            for (size_t i = 0; i < CHECK_SIZE;){
+                size_t        run   = 1 + (size_t)(check_random(&state) % 200);
+                unsigned char value = (unsigned char)check_random(&state);
+                for (; run > 0 && i < CHECK_SIZE; run--){
+                    data[i++] = value;
+                }
+            }
+            if (k->level_run != NULL){
+                for (int shift = 0; shift < 8; shift++){
+                    for (size_t i = offset; i < offset + len;){
+                        int    level = (data[i] >> shift) & 1;
+                        size_t n     = kernels_scalar.level_run(data + i, offset + len - i, shift, level);
+                        cases[2]++;
+                        if (k->level_run(data + i, offset + len - i, shift, level) != n
+                            || k->level_run(data + i, offset + len - i, shift, !level) != 0){
+                            wrong[2]++;
+                        }
+                        i += n;
+                    }
+                }
+            }
+        }
+
+        const char* names[3] = { "power_cu8", "power_cs16", "level_run" };
+        for (int i = 0; i < 3; i++){
+            if (cases[i] > 0){
+                fprintf(out,"%-13s %-8s %6lu  %s\n", names[i], isa_names[isa], cases[i], wrong[i] ? "FAIL" : "ok");
+                fails += wrong[i] ? 1 : 0;
+                tested++;
+            }
+        }
+    }
+
+    if (tested == 0){
+        fprintf(out,"no SIMD kernels supported, scalar only\n");
+    }
+
+    free(data);
+    free(expect);
+    free(power);
+
+    return fails;
+}
@@ -0,0 +1,67 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_CPU_H
+#define PICODER_CPU_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Instruction sets of kernels, each one requires the lower x86 ones */
+typedef enum {
+    CPU_ISA_SCALAR = 0,
+    CPU_ISA_SSE42,
+    CPU_ISA_AVX2,
+    CPU_ISA_NEON,
+    CPU_ISAS
+} cpu_isa_t;
+
+/*
+    Hot loops with one implementation per instruction set. Builds stay
+    portable, SIMD variants are compiled by function target attributes and
+    only called if the running CPU supports them.
+*/
+typedef struct {
+    /* Power I*I+Q*Q of 8 bits unsigned IQ pairs scaled to 12 bits, returns number of samples */
+    size_t (*power_cu8)(const unsigned char* in, size_t len, uint32_t* power);
+    /* Same of 16 bits signed little-endian IQ pairs */
+    size_t (*power_cs16)(const unsigned char* in, size_t len, uint32_t* power);
+    /* Number of leading samples whose bit shift is level, of n one byte samples */
+    size_t (*level_run)(const unsigned char* samples, size_t n, int shift, int level);
+} cpu_kernels_t;
+
+/* Kernel sets of picoder-kernels.c, NULL if not built for this target */
+extern const cpu_kernels_t kernels_scalar;
+extern const cpu_kernels_t kernels_sse42;
+extern const cpu_kernels_t kernels_avx2;
+extern const cpu_kernels_t kernels_neon;
+
+/* Active kernels, scalar until cpu_select() */
+extern cpu_kernels_t cpu_kernels;
+
+const char* cpu_isa_name(cpu_isa_t isa);
+
+/* Running CPU (cpuid or hwcaps) and OS support instruction set */
+bool cpu_supported(cpu_isa_t isa);
+
+/*
+    Select each kernel from the best supported instruction set, or up to
+    isa name if not NULL (--force-isa). Returns false if name is unknown or
+    not supported, kernels unchanged.
+*/
+bool cpu_select(const char* isa);
+
+/* Active instruction set of each kernel, "power_cu8 avx2, ..." */
+void cpu_describe(char* text, size_t size);
+
+/* Check every supported variant of each kernel against scalar one, returns number of fails */
+int cpu_check(FILE* out);
+
+#endif
@@ -7,11 +7,26 @@
 */
 
 #include "picoder-decode.h"
+#include "picoder-output.h"
+#include "picoder-suggest.h"
+#include "picoder-frame.h"
+#include "picoder-match.h"
+#include "picoder-table.h"
+#include "picoder-spec.h"
+#include "picoder-metrics.h"
+#include "picoder-stats.h"
+#include "picoder-shm.h"
+#include "picoder-input.h"
 #include <getopt.h>
 
 typedef size_t rsize_t;
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
 
 #ifndef MAX_PULSES
 #define MAX_PULSES    255
@@ -21,9 +36,30 @@ typedef size_t rsize_t;
 #define MAX_PULSE_LENGTH    100000UL
 #endif
 
+#ifndef MAX_LINE_LENGTH
+#define MAX_LINE_LENGTH     4096
+#endif
+
 static struct option list_options[] = {
   { "string",     required_argument, NULL,      's' },
   { "train",      required_argument, NULL,      't' },
+  { "input",      required_argument, NULL,      'i' },
+  { "shm",        required_argument, NULL,      'm' },
+  { "input-format", required_argument, NULL,    'f' },
+  { "channel",    required_argument, NULL,      'c' },
+  { "samplerate", required_argument, NULL,      'r' },
+  { "unitsize",   required_argument, NULL,      'u' },
+  { "gap",        required_argument, NULL,      'g' },
+  { "glitch",     required_argument, NULL,      'G' },
+  { "snap",       no_argument,       NULL,      'Z' },
+  { "prefilter",  no_argument,       NULL,      'P' },
+  { "table",      required_argument, NULL,      'L' },
+  { "specs",      optional_argument, NULL,      'X' },
+  { "metrics",    required_argument, NULL,      'M' },
+  { "interval",   required_argument, NULL,      'I' },
+  { "format",     required_argument, NULL,      'F' },
+  { "timestamp",  no_argument,       NULL,      'T' },
+  { "suggest",    optional_argument, NULL,      'S' },
   { "help",       no_argument,       NULL,      'h' },
   { NULL, 0, NULL, 0 }
  };
@@ -32,25 +68,545 @@ void decode_help(FILE* out){
     fprintf(out,"         decode [-h] [ -s string | -t train ]         --> decode pilight string or pulse train\n");
     fprintf(out,"                [-h | --help]                         --> show command options\n");
     fprintf(out,"                [-s | --string piligth-string]        --> pilight string to decode\n");
-    fprintf(out,"                [-t | --train pulse-train]            --> pulse train to decode\n");
+    fprintf(out,"                [-t | --train pulse-train]            --> pulse train to decode, split in frames on gaps\n");
+    fprintf(out,"                [-i | --input file]                   --> decode one string or train per line ('-' stdin)\n");
+    fprintf(out,"                [-f | --input-format format]          --> set input format text (default), ook, vcd, logic, cu8, cs16 or am8\n");
+    fprintf(out,"                [-c | --channel name]                 --> vcd signal or logic channel bit (default first)\n");
+    fprintf(out,"                [-r | --samplerate Hz]                --> logic and sdr samplerate (default %d, sdr %d)\n", DEFAULT_LOGIC_SAMPLERATE, DEFAULT_SDR_SAMPLERATE);
+    fprintf(out,"                [-u | --unitsize bytes]               --> logic bytes per sample (default 1)\n");
+    fprintf(out,"                [-m | --shm name]                     --> decode pulses of shared memory ring, split in frames on gaps\n");
+    fprintf(out,"                [-g | --gap uSecs]                    --> min length of frame gaps (default %d)\n", DEFAULT_FRAME_GAP);
+    fprintf(out,"                [-G | --glitch uSecs]                 --> merge shorter pulses with their neighbours\n");
+    fprintf(out,"                [-Z | --snap]                         --> set pulses to the mean of their 20%% cluster, not PiCode grouping\n");
+    fprintf(out,"                [-P | --prefilter]                    --> skip frames no protocol match descriptor accepts\n");
+    fprintf(out,"                [-F | --format format]                --> set output format json, ndjson, cbor or msgpack\n");
+    fprintf(out,"                [-T | --timestamp]                    --> add receive timestamp (ndjson, cbor, msgpack)\n");
+    fprintf(out,"                [-S | --suggest[=count]]              --> suggest nearest protocols when unable to decode\n");
+    fprintf(out,"                [-L | --table codebook]               --> lookup codebook decoded json first, up to %d\n", MAX_DECODE_TABLES);
+    fprintf(out,"                [-X | --specs[=file]]                 --> decode spec protocols by table driven kernel first\n");
+    fprintf(out,"                [-M | --metrics file]                 --> rewrite Prometheus metrics file periodically\n");
+    fprintf(out,"                [-I | --interval secs]                --> set metrics file interval (default %d)\n", DEFAULT_METRICS_INTERVAL);
+}
+
+/* Decode session state shared by every frame */
+typedef struct {
+    output_format_t       format;
+    bool                  timestamp;
+    int                   suggest;
+    output_buffer_t       buf;
+    fingerprint_index_t*  index;
+    frame_splitter_t      fs;
+    decode_table_t        table;
+    metrics_t*            metrics;
+    metrics_shard_t*      shard;    /* NULL if no metrics */
+    uint64_t              mark;     /* end of last stage */
+    int                   errors;   /* frames failed to decode, streamed input */
+    int                   decoded;  /* frames decoded, streamed input */
+    frame_filter_t        filter;   /* preprocessing ahead of decode */
+    frame_view_t          view;     /* classification of current frame, built once */
+    match_set_t           match;    /* prefilter descriptors, NULL descs if disabled */
+    match_stream_t        stream;   /* prefilter candidates of frame being received */
+    bool                  streamed; /* view and candidates of current frame built as pulses arrived */
+    spec_table_t          specs;    /* table driven decoders, 0 count if disabled */
+} decoder_t;
+
+/* Account time since end of last stage to 'stage' */
+static void decode_stage(decoder_t* d, metric_stage_t stage){
+    if (d->shard != NULL){
+        uint64_t now = metrics_now();
+        metrics_observe(d->shard, stage, now - d->mark);
+        d->mark = now;
+    }
+}
+
+/* Show nearest protocols of an unmatched frame, the index is built on first use */
+static void decode_suggest(decoder_t* d, const uint32_t* pulses, int n_pulses){
+
+    suggestion_t  suggestions[MAX_SUGGESTIONS];
+    fingerprint_t fp;
+    int           found = 0;
+
+    if (d->index == NULL){
+        d->index = fingerprint_index_build();
+    }
+    if (d->index != NULL && fingerprint_compute(pulses, n_pulses, &fp)){
+        found = fingerprint_index_nearest(d->index, &fp, suggestions, d->suggest);
+    }
+
+    if (d->format == OUTPUT_JSON || d->format == OUTPUT_NDJSON){
+        JsonNode* root  = json_mkobject();
+        JsonNode* array = json_mkarray();
+        for (int i = 0; i < found; i++){
+            JsonNode* item = json_mkobject();
+            json_append_member(item, "protocol", json_mkstring(suggestions[i].protocol->id));
+            json_append_member(item, "distance", json_mknumber(suggestions[i].distance, 3));
+            json_append_element(array, item);
+        }
+        json_append_member(root, "suggestions", array);
+
+        char* json = json_stringify(root, d->format == OUTPUT_JSON ? "  " : NULL);
+        if (json != NULL){
+            printf("%s\n", json);
+            free(json);
+        }
+        json_delete(root);
+    }else{
+        /* Binary formats only carry decoded messages */
+        for (int i = 0; i < found; i++){
+            fprintf(stderr,"suggest: %-20s %.3f\n", suggestions[i].protocol->id, suggestions[i].distance);
+        }
+    }
+}
+
+/*
+    Decoded json of frame in lookup tables, NULL if not found. Codebook keys
+    are pulseTrainToString() strings, the frame is keyed the same way: frame
+    views cluster pulses differently and would miss jittered frames.
+*/
+static const char* decode_lookup(decoder_t* d, const uint32_t* pulses, int n_pulses){
+
+    const char* json       = NULL;
+    char*       train_code = pulseTrainToString(pulses, (uint16_t)n_pulses, 0);
+
+    if (train_code != NULL){
+        json = decode_table_lookup(&d->table, train_code);
+        free(train_code);
+    }
+    if (d->shard != NULL){
+        metrics_inc(d->shard, json != NULL ? METRIC_TABLE_HITS : METRIC_TABLE_MISSES);
+    }
+    return json;
+}
+
+/* Decode one frame to output, returns 0 if decoded, -1 if no protocol match, -2 on fails */
+static int decode_frame(decoder_t* d, uint32_t* pulses, int n_pulses, double rx_time){
+
+    int           result    = 0;
+    const double* timestamp = d->timestamp ? &rx_time : NULL;
+    const char*   found;
+    char*         decoded   = NULL;
+    bool          rejected  = false;
+    bool          streamed  = d->streamed;
+
+    d->streamed = false;
+
+    decode_stage(d, METRIC_SEGMENT);
+    stats_phase(STATS_CODEC);
+    if (d->filter.glitch > 0 || d->filter.snap){
+        n_pulses = frame_filter(&d->filter, pulses, n_pulses, &d->view);
+    }else if (!streamed){
+        d->view.n_clusters = 0;
+    }
+    found = (d->table.count > 0) ? decode_lookup(d, pulses, n_pulses) : NULL;
+
+    /* Spec protocols by the shared table driven kernel, ahead of the parsers */
+    if (found == NULL && d->specs.count > 0){
+        decoded = spec_decode(&d->specs, pulses, n_pulses, d->format == OUTPUT_JSON ? "  " : NULL);
+    }
+
+    /* Frames no protocol can accept skip the parsers */
+    if (found == NULL && decoded == NULL && d->match.descs != NULL){
+        if (streamed && d->stream.alive != NULL){
+            rejected = !match_stream_end(&d->stream, &d->view, pulses, n_pulses);
+        }else{
+            if (d->view.n_clusters == 0 && d->match.views){
+                frame_view_build(&d->view, pulses, n_pulses);
+            }
+            rejected = !match_any(&d->match, &d->view, pulses, n_pulses);
+        }
+    }
+
+    if (d->format != OUTPUT_JSON){
+        /* Compact json, no indentation to format nor to parse back */
+        char* json = decoded;
+        if (json == NULL && found == NULL && !rejected){
+            json = decodePulseTrain(pulses, (uint8_t)n_pulses, NULL);
+        }
+        if (found == NULL){
+            found = json;
+        }
+        stats_phase(STATS_OUTPUT);
+        decode_stage(d, METRIC_DECODE);
+        if (found != NULL && d->shard != NULL){
+            metrics_match(d->metrics, d->shard, found);
+        }
+        if (found != NULL){
+            int messages = (d->format == OUTPUT_NDJSON) ? output_ndjson(stdout, &d->buf, found, timestamp)
+                                                        : output_binary(stdout, &d->buf, d->format, found, timestamp);
+            if (messages < 0){
+                result = -2;
+            }else if (messages == 0){
+                result = -1;
+            }
+            free(json);
+        }else{
+            result = rejected ? -1 : -2;
+        }
+    }else{
+        char* json = decoded;
+        if (json == NULL && found != NULL){
+            /* Table json is compact */
+            JsonNode* node = json_decode(found);
+            if (node != NULL){
+                json = json_stringify(node, "  ");
+                json_delete(node);
+            }
+        }else if (json == NULL && !rejected){
+            json = decodePulseTrain(pulses, (uint8_t)n_pulses, "  ");
+        }
+        stats_phase(STATS_OUTPUT);
+        decode_stage(d, METRIC_DECODE);
+        if (json != NULL && d->shard != NULL){
+            metrics_match(d->metrics, d->shard, json);
+        }
+        if (json != NULL){
+            if (strlen(json) > 4){  
+                printf("%s\n",json);
+            }else{
+                // JSON emply '[]'
+                result = -1;
+            }
+            free(json);
+        }else{
+            result = rejected ? -1 : -2;
+        }
+    }
+
+    if (result == -1 && d->suggest > 0){
+        decode_suggest(d, pulses, n_pulses);
+    }
+
+    if (d->shard != NULL){
+        decode_stage(d, METRIC_EMIT);
+        metrics_inc(d->shard, METRIC_FRAMES_IN);
+        metrics_inc(d->shard, result == 0 ? METRIC_FRAMES_OUT : (result == -1 ? METRIC_DECODE_MISSES : METRIC_DECODE_ERRORS));
+    }
+    return result;
+}
+
+/*
+    Push one pulse to the frame splitter, returns true when it ends a frame.
+    Prefilter candidates, and the frame view if a descriptor checks it,
+    advance with each pulse, so they are ready at the footer without a
+    second pass. Filters change pulses after the frame ends, then the view
+    is built by decode_frame().
+*/
+static bool decode_push(decoder_t* d, uint32_t pulse){
+
+    bool track = d->match.descs != NULL && d->filter.glitch == 0 && !d->filter.snap;
+    bool view  = track && d->match.views;
+
+    if (track && (d->fs.count == 0 || d->fs.complete)){
+        if (view){
+            frame_view_reset(&d->view);
+        }
+        if (d->stream.alive != NULL){
+            match_stream_reset(&d->stream);
+        }
+    }
+
+    bool frame = frame_push(&d->fs, pulse);
+
+    if (track){
+        /* Once every candidate is dropped, the view is not needed */
+        bool skip = d->stream.alive != NULL && d->stream.none;
+        if (view && !skip){
+            frame_view_push(&d->view, pulse);
+        }
+        if (frame){
+            if (view && !skip){
+                frame_view_finish(&d->view);
+            }else{
+                d->view.n_clusters = 0;
+            }
+            d->streamed = skip || !view || (d->view.n_pulses == (int)d->fs.count);
+        }else if (!skip && d->stream.alive != NULL){
+            match_stream_push(&d->stream, (int)d->fs.count);
+        }
+    }
+    return frame;
+}
+
+/* End of stream, trailing pulses without footer are decoded from scratch */
+static bool decode_flush(decoder_t* d){
+    d->streamed = false;
+    return frame_flush(&d->fs);
+}
+
+/*
+    Decode comma separated pulse train of any length, split in frames on
+    footer gaps. Unmatched frames are errors only if strict.
+*/
+static int decode_train(decoder_t* d, char* train, double rx_time, bool strict){
+
+    int   error_flag = 0;
+    int   frames     = 0;
+    bool  last       = false;
+    char* pulse      = strtok(train,",");
+
+    d->fs.dropped = 0;
+
+    while (!last){
+
+        bool frame;
+
+        if (pulse != NULL){
+            if ((atol(pulse) > 0 ) && ((uint32_t)atol(pulse) <= MAX_PULSE_LENGTH)) { 
+                frame = decode_push(d, (uint32_t)atol(pulse));
+                pulse = strtok (NULL, ",");
+            }else{
+                fprintf(stderr,"error: pulses must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                return --error_flag;
+            }
+        }else{
+            frame = decode_flush(d);
+            last  = true;
+        }
+
+        if (frame){
+            frames++;
+            switch (decode_frame(d, d->fs.pulses, (int)d->fs.count, rx_time)){
+                case -1:
+                    if (strict){
+                        fprintf(stderr,"error: unable to decode pulse train\n"); 
+                        error_flag--;
+                    }
+                    break;
+                case -2:
+                    fprintf(stderr,"error: decode pulse train fails\n");
+                    error_flag--; 
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    if (d->fs.dropped > 0){
+        fprintf(stderr,"error: too many pulses (max %d)\n",MAX_PULSES);
+        error_flag--;
+    }else if (frames == 0){
+        fprintf(stderr,"error: invalid pulse train (0)\n");
+        error_flag--;
+    }
+
+    return error_flag;
+}
+
+/* Receive time as seconds since epoch */
+static double receive_time(void){
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* Decode each line of input as a pilight string or pulse train */
+static int decode_input(decoder_t* d, FILE* in){
+
+    char            line[MAX_LINE_LENGTH];
+    uint32_t        pulses[MAX_PULSES];
+    unsigned long   line_num   = 0;
+    int             error_flag = 0;
+
+    while (fgets(line, sizeof(line), in) != NULL){
+
+        line_num++;
+        double rx_time = d->timestamp ? receive_time() : 0;
+
+        /* Segment stage from line received */
+        if (d->shard != NULL){
+            d->mark = metrics_now();
+        }
+
+        size_t len = strlen(line);
+        if (len > 0 && line[len-1] != '\n' && !feof(in)){
+            fprintf(stderr,"error: line %lu too long (max %d)\n", line_num, MAX_LINE_LENGTH - 2);
+            error_flag--;
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n');
+            continue;
+        }
+        while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r' || line[len-1] == ' ')){
+            line[--len] = '\0';
+        }
+        if (len == 0){
+            continue;
+        }
+
+        if (line[0] == 'c'){
+            int n_pulses = stringToPulseTrain(line, pulses, MAX_PULSES);
+            if (n_pulses > 0){
+                if (decode_frame(d, pulses, n_pulses, rx_time) == -2){
+                    fprintf(stderr,"error: decode pulse train fails (line %lu)\n", line_num);
+                    error_flag--;
+                }
+            }else{
+                fprintf(stderr,"error: invalid pilight string (line %lu)\n", line_num);
+                error_flag--;
+            }
+        }else if (decode_train(d, line, rx_time, false) != 0){
+            fprintf(stderr,"error: invalid pulse train (line %lu)\n", line_num);
+            error_flag--;
+        }
+    }
+    fflush(stdout);
+
+    return error_flag;
+}
+
+/* Decode each rtl_433 pulse data packet, split in frames on gaps */
+static void decode_packet(void* ctx, const uint32_t* pulses, size_t n, bool end){
+
+    decoder_t* d = (decoder_t*)ctx;
+
+    for (size_t i = 0; i <= n; i++){
+
+        bool frame = (i < n) ? decode_push(d, pulses[i]) : (end && decode_flush(d));
+
+        if (frame){
+            int result = decode_frame(d, d->fs.pulses, (int)d->fs.count, d->timestamp ? receive_time() : 0);
+            if (result == 0){
+                d->decoded++;
+            }else if (result == -2){
+                d->errors++;
+            }
+        }
+    }
+}
+
+#ifndef _WIN32
+
+static volatile sig_atomic_t shm_stop = 0;
+
+static void shm_signal(int sig){
+    (void)sig;
+    shm_stop = 1;
+}
+
+/*
+    Decode pulses of a shared memory ring until its producer closes it or
+    SIGINT/SIGTERM. Records are segmented in place, frame receive time is
+    the producer timestamp of its first pulse.
+*/
+static int decode_shm(decoder_t* d, const char* name){
+
+    shm_ring_t       ring;
+    struct sigaction sa;
+    uint64_t         pulses     = 0;
+    uint64_t         frame_ns   = 0;
+    int              error_flag = 0;
+    bool             flushed    = true;
+
+    if (!shm_ring_open(&ring, name, SHM_RING_CAPACITY, false)){
+        return -1;
+    }
+
+    /* Without SA_RESTART futex wait returns on signals */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = shm_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    d->fs.dropped = 0;
+
+    while (!shm_stop){
+
+        const shm_record_t* records;
+        size_t              n = shm_ring_peek(&ring, &records);
+
+        if (n == 0){
+            /* Idle, deliver output before sleeping */
+            if (!flushed){
+                fflush(stdout);
+                flushed = true;
+            }
+            if (shm_ring_wait(&ring, 100) < 0){
+                break;
+            }
+            continue;
+        }
+
+        for (size_t i = 0; i < n; i++){
+
+            if (d->fs.count == 0 || d->fs.complete){
+                frame_ns = records[i].timestamp;
+                if (d->shard != NULL){
+                    d->mark = metrics_now();
+                }
+            }
+
+            uint32_t pulse = records[i].pulse;
+            if (pulse == 0){
+                continue;
+            }
+            if (pulse > MAX_PULSE_LENGTH){
+                pulse = MAX_PULSE_LENGTH;
+            }
+
+            if (decode_push(d, pulse)){
+                double rx_time = frame_ns ? (double)frame_ns / 1e9 : (d->timestamp ? receive_time() : 0);
+                if (decode_frame(d, d->fs.pulses, (int)d->fs.count, rx_time) == -2){
+                    fprintf(stderr,"error: decode pulse train fails\n");
+                    error_flag--;
+                }
+            }
+        }
+
+        pulses += n;
+        flushed = false;
+        shm_ring_release(&ring, n);
+    }
+
+    if (decode_flush(d)){
+        double rx_time = frame_ns ? (double)frame_ns / 1e9 : (d->timestamp ? receive_time() : 0);
+        decode_frame(d, d->fs.pulses, (int)d->fs.count, rx_time);
+    }
+    fflush(stdout);
+
+    fprintf(stderr,"shm: %llu pulses, %llu dropped by producer, %llu frames too long\n",
+            (unsigned long long)pulses, (unsigned long long)shm_ring_dropped(&ring), (unsigned long long)d->fs.dropped);
+
+    shm_ring_close(&ring);
+
+    return error_flag;
 }
 
+#endif
+
 int decode_cmd(int argc, char** argv){
 
-    uint32_t  pulses[MAX_PULSES] = {0};
-    int       n_pulses           =  0;
+    uint32_t        pulses[MAX_PULSES] = {0};
+    int             n_pulses           =  0;
+    char*           train              = NULL;
+    char*           input              = NULL;
+    char*           shm                = NULL;
+    input_options_t input_options      = { INPUT_TEXT, NULL, 0, 1 };
+    output_format_t format             = OUTPUT_JSON;
+    bool            timestamp          = false;
+    int             suggest            = 0;
+    uint32_t        gap                = DEFAULT_FRAME_GAP;
+    frame_filter_t  filter             = { 0, false };
+    bool            prefilter          = false;
+    char*           tables[MAX_DECODE_TABLES];
+    char*           metrics            = NULL;
+    int             interval           = DEFAULT_METRICS_INTERVAL;
+    int             n_tables           =  0;
+    bool            specs              = false;
+    char*           spec_file          = NULL;
 
     int  error_flag = 0;
     bool help_flag  = false;
     int  ch         = 1;
 
     if (argc > 1){
-        while ((ch = getopt_long(argc, argv, "s:t:h", list_options, NULL)) != -1) {
+        while ((ch = getopt_long(argc, argv, "s:t:i:m:f:c:r:u:g:G:ZPF:TS::L:X::M:I:h", list_options, NULL)) != -1) {
 
             switch (ch) {
                 case 's':
-                    if (n_pulses == 0){
+                    if ((n_pulses == 0) && (train == NULL)){
+                        stats_phase(STATS_CODEC);
                         n_pulses = stringToPulseTrain(optarg, pulses, MAX_PULSES);
+                        stats_phase(STATS_PARSE);
                         if (n_pulses <= 0){
                             fprintf(stderr,"error: string to pulse train (%d)\n",n_pulses);
                             error_flag--;  
@@ -61,35 +617,132 @@ int decode_cmd(int argc, char** argv){
                     }
                     break;
                 case 't':  
-                    if (n_pulses == 0){
-
-                        char* pulse;
-                        pulse = strtok(optarg,",");
-
-                        while (pulse != NULL){
-
-                            if ((atol(pulse) > 0 ) && ((uint32_t)atol(pulse) <= MAX_PULSE_LENGTH)) { 
-                                pulses[n_pulses++] = (uint32_t)atol(pulse);
-                                if (n_pulses >= MAX_PULSES ){
-                                    pulse = NULL;
-                                    n_pulses = -1;
-                                    fprintf(stderr,"error: too many pulses (max %d)\n",MAX_PULSES);
-                                    error_flag--;
-                                }else{
-                                    pulse = strtok (NULL, ",");
-                                }
-                            }else{
-                                pulse = NULL;
-                                n_pulses = -1;
-                                fprintf(stderr,"error: pulses must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
-                                error_flag--;
-                            }
-                        }
+                    if ((n_pulses == 0) && (train == NULL)){
+                        train = optarg;
                     }else{
                         fprintf(stderr,"error: only one pulse train is allowed\n");
                         error_flag--;                        
                     }
                     break;
+                case 'i':
+                    if (input == NULL){
+                        input = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one input file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'm':
+                    if (shm == NULL){
+                        shm = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one shm ring is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'f':
+                    if (input_format_by_name(optarg) >= 0){
+                        input_options.format = (input_format_t)input_format_by_name(optarg);
+                    }else{
+                        fprintf(stderr,"error: input format '%s' invalid\n",optarg);
+                        error_flag--;
+                    }
+                    break;
+                case 'c':
+                    input_options.channel = optarg;
+                    break;
+                case 'r':
+                    if (atof(optarg) > 0){
+                        input_options.samplerate = atof(optarg);
+                    }else{
+                        fprintf(stderr,"error: samplerate must be > 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'u':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= 8)){
+                        input_options.unitsize = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: unitsize must be > 0 and <= 8\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'g':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_PULSE_LENGTH)){
+                        gap = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: gap must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                        error_flag--;
+                    }
+                    break;
+                case 'F':
+                    if (output_format_by_name(optarg) >= 0){
+                        format = (output_format_t)output_format_by_name(optarg);
+                    }else{
+                        fprintf(stderr,"error: output format '%s' invalid\n",optarg);
+                        error_flag--;
+                    }
+                    break;
+                case 'G':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_PULSE_LENGTH)){
+                        filter.glitch = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: glitch must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                        error_flag--;
+                    }
+                    break;
+                case 'Z':
+                    filter.snap = true;
+                    break;
+                case 'P':
+                    prefilter = true;
+                    break;
+                case 'T':
+                    timestamp = true;
+                    break;
+                case 'S':
+                    if (optarg == NULL){
+                        suggest = 3;
+                    }else if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_SUGGESTIONS)){
+                        suggest = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: suggest count must be > 0 and <= %d\n",MAX_SUGGESTIONS);
+                        error_flag--;
+                    }
+                    break;
+                case 'L':
+                    if (n_tables < MAX_DECODE_TABLES){
+                        tables[n_tables++] = optarg;
+                    }else{
+                        fprintf(stderr,"error: max %d tables are allowed\n",MAX_DECODE_TABLES);
+                        error_flag--;
+                    }
+                    break;
+                case 'X':
+                    if (spec_file == NULL){
+                        specs     = true;
+                        spec_file = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one spec file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'M':
+                    if (metrics == NULL){
+                        metrics = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one metrics file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'I':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= 3600)){
+                        interval = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: interval must be > 0 and <= 3600\n");
+                        error_flag--;
+                    }
+                    break;
                 case 'h':
                     help_flag = true;
                     break;
@@ -126,34 +779,162 @@ int decode_cmd(int argc, char** argv){
             decode_help(stdout);
         }else{
 
-            if (error_flag == 0) {
+            decoder_t decoder = { format, timestamp, suggest, {0}, NULL, {0}, {0}, NULL, NULL, 0, 0, 0, filter, {0}, {0}, {0}, false, {0} };
+
+            if ((error_flag == 0) && (metrics != NULL)){
+                decoder.metrics = metrics_new();
+                decoder.shard   = decoder.metrics ? metrics_shard(decoder.metrics) : NULL;
+                if (decoder.shard == NULL){
+                    fprintf(stderr,"error: malloc fail!\n");
+                    error_flag--;
+                }else if (!metrics_export(decoder.metrics, metrics, interval)){
+                    error_flag--;
+                }
+                decoder.mark = metrics_now();
+            }
+
+            for (int t = 0; t < n_tables && error_flag == 0; t++){
+                if (decode_table_load(&decoder.table, tables[t]) < 0){
+                    error_flag--;
+                }
+            }
+            if ((error_flag == 0) && (n_tables > 0) && !decode_table_index(&decoder.table)){
+                fprintf(stderr,"error: malloc fail!\n");
+                error_flag--;
+            }
+
+            if ((error_flag == 0) && specs){
+                char error[SPEC_ERROR];
+                if (!spec_table_init(&decoder.specs)){
+                    fprintf(stderr,"error: unable to init builtin specs\n");
+                    error_flag--;
+                }else if (spec_file != NULL && spec_table_load(&decoder.specs, spec_file, error) < 0){
+                    fprintf(stderr,"error: %s\n", error);
+                    error_flag--;
+                }
+            }
+
+            if ((error_flag == 0) && prefilter && (!match_set_build(&decoder.match) || !match_stream_init(&decoder.stream, &decoder.match))){
+                fprintf(stderr,"error: malloc fail!\n");
+                error_flag--;
+            }
+
+            if ((error_flag == 0) && !frame_splitter_init(&decoder.fs, MAX_PULSES, gap)){
+                fprintf(stderr,"error: malloc fail!\n");
+                error_flag--;
+            }
 
-                if (n_pulses > 0){
+            if ((error_flag == 0) && (format == OUTPUT_CBOR || format == OUTPUT_MSGPACK)){
+                output_set_binary(stdout);
+            }
 
-                    char *json = decodePulseTrain(pulses, (uint8_t)n_pulses, "  ");
+            if ((error_flag == 0) && (shm != NULL)) {
 
-                    if (json != NULL){
-                        if (strlen(json) > 4){  
-                            printf("%s\n",json);
+                if ((n_pulses == 0) && (train == NULL) && (input == NULL)){
+#ifndef _WIN32
+                    error_flag = decode_shm(&decoder, shm);
+#else
+                    fprintf(stderr,"error: shm ring is not supported on Windows\n");
+                    error_flag--;
+#endif
+                }else{
+                    fprintf(stderr,"error: shm ring not allowed with pilight string, pulse train or input file\n");
+                    error_flag--;
+                }
+
+            }else if ((error_flag == 0) && (input != NULL)) {
+
+                if ((n_pulses == 0) && (train == NULL)){
+                    FILE* in = strcmp(input, "-") == 0 ? stdin : fopen(input, "r");
+                    if (in != NULL){
+                        if (input_options.format != INPUT_TEXT){
+                            if (decoder.shard != NULL){
+                                decoder.mark = metrics_now();
+                            }
+                            if (input_read_stream(in, &input_options, MAX_PULSE_LENGTH, decode_packet, &decoder) != 0){
+                                fprintf(stderr,"error: reading '%s'\n",input);
+                                error_flag--;
+                            }
+                            /* Trailing frame without footer gap */
+                            decode_packet(&decoder, NULL, 0, true);
+                            fflush(stdout);
+                            if (decoder.errors > 0){
+                                fprintf(stderr,"error: decode pulse train fails (%d frames)\n",decoder.errors);
+                                error_flag--;
+                            }
+                            if (decoder.fs.dropped > 0){
+                                fprintf(stderr,"error: %llu frames too long (max %d pulses)\n",(unsigned long long)decoder.fs.dropped,MAX_PULSES);
+                            }
+                            /* Sample captures at a wrong samplerate decode nothing */
+                            if (decoder.decoded == 0 && input_options.format >= INPUT_LOGIC){
+                                fprintf(stderr,"error: no frames decoded from '%s', check samplerate\n",input);
+                                error_flag--;
+                            }
                         }else{
-                            // JSON emply '[]'
-                            fprintf(stderr,"error: unable to decode pulse train\n"); 
-                            error_flag--;                             
+                            error_flag = decode_input(&decoder, in);
+                        }
+                        if (in != stdin){
+                            fclose(in);
                         }
-                        free(json);
                     }else{
-                        fprintf(stderr,"error: decode pulse train fails\n");
-                        error_flag--; 
+                        fprintf(stderr,"error: unable to open '%s'\n",input);
+                        error_flag--;
                     }
+                }else{
+                    fprintf(stderr,"error: input file not allowed with pilight string or pulse train\n");
+                    error_flag--;
+                }
 
+            }else if ((error_flag == 0) && (input_options.format != INPUT_TEXT)) {
+
+                fprintf(stderr,"error: input format requires -i input file\n");
+                error_flag--;
+
+            }else if (error_flag == 0) {
+
+                if (train != NULL){
+                    error_flag = decode_train(&decoder, train, receive_time(), true);
+                }else if (n_pulses > 0){
+                    switch (decode_frame(&decoder, pulses, n_pulses, receive_time())){
+                        case -1:
+                            fprintf(stderr,"error: unable to decode pulse train\n"); 
+                            error_flag--;
+                            break;
+                        case -2:
+                            fprintf(stderr,"error: decode pulse train fails\n");
+                            error_flag--; 
+                            break;
+                        default:
+                            break;
+                    }
                 }else{
                     fprintf(stderr,"error: invalid pulse train (%d)\n",n_pulses);
                     error_flag--;    
                 }
             }
+
+            if (n_tables > 0 && (decoder.table.hits + decoder.table.misses) > 0){
+                fprintf(stderr,"table: %llu hits, %llu misses (%.1f%% hit rate)\n",
+                        (unsigned long long)decoder.table.hits, (unsigned long long)decoder.table.misses,
+                        100.0 * (double)decoder.table.hits / (double)(decoder.table.hits + decoder.table.misses));
+            }
+            if (prefilter && (decoder.match.accepted + decoder.match.rejected) > 0){
+                fprintf(stderr,"prefilter: %llu accepted, %llu rejected (%.1f%% parsers skipped)\n",
+                        (unsigned long long)decoder.match.accepted, (unsigned long long)decoder.match.rejected,
+                        100.0 * (double)decoder.match.rejected / (double)(decoder.match.accepted + decoder.match.rejected));
+            }
+
+            output_buffer_free(&decoder.buf);
+            fingerprint_index_free(decoder.index);
+            frame_splitter_free(&decoder.fs);
+            decode_table_free(&decoder.table);
+            match_stream_free(&decoder.stream);
+            match_set_free(&decoder.match);
+            spec_table_free(&decoder.specs);
+            metrics_free(decoder.metrics);
         }
     }else{
-        fprintf(stderr,"error: -s pilight-string or -t pulse-train are required\n");
+        fprintf(stderr,"error: -s pilight-string, -t pulse-train, -i input file or -m shm ring are required\n");
         error_flag--;
     }
 
@@ -7,21 +7,46 @@
 */
 
 #include "picoder-encode.h"
+#include "picoder-validate.h"
+#include "picoder-stats.h"
+#include "picoder-render.h"
+#include "picoder-noise.h"
+#include "picoder-output.h"
+#include "picoder-template.h"
 #include <getopt.h>
 
+typedef size_t rsize_t;
+#include <string.h>
 #include <stdlib.h>
 
 #ifndef MAX_ENCODE_REPEATS
 #define MAX_ENCODE_REPEATS     32
 #endif
 
+#ifndef MAX_RENDER_GAP
+#define MAX_RENDER_GAP   10000000UL   /* uSecs */
+#endif
+
+#ifndef MAX_LINE_LENGTH
+#define MAX_LINE_LENGTH     4096
+#endif
+
 static struct option list_options[] = {
   { "proto",      required_argument, NULL,      'p' },
   { "json",       required_argument, NULL,      'j' },
   { "full-json",  required_argument, NULL,      'f' },
+  { "batch",      required_argument, NULL,      'b' },
   { "repeats",    required_argument, NULL,      'r' },
   { "train",      no_argument,       NULL,      't' },
   { "only-train", no_argument,       NULL,      'o' },
+  { "render",     required_argument, NULL,      'R' },
+  { "format",     required_argument, NULL,      'F' },
+  { "samplerate", required_argument, NULL,      's' },
+  { "gap",        required_argument, NULL,      'g' },
+  { "noise",      required_argument, NULL,      'N' },
+  { "seed",       required_argument, NULL,      'S' },
+  { "specs",      optional_argument, NULL,      'X' },
+  { "vary",       required_argument, NULL,      'V' },
   { "help",       no_argument,       NULL,      'h' },
   { NULL, 0, NULL, 0 }
  };
@@ -32,9 +57,176 @@ void encode_help(FILE* out){
     fprintf(out,"                [-p | --proto protocol]               --> set protocol to encode\n");
     fprintf(out,"                [-j | --json json-data]               --> set json data to encode\n");
     fprintf(out,"                [-f | --full-json json]               --> set full json to encode\n");
+    fprintf(out,"                [-b | --batch file]                   --> encode one full json per line ('-' stdin)\n");
     fprintf(out,"                [-r | --repeats repeats]              --> add repeats parameter from 1 to %d\n", MAX_ENCODE_REPEATS);
     fprintf(out,"                [-t | --train]                        --> show pulse train\n");
     fprintf(out,"                [-o | --only-train]                   --> show only pulse train\n");
+    fprintf(out,"                [-R | --render file]                  --> render ook samples to file ('-' stdout)\n");
+    fprintf(out,"                [-F | --format format]                --> render format cu8 (default), cs8 or wav\n");
+    fprintf(out,"                [-s | --samplerate Hz]                --> render samplerate (default %d)\n", DEFAULT_RENDER_SAMPLERATE);
+    fprintf(out,"                [-g | --gap uSecs]                    --> render silence after each frame\n");
+    fprintf(out,"                [-N | --noise profile]                --> perturb pulses, 'jitter=0.1,drop=0.01,...'\n");
+    fprintf(out,"                [-S | --seed seed]                    --> set noise seed (default 1)\n");
+    fprintf(out,"                [-X | --specs[=file]]                 --> encode spec protocols by table driven encoder\n");
+    fprintf(out,"                [-V | --vary members]                 --> batch patching templates, 'on,off,dimlevel'\n");
+}
+
+/*
+    Show encoded pulses as pulse train and/or pilight string, or render them
+    repeats times. Code is the pilight string of pulses if already built.
+*/
+static int encode_output(uint32_t* pulses, int n_pulses, char repeats, bool show_train, bool show_only_train, render_t* render, const char* code){
+
+    int error_flag = 0;
+
+    if (render != NULL){
+        if (!render_frame(render, pulses, n_pulses, repeats > 0 ? repeats : 1)){
+            fprintf(stderr,"error: unable to write samples\n");
+            error_flag--;
+        }
+        return error_flag;
+    }
+
+    if (show_train || show_only_train){
+        printf("pulses[%d]={",n_pulses);
+        for (int i = 0; i<n_pulses; i++){
+            printf("%d",pulses[i]);
+            if (i<n_pulses-1){
+                printf(",");
+            }else{
+                printf("};\n");
+            }
+        }
+    }
+    if (!show_only_train && code != NULL){
+        printf("%s\n",code);
+    }else if (!show_only_train){
+        
+        char* picode_str = pulseTrainToString(pulses,(uint16_t)n_pulses, (uint8_t)repeats);
+
+        if (picode_str != NULL){
+            printf("%s\n",picode_str);
+            free(picode_str);
+        }else{
+            fprintf(stderr,"error: encoding pulse train");
+            error_flag--; 
+        }
+    }
+    return error_flag;
+}
+
+int encode_full_json(validator_t* validator, const spec_table_t* specs, const char* full_json, uint32_t* pulses, uint16_t max_pulses, char* error){
+
+    JsonNode*     root_json  = json_decode(full_json);
+    JsonNode*     child_json = (root_json != NULL) ? json_first_child(root_json) : NULL;
+    bool          has_key    = (child_json != NULL && child_json->key != NULL);
+    protocol_t*   protocol   = has_key ? findProtocol(child_json->key) : NULL;
+    const spec_t* spec       = (has_key && specs != NULL) ? spec_find(specs, child_json->key) : NULL;
+    int           n_pulses   = -1;
+
+    if (!has_key){
+        snprintf(error, VALIDATE_ERROR, "full json invalid");
+    }else if (protocol == NULL && spec == NULL){
+        snprintf(error, VALIDATE_ERROR, "protocol '%s' invalid", child_json->key);
+    }else if (spec == NULL && protocol->createCode == NULL){
+        snprintf(error, VALIDATE_ERROR, "protocol '%s' no encode support", child_json->key);
+    }else if (protocol == NULL || validate_json(validator, protocol, child_json, error)){
+        char* json_data = json_encode(child_json);
+        if (json_data != NULL && spec != NULL){
+            n_pulses = spec_encode(spec, json_data, pulses, max_pulses, error);
+        }else{
+            n_pulses = (json_data != NULL) ? encodeToPulseTrain(pulses, max_pulses, protocol, json_data) : -1;
+            if (n_pulses < 0){
+                snprintf(error, VALIDATE_ERROR, "unable to encode (%d)", n_pulses);
+            }
+        }
+        if (json_data) free(json_data);
+    }
+    if (root_json != NULL){
+        json_delete(root_json);
+    }
+
+    return n_pulses;
+}
+
+/* Perturb encoded pulses in place, returns new number of pulses */
+static int encode_noise(noise_t* noise, uint32_t* pulses, int n_pulses, uint16_t n_pulses_max){
+
+    uint32_t* clean = (uint32_t*)malloc(sizeof(*clean) * (size_t)(n_pulses > 0 ? n_pulses : 1));
+
+    if (clean == NULL){
+        fprintf(stderr,"error: malloc fail!\n");
+        return -1;
+    }
+    memcpy(clean, pulses, sizeof(*clean) * (size_t)n_pulses);
+    n_pulses = noise_apply(noise, clean, n_pulses, pulses, n_pulses_max);
+    free(clean);
+
+    return n_pulses;
+}
+
+/*
+    Encode each line of input as full json. Option masks of every protocol
+    are compiled once, invalid lines are shown, skipped and counted in the
+    result. With templates pulses are patched from a previous encode of the
+    same fixed members.
+*/
+static int encode_batch(FILE* in, validator_t* validator, const spec_table_t* specs, template_cache_t* templates, uint32_t* pulses, uint16_t n_pulses_max, char repeats, bool show_train, bool show_only_train, render_t* render, noise_t* noise){
+
+    char           line[MAX_LINE_LENGTH];
+    char           error[VALIDATE_ERROR];
+    unsigned long  line_num   = 0;
+    int            error_flag = 0;
+
+    while (fgets(line, sizeof(line), in) != NULL){
+
+        line_num++;
+
+        size_t len = strlen(line);
+        if (len > 0 && line[len-1] != '\n' && !feof(in)){
+            fprintf(stderr,"error: line %lu too long (max %d)\n", line_num, MAX_LINE_LENGTH - 2);
+            error_flag--;
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n');
+            continue;
+        }
+        while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r' || line[len-1] == ' ')){
+            line[--len] = '\0';
+        }
+        if (len == 0){
+            continue;
+        }
+
+        const char* code = NULL;
+
+        stats_phase(STATS_CODEC);
+        int n_pulses = (templates != NULL) ? template_encode(templates, line, pulses, &code, error)
+                                           : encode_full_json(validator, specs, line, pulses, n_pulses_max, error);
+        stats_phase(STATS_OUTPUT);
+
+        if (n_pulses > 0 && noise != NULL){
+            n_pulses = encode_noise(noise, pulses, n_pulses, n_pulses_max);
+            code     = NULL;
+            if (n_pulses < 0){
+                error_flag--;
+                break;
+            }
+        }
+
+        if (n_pulses >= 0){
+            int output = encode_output(pulses, n_pulses, repeats, show_train, show_only_train, render, code);
+            error_flag += output;
+            if (output != 0 && render != NULL){
+                break;      /* samples file unwritable, later lines would fail the same */
+            }
+        }else{
+            fprintf(stderr,"error: %s (line %lu)\n", error, line_num);
+            error_flag--;
+        }
+    }
+    fflush(stdout);
+
+    return error_flag;
 }
 
 int encode_cmd(int argc, char** argv){
@@ -44,6 +236,25 @@ int encode_cmd(int argc, char** argv){
     char*       json_data                 = NULL; 
     uint32_t*   pulses                    = NULL;
     char        repeats                   =  0 ;
+    char*       batch                     = NULL;
+    validator_t validator                 = { NULL };
+    char*       render_file               = NULL;
+    int         render_format             = RENDER_CU8;
+    double      samplerate                = DEFAULT_RENDER_SAMPLERATE;
+    uint32_t    gap                       =  0 ;
+    render_t    render                    = { NULL };
+    FILE*       render_out                = NULL;
+    char*       noise_spec                = NULL;
+    unsigned long seed                    =  1 ;
+    noise_t     noise;
+    char*       proto_name                = NULL;
+    char*       full_name                 = NULL;
+    bool        use_specs                 = false;
+    char*       spec_file                 = NULL;
+    spec_table_t  specs                   = { NULL, 0 };
+    const spec_t* spec                    = NULL;
+    char*       vary                      = NULL;
+    template_cache_t templates;
 
     bool show_train      = false;
     bool show_only_train = false;
@@ -53,21 +264,13 @@ int encode_cmd(int argc, char** argv){
     int  ch         = 1;
 
     if (argc > 1){
-        while ((ch = getopt_long(argc, argv, "p:j:f:r:hto", list_options, NULL)) != -1) {
+        while ((ch = getopt_long(argc, argv, "p:j:f:b:r:htoR:F:s:g:N:S:X::V:", list_options, NULL)) != -1) {
 
             switch (ch) {
                 case 'p':
-                    if ((protocol == NULL) && (json_data == NULL)){
-                        protocol = findProtocol(optarg);
-                        if (protocol == NULL){
-                            fprintf(stderr, "error: protocol '%s' invalid\n", optarg);
-                            error_flag--;
-                        }else{
-                            if (protocol->createCode==NULL){
-                                fprintf(stderr, "error: protocol '%s' no encode support\n", optarg);
-                                error_flag--;                                
-                            }
-                        }
+                    if ((proto_name == NULL) && (json_data == NULL)){
+                        /* Checked once specs are loaded */
+                        proto_name = optarg;
                     }else{
                         fprintf(stderr,"error: only one protocol is allowed\n");
                         error_flag--;
@@ -87,7 +290,7 @@ int encode_cmd(int argc, char** argv){
                     }
                     break;
                 case 'f':
-                    if ((json_data == NULL) && (json == NULL) && (protocol == NULL)){
+                    if ((json_data == NULL) && (json == NULL) && (proto_name == NULL)){
                         if (json_validate(optarg)){
 
                             /* decode as root json */
@@ -101,24 +304,15 @@ int encode_cmd(int argc, char** argv){
                                     /* check for child key */
                                     if (child_json->key != NULL){
 
-                                        protocol = findProtocol(child_json->key);
-
-                                        if (protocol == NULL){
-                                            fprintf(stderr, "error: protocol '%s' invalid\n", child_json->key);
-                                            error_flag--;
+                                        /* Protocol checked once specs are loaded */
+                                        full_name  = strdup(child_json->key);
+                                        proto_name = full_name;
+                                        json_data  = json_encode(child_json);
+                                        if (json_data != NULL){
+                                            json = json_data;
                                         }else{
-                                            if (protocol->createCode==NULL){
-                                                fprintf(stderr, "error: protocol '%s' no encode support\n", child_json->key);
-                                                error_flag--;                                
-                                            }else{
-                                                json_data  = json_encode(child_json);
-                                                if (json_data != NULL){
-                                                    json = json_data;
-                                                }else{
-                                                    fprintf(stderr, "error: json data invalid\n");
-                                                    error_flag--;   
-                                                }
-                                            }
+                                            fprintf(stderr, "error: json data invalid\n");
+                                            error_flag--;   
                                         }
                                     }else{
                                         fprintf(stderr, "error: full json child no key\n");
@@ -143,6 +337,14 @@ int encode_cmd(int argc, char** argv){
                         error_flag--;                        
                     }
                     break;
+                case 'b':
+                    if (batch == NULL){
+                        batch = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one batch file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
                 case 'r':
                     if (repeats == 0){
                         if ((atoi(optarg) > 0) && (atoi(optarg) < MAX_ENCODE_REPEATS )){
@@ -166,6 +368,55 @@ int encode_cmd(int argc, char** argv){
                 case 'o':
                     show_only_train = true;
                     break;
+                case 'R':
+                    if (render_file == NULL){
+                        render_file = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one render file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'F':
+                    render_format = render_format_by_name(optarg);
+                    if (render_format < 0){
+                        fprintf(stderr,"error: render format '%s' invalid\n",optarg);
+                        error_flag--;
+                    }
+                    break;
+                case 's':
+                    if (atof(optarg) > 0){
+                        samplerate = atof(optarg);
+                    }else{
+                        fprintf(stderr,"error: samplerate must be > 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'g':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_RENDER_GAP)){
+                        gap = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: gap must be > 0 and <= %lu\n",MAX_RENDER_GAP);
+                        error_flag--;
+                    }
+                    break;
+                case 'N':
+                    noise_spec = optarg;
+                    break;
+                case 'S':
+                    seed = strtoul(optarg, NULL, 0);
+                    break;
+                case 'X':
+                    if (spec_file == NULL){
+                        use_specs = true;
+                        spec_file = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one spec file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'V':
+                    vary = optarg;
+                    break;
                 case 1:
                     /*
                     * Use this case if getopt_long() should go through all
@@ -194,17 +445,118 @@ int encode_cmd(int argc, char** argv){
             fprintf(stderr,"\n");
         }
 
+        if (render_file == NULL && (render_format != RENDER_CU8 || samplerate != DEFAULT_RENDER_SAMPLERATE || gap > 0)){
+            fprintf(stderr,"error: format, samplerate and gap require render file\n");
+            error_flag--;
+        }else if (render_file != NULL && (show_train || show_only_train)){
+            fprintf(stderr,"error: render file not allowed with train\n");
+            error_flag--;
+        }
+
+        if (vary != NULL && batch == NULL){
+            fprintf(stderr,"error: vary members require batch file\n");
+            error_flag--;
+        }
+
+        if (noise_spec != NULL){
+            noise_profile_t profile;
+            if (noise_profile_parse(noise_spec, &profile)){
+                noise_seed(&noise, &profile, seed);
+            }else{
+                fprintf(stderr,"error: noise profile '%s' invalid\n",noise_spec);
+                error_flag--;
+            }
+        }
+
+        if (use_specs && error_flag == 0){
+            char error[SPEC_ERROR];
+            if (!spec_table_init(&specs)){
+                fprintf(stderr,"error: unable to init builtin specs\n");
+                error_flag--;
+            }else if (spec_file != NULL && spec_table_load(&specs, spec_file, error) < 0){
+                fprintf(stderr,"error: %s\n", error);
+                error_flag--;
+            }
+        }
+
+        /* Spec of protocol replaces its PiCode encoder, or adds one */
+        if (proto_name != NULL){
+            protocol = findProtocol(proto_name);
+            spec     = spec_find(&specs, proto_name);
+            if (protocol == NULL && spec == NULL){
+                fprintf(stderr, "error: protocol '%s' invalid\n", proto_name);
+                error_flag--;
+            }else if (spec == NULL && protocol->createCode == NULL){
+                fprintf(stderr, "error: protocol '%s' no encode support\n", proto_name);
+                error_flag--;
+            }
+        }
+
+        if (!help_flag && error_flag == 0 && render_file != NULL){
+            render_out = strcmp(render_file, "-") == 0 ? stdout : fopen(render_file, "wb");
+            if (render_out == NULL){
+                fprintf(stderr,"error: unable to open '%s'\n",render_file);
+                error_flag--;
+            }else{
+                if (render_out == stdout){
+                    output_set_binary(stdout);
+                }
+                if (!render_open(&render, render_out, (render_format_t)render_format, samplerate, gap)){
+                    fprintf(stderr,"error: unable to write samples\n");
+                    error_flag--;
+                }
+            }
+        }
+
         if (help_flag){
             printf("command:\n");
             encode_help(stdout);
     
+        }else if (batch != NULL){
+
+            if ((proto_name != NULL) || (json != NULL) || (json_data != NULL)){
+                fprintf(stderr,"error: batch file not allowed with protocol or json\n");
+                error_flag--;
+            }
+
+            if (error_flag == 0){
+
+                FILE*     in           = strcmp(batch, "-") == 0 ? stdin : fopen(batch, "r");
+                uint16_t  n_pulses_max = protocol_maxrawlen();
+
+                pulses = (uint32_t*)malloc(sizeof *pulses * (n_pulses_max + 1));
+
+                if (in == NULL){
+                    fprintf(stderr,"error: unable to open '%s'\n",batch);
+                    error_flag--;
+                }else if (pulses == NULL){
+                    fprintf(stderr,"error: malloc(%lu) fail!\n",(sizeof *pulses * (n_pulses_max + 1)));
+                    error_flag--;
+                }else if (vary != NULL && !template_cache_init(&templates, vary, &validator, use_specs ? &specs : NULL, n_pulses_max, (uint8_t)repeats)){
+                    fprintf(stderr,"error: vary members '%s' invalid (max %d)\n", vary, MAX_TEMPLATE_VARY);
+                    template_cache_free(&templates);
+                    error_flag--;
+                }else{
+                    error_flag += encode_batch(in, &validator, use_specs ? &specs : NULL, vary != NULL ? &templates : NULL, pulses, n_pulses_max, repeats, show_train, show_only_train, render_out != NULL ? &render : NULL, noise_spec != NULL ? &noise : NULL);
+                    if (vary != NULL){
+                        fprintf(stderr,"template: %lu templates%s, %lu patched, %lu encoded, %lu learning encodes\n",
+                                templates.n_templates, templates.closed ? " (closed)" : "", templates.patched, templates.encoded, templates.learned);
+                        template_cache_free(&templates);
+                    }
+                }
+                if (in != NULL && in != stdin){
+                    fclose(in);
+                }
+                free(pulses);
+            }
+
         }else{
  
-            if ((protocol == NULL) && (json == NULL) && (json_data == NULL)){
+            if ((proto_name == NULL) && (json == NULL) && (json_data == NULL)){
                 fprintf(stderr,"error: -p protocol and -j json data or -f full json are required\n");
                 error_flag--;
             }else{
-                if (((protocol == NULL) || (json == NULL)) && (json_data == NULL)){
+                if (((proto_name == NULL) || (json == NULL)) && (json_data == NULL)){
                     fprintf(stderr,"error: -p protocol and -j json data are required\n");
                     error_flag--;                    
                 }
@@ -223,34 +575,34 @@ int encode_cmd(int argc, char** argv){
                     // Clean array of pulses
                     for ( uint16_t i = 0; i < n_pulses_max; i++) pulses[i] = 0;
 
-                    int n_pulses = encodeToPulseTrain(pulses, n_pulses_max, protocol, json);
+                    stats_phase(STATS_CODEC);
 
-                    if (n_pulses >= 0 ){
+                    /* Reject invalid option values before encode */
+                    char      error[VALIDATE_ERROR];
+                    JsonNode* data_json = json_decode(json);
+                    bool      valid     = (data_json == NULL) || (protocol == NULL) || validate_json(&validator, protocol, data_json, error);
+                    if (data_json != NULL){
+                        json_delete(data_json);
+                    }
 
-                        if (show_train || show_only_train){
-                            printf("pulses[%d]={",n_pulses);
-                            for (int i = 0; i<n_pulses; i++){
-                                printf("%d",pulses[i]);
-                                if (i<n_pulses-1){
-                                    printf(",");
-                                }else{
-                                    printf("};\n");
-                                }
-                            }
-                        }
-                        if (!show_only_train){
-                            
-                            char* picode_str = pulseTrainToString(pulses,(uint16_t)n_pulses, (uint8_t)repeats);
+                    int n_pulses = -1;
+                    if (valid && spec != NULL){
+                        n_pulses = spec_encode(spec, json, pulses, n_pulses_max, error);
+                        valid    = n_pulses >= 0;
+                    }else if (valid){
+                        n_pulses = encodeToPulseTrain(pulses, n_pulses_max, protocol, json);
+                    }
 
-                            if (picode_str != NULL){
-                                printf("%s\n",picode_str);
-                                free(picode_str);
-                            }else{
-                                fprintf(stderr,"error: encoding pulse train");
-                                error_flag--; 
-                            }
-                            
+                    stats_phase(STATS_OUTPUT);
+
+                    if (!valid){
+                        fprintf(stderr,"error: %s\n",error);
+                        error_flag--;
+                    }else if (n_pulses >= 0 ){
+                        if (noise_spec != NULL){
+                            n_pulses = encode_noise(&noise, pulses, n_pulses, n_pulses_max);
                         }
+                        error_flag = (n_pulses < 0) ? -1 : encode_output(pulses, n_pulses, repeats, show_train, show_only_train, render_out != NULL ? &render : NULL, NULL);
                     }else{
                         fprintf(stderr,"error: unable to encode (%d)\n",n_pulses);
                         error_flag = n_pulses;
@@ -267,6 +619,18 @@ int encode_cmd(int argc, char** argv){
         fprintf(stderr,"error: -p protocol and -j json or -f full json are required\n");
         error_flag--;
     }
+    if (render_out != NULL){
+        if (!render_close(&render) && error_flag == 0){
+            fprintf(stderr,"error: unable to write samples\n");
+            error_flag--;
+        }
+        if (render_out != stdout){
+            fclose(render_out);
+        }
+    }
     if (json_data) free(json_data);
+    if (full_name) free(full_name);
+    spec_table_free(&specs);
+    validator_free(&validator);
     return error_flag; 
 }
\ No newline at end of file
@@ -12,8 +12,18 @@
 #include <cPiCode.h>
 #include <stdio.h>
 
+#include "picoder-validate.h"
+#include "picoder-spec.h"
+
 void encode_help(FILE* out);
 
+/*
+    Encode full json '{"protocol":{json-data}}' validating option values,
+    by protocol spec if any in specs (may be NULL). Returns number of pulses
+    or -1 with error message set.
+*/
+int encode_full_json(validator_t* validator, const spec_table_t* specs, const char* full_json, uint32_t* pulses, uint16_t max_pulses, char* error);
+
 int encode_cmd(int argc, char** argv);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-frame.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+bool frame_splitter_init(frame_splitter_t* fs, size_t size, uint32_t gap){
+    fs->pulses   = (uint32_t*)malloc(sizeof(*fs->pulses) * size);
+    fs->count    = 0;
+    fs->size     = size;
+    fs->gap      = gap;
+    fs->complete = false;
+    fs->overflow = false;
+    fs->dropped  = 0;
+    return fs->pulses != NULL;
+}
+
+void frame_splitter_free(frame_splitter_t* fs){
+    free(fs->pulses);
+    fs->pulses = NULL;
+    fs->size   = 0;
+    fs->count  = 0;
+}
+
+bool frame_push(frame_splitter_t* fs, uint32_t pulse){
+
+    if (fs->complete){
+        fs->count    = 0;
+        fs->complete = false;
+    }
+
+    if (fs->count < fs->size){
+        fs->pulses[fs->count++] = pulse;
+    }else{
+        fs->overflow = true;
+    }
+
+    if (pulse >= fs->gap){
+        if (fs->overflow){
+            fs->overflow = false;
+            fs->count    = 0;
+            fs->dropped++;
+            return false;
+        }
+        fs->complete = true;
+        return true;
+    }
+    return false;
+}
+
+bool frame_flush(frame_splitter_t* fs){
+
+    if (fs->complete){
+        fs->count    = 0;
+        fs->complete = false;
+    }
+
+    if (fs->overflow){
+        fs->overflow = false;
+        fs->count    = 0;
+        fs->dropped++;
+    }
+
+    if (fs->count > 0){
+        fs->complete = true;
+        return true;
+    }
+    return false;
+}
+
+void frame_view_reset(frame_view_t* view){
+    view->n_pulses   = 0;
+    view->n_clusters = 0;
+    view->found      = 0;
+}
+
+void frame_view_push(frame_view_t* view, uint32_t pulse){
+
+    int i = view->n_pulses++;
+
+    if (view->found < 0){
+        return;
+    }
+    if (i >= FRAME_VIEW_PULSES){
+        view->found = -1;
+        return;
+    }
+
+    int k = 0;
+    while (k < view->found && (pulse > view->centers[k] * (1.0 + FRAME_CLUSTER_TOLERANCE) ||
+                               pulse < view->centers[k] * (1.0 - FRAME_CLUSTER_TOLERANCE))){
+        k++;
+    }
+    if (k == view->found){
+        if (k == MAX_FRAME_CLUSTERS){
+            view->found = -1;
+            return;
+        }
+        view->sums[k]   = 0;
+        view->counts[k] = 0;
+        memset(view->members[k], 0, sizeof(view->members[k]));
+        view->found++;
+    }
+    view->sums[k]   += pulse;
+    view->counts[k] += 1;
+    view->centers[k] = (uint32_t)((view->sums[k] + view->counts[k] / 2) / view->counts[k]);
+    view->index[i]   = (uint8_t)k;
+    view->members[k][i >> 6] |= 1ULL << (i & 63);
+}
+
+bool frame_view_finish(frame_view_t* view){
+
+    int n_pulses = view->n_pulses;
+
+    view->n_clusters = 0;
+
+    if (view->found <= 0){
+        return false;
+    }
+
+    /* Footer out of short and long */
+    int      footer    = view->index[n_pulses - 1];
+    uint32_t counts[MAX_FRAME_CLUSTERS];
+    memcpy(counts, view->counts, sizeof(counts));
+    counts[footer]--;
+    view->members[footer][(n_pulses - 1) >> 6] &= ~(1ULL << ((n_pulses - 1) & 63));
+
+    /* Split at geometric mean of shortest and longest centers, single pulse clusters (glitches) only count if there are no others */
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    for (int pass = 0; pass < 2 && max == 0; pass++){
+        for (int k = 0; k < view->found; k++){
+            if (counts[k] > (uint32_t)(1 - pass)){
+                min = (view->centers[k] < min) ? view->centers[k] : min;
+                max = (view->centers[k] > max) ? view->centers[k] : max;
+            }
+        }
+    }
+
+    /* Bit vectors from cluster members, no pass over pulses */
+    int words = (n_pulses + 63) / 64;
+    memset(view->shorts, 0, sizeof(*view->shorts) * (size_t)words);
+    memset(view->longs, 0, sizeof(*view->longs) * (size_t)words);
+
+    for (int k = 0; k < view->found; k++){
+        uint64_t* bits = (max > min && (double)view->centers[k] * view->centers[k] > (double)min * max) ? view->longs : view->shorts;
+        for (int w = 0; w < words; w++){
+            bits[w] |= view->members[k][w];
+        }
+    }
+    view->members[footer][(n_pulses - 1) >> 6] |= 1ULL << ((n_pulses - 1) & 63);
+
+    view->n_clusters = view->found;
+
+    return true;
+}
+
+bool frame_view_build(frame_view_t* view, const uint32_t* pulses, int n_pulses){
+
+    frame_view_reset(view);
+
+    if (n_pulses <= 0 || n_pulses > FRAME_VIEW_PULSES){
+        view->n_pulses = n_pulses;
+        return false;
+    }
+    for (int i = 0; i < n_pulses; i++){
+        frame_view_push(view, pulses[i]);
+    }
+    return frame_view_finish(view);
+}
+
+int frame_view_code(const frame_view_t* view, char* code, size_t size){
+
+    if (view->n_clusters <= 0 || size < (size_t)view->n_pulses + 5){
+        return -1;
+    }
+
+    size_t len = 0;
+
+    code[len++] = 'c';
+    code[len++] = ':';
+    for (int i = 0; i < view->n_pulses; i++){
+        code[len++] = (char)('0' + view->index[i]);
+    }
+    code[len++] = ';';
+    code[len++] = 'p';
+    code[len++] = ':';
+    for (int k = 0; k < view->n_clusters; k++){
+        int n = snprintf(code + len, size - len, "%s%u", k ? "," : "", (unsigned)view->centers[k]);
+        if (n < 0 || (size_t)n >= size - len){
+            return -1;
+        }
+        len += (size_t)n;
+    }
+    if (len + 2 > size){
+        return -1;
+    }
+    code[len++] = '@';
+    code[len]   = '\0';
+
+    return (int)len;
+}
+
+int frame_filter(const frame_filter_t* filter, uint32_t* pulses, int n_pulses, frame_view_t* view){
+
+    frame_view_t local;
+
+    if (view != NULL){
+        view->n_pulses   = n_pulses;
+        view->n_clusters = 0;
+    }
+    if (n_pulses < 2){
+        return n_pulses;
+    }
+
+    if (filter->glitch > 0){
+
+        int last = n_pulses - 1;
+        int n    = 0;
+
+        /* Level of glitch lost, previous and next pulses merged; parity kept */
+        for (int i = 0; i < last; i++){
+            if (pulses[i] >= filter->glitch){
+                pulses[n++] = pulses[i];
+            }else if (n > 0 && i + 1 < last){
+                pulses[n - 1] += pulses[i] + pulses[i + 1];
+                i++;
+            }else if (n == 0 && i + 1 < last){
+                /* Leading glitch and the level after it are noise before the frame */
+                i++;
+            }else if (n > 0){
+                /* Glitch before footer, joins it */
+                pulses[last] += pulses[i];
+            }
+        }
+        if (n > 0 && ((n ^ last) & 1) == 1){
+            n--;
+            pulses[last] += pulses[n];
+        }
+        pulses[n++] = pulses[last];
+        n_pulses = n;
+    }
+
+    if (view != NULL){
+        view->n_pulses = n_pulses;
+    }
+
+    if (filter->snap){
+
+        if (view == NULL){
+            view = &local;
+        }
+
+        /* Too many clusters are not a pilight code, left as is. Snapped pulses keep view clusters */
+        if (frame_view_build(view, pulses, n_pulses)){
+            for (int i = 0; i < n_pulses; i++){
+                pulses[i] = view->centers[view->index[i]];
+            }
+        }
+    }
+
+    return n_pulses;
+}
+
+bool frame_same_code(const char* a, const char* b, double tolerance){
+
+    const char* pa = strstr(a, ";p:");
+    const char* pb = strstr(b, ";p:");
+
+    if (pa == NULL || pb == NULL || (pa - a) != (pb - b) || strncmp(a, b, (size_t)(pa - a)) != 0){
+        return false;
+    }
+
+    pa += 3;
+    pb += 3;
+    while (*pa != '\0' && *pa != ';' && *pa != '@'){
+        char*  end_a;
+        char*  end_b;
+        double va = strtod(pa, &end_a);
+        double vb = strtod(pb, &end_b);
+        if (end_a == pa || end_b == pb || *end_a != *end_b || va > vb * (1 + tolerance) || vb > va * (1 + tolerance)){
+            return false;
+        }
+        pa = (*end_a == ',') ? end_a + 1 : end_a;
+        pb = (*end_b == ',') ? end_b + 1 : end_b;
+    }
+    return *pb == '\0' || *pb == ';' || *pb == '@';
+}
@@ -0,0 +1,113 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_FRAME_H
+#define PICODER_FRAME_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#ifndef DEFAULT_FRAME_GAP
+#define DEFAULT_FRAME_GAP    5000    /* pulses from this length end a frame */
+#endif
+
+/*
+    Split a stream of pulses in frames ended by a footer gap. The frame buffer
+    is allocated once and reused, pulses of frames longer than its size are
+    dropped up to the next gap.
+*/
+typedef struct {
+    uint32_t*  pulses;      /* current frame, valid after frame_push() returns true */
+    size_t     count;       /* pulses of current frame */
+    size_t     size;        /* frame buffer size */
+    uint32_t   gap;         /* min footer gap */
+    bool       complete;    /* frame returned, clear on next push */
+    bool       overflow;    /* current frame exceeds buffer size */
+    uint64_t   dropped;     /* frames dropped by overflow */
+} frame_splitter_t;
+
+bool frame_splitter_init(frame_splitter_t* fs, size_t size, uint32_t gap);
+
+void frame_splitter_free(frame_splitter_t* fs);
+
+/* Push one pulse, returns true when it ends a frame */
+bool frame_push(frame_splitter_t* fs, uint32_t pulse);
+
+/* End of stream, returns true if trailing pulses without footer make a frame */
+bool frame_flush(frame_splitter_t* fs);
+
+#define FRAME_CLUSTER_TOLERANCE   0.2     /* pulse joins cluster if within 20% of its center */
+#define MAX_FRAME_CLUSTERS         10     /* 'c:' digits of pilight string */
+
+#ifndef FRAME_VIEW_PULSES
+#define FRAME_VIEW_PULSES         512     /* longest frame classified by a view */
+#endif
+
+/* Preprocessing of frames ahead of decode, 0 or false stages are off */
+typedef struct {
+    uint32_t  glitch;       /* merge pulses shorter than this with both neighbours */
+    bool      snap;         /* set pulses to their view cluster center */
+} frame_filter_t;
+
+#define FRAME_VIEW_WORDS   ((FRAME_VIEW_PULSES + 63) / 64)
+#define FRAME_VIEW_CODE    (FRAME_VIEW_PULSES + MAX_FRAME_CLUSTERS * 11 + 8)
+
+/*
+    Classification of a frame computed once and shared by every consumer:
+    cluster table ('p:' part), cluster index of every pulse ('c:' part) and
+    bit vectors of short and long pulses, split at the geometric mean of the
+    shortest and longest centers, bit i of word i / 64. Footer is in index
+    but out of bit vectors.
+
+    Pulses are grouped as they arrive, in first seen order: a pulse joins the
+    first cluster whose running mean is within 20%, each center is the mean
+    of its pulses. This is not PiCode's pulseTrainToString() grouping, so
+    clusters can differ from the 'p:' part of the frame pilight string. The
+    cluster index of a pulse is final when pushed, so a view can be built
+    pulse by pulse while the frame is received.
+*/
+typedef struct {
+    int       n_pulses;
+    int       n_clusters;                       /* 0 if not classified */
+    uint32_t  centers[MAX_FRAME_CLUSTERS];
+    uint8_t   index[FRAME_VIEW_PULSES];
+    uint64_t  shorts[FRAME_VIEW_WORDS];
+    uint64_t  longs[FRAME_VIEW_WORDS];
+
+    /* Clusters being grouped, found is -1 if more than MAX_FRAME_CLUSTERS or pulses */
+    int       found;
+    uint64_t  sums[MAX_FRAME_CLUSTERS];
+    uint32_t  counts[MAX_FRAME_CLUSTERS];
+    uint64_t  members[MAX_FRAME_CLUSTERS][FRAME_VIEW_WORDS];
+} frame_view_t;
+
+/* Start a new frame */
+void frame_view_reset(frame_view_t* view);
+
+/* Group next pulse, index[n_pulses - 1] is its cluster if found >= 0 */
+void frame_view_push(frame_view_t* view, uint32_t pulse);
+
+/* Last pushed pulse is the footer, sets bit vectors. Returns false if not classified */
+bool frame_view_finish(frame_view_t* view);
+
+/* Classify frame, returns false if too long or more than MAX_FRAME_CLUSTERS */
+bool frame_view_build(frame_view_t* view, const uint32_t* pulses, int n_pulses);
+
+/* Pilight string of view without repeats, layout of pulseTrainToString() but view clusters, returns length or -1 */
+int frame_view_code(const frame_view_t* view, char* code, size_t size);
+
+/*
+    Filter frame in place, footer kept, returns new number of pulses. The view
+    (if not NULL) is built from filtered pulses, not classified if no snap.
+*/
+int frame_filter(const frame_filter_t* filter, uint32_t* pulses, int n_pulses, frame_view_t* view);
+
+/* Compare pilight strings, same pulse indexes and timings within tolerance */
+bool frame_same_code(const char* a, const char* b, double tolerance);
+
+#endif
@@ -0,0 +1,211 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-input.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define OOK_LINE_LENGTH    256
+
+int input_format_by_name(const char* name){
+    if (strcmp(name, "text") == 0){
+        return INPUT_TEXT;
+    }else if (strcmp(name, "ook") == 0){
+        return INPUT_OOK;
+    }else if (strcmp(name, "vcd") == 0){
+        return INPUT_VCD;
+    }else if (strcmp(name, "logic") == 0){
+        return INPUT_LOGIC;
+    }else if (strcmp(name, "cu8") == 0){
+        return INPUT_CU8;
+    }else if (strcmp(name, "cs16") == 0){
+        return INPUT_CS16;
+    }else if (strcmp(name, "am8") == 0){
+        return INPUT_AM8;
+    }
+    return -1;
+}
+
+int input_read_pulses(FILE* in, uint32_t max_pulse, input_block_t callback, void* ctx){
+
+    char*     chunk      = (char*)malloc(INPUT_CHUNK);
+    uint32_t* block      = (uint32_t*)malloc(sizeof(*block) * INPUT_BLOCK);
+    size_t    n_block    = 0;
+    uint32_t  value      = 0;
+    bool      in_number  = false;
+    bool      in_comment = false;
+    size_t    len;
+
+    if (chunk == NULL || block == NULL){
+        free(chunk);
+        free(block);
+        fprintf(stderr,"error: malloc fail!\n");
+        return -1;
+    }
+
+    while ((len = fread(chunk, 1, INPUT_CHUNK, in)) > 0){
+        for (size_t i = 0; i < len; i++){
+            char c = chunk[i];
+            if (in_comment){
+                in_comment = (c != '\n');
+            }else if (c >= '0' && c <= '9'){
+                /* Saturate, any pulse over max length is a gap */
+                value = value > max_pulse ? value : value * 10 + (uint32_t)(c - '0');
+                in_number = true;
+            }else{
+                if (in_number){
+                    if (value > 0){
+                        block[n_block++] = value;
+                        if (n_block == INPUT_BLOCK){
+                            callback(ctx, block, n_block);
+                            n_block = 0;
+                        }
+                    }
+                    value     = 0;
+                    in_number = false;
+                }
+                in_comment = (c == '#' || c == ';');
+            }
+        }
+    }
+    if (in_number && value > 0){
+        block[n_block++] = value;
+    }
+    if (n_block > 0){
+        callback(ctx, block, n_block);
+    }
+
+    free(chunk);
+    free(block);
+
+    return ferror(in) ? -1 : 0;
+}
+
+/* Timescale in uSecs, 0 if invalid */
+static double ook_timescale(const char* line){
+
+    double value;
+    char   unit[3] = "";
+
+    if (sscanf(line, ";timescale %lf%2s", &value, unit) < 1 || value <= 0){
+        return 0;
+    }
+    if (strcmp(unit, "ns") == 0){
+        return value / 1000.0;
+    }else if (strcmp(unit, "ms") == 0){
+        return value * 1000.0;
+    }else if (strcmp(unit, "s") == 0){
+        return value * 1000000.0;
+    }
+    return value;   /* "us" */
+}
+
+int input_read_ook(FILE* in, uint32_t max_pulse, input_packet_t callback, void* ctx){
+
+    char      line[OOK_LINE_LENGTH];
+    uint32_t* block   = (uint32_t*)malloc(sizeof(*block) * INPUT_BLOCK);
+    size_t    n_block = 0;
+    double    scale   = 1.0;
+    bool      packet  = false;  /* pulses since last packet end */
+
+    if (block == NULL){
+        fprintf(stderr,"error: malloc fail!\n");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL){
+
+        size_t len = strlen(line);
+        if (len > 0 && line[len-1] != '\n' && !feof(in)){
+            /* Longer than any valid line, skip rest */
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n');
+        }
+
+        if (line[0] == ';'){
+            if (strncmp(line, ";timescale", 10) == 0){
+                double value = ook_timescale(line);
+                if (value > 0){
+                    scale = value;
+                }
+            }else if (strncmp(line, ";end", 4) == 0 || strncmp(line, ";ook", 4) == 0 || strncmp(line, ";fsk", 4) == 0){
+                /* Packet start also ends a packet without ';end' */
+                if (packet){
+                    callback(ctx, block, n_block, true);
+                    n_block = 0;
+                    packet  = false;
+                }
+            }
+            continue;
+        }
+
+        char*  p = line;
+        char*  end;
+        for (int i = 0; i < 2; i++){
+            double value = strtod(p, &end);
+            if (end == p){
+                break;
+            }
+            p = end;
+            value = floor(value * scale + 0.5);
+            if (value < 1){
+                continue;
+            }
+            block[n_block++] = value > max_pulse ? max_pulse : (uint32_t)value;
+            packet = true;
+            if (n_block == INPUT_BLOCK){
+                callback(ctx, block, n_block, false);
+                n_block = 0;
+            }
+        }
+    }
+    if (packet){
+        callback(ctx, block, n_block, true);
+    }
+
+    free(block);
+
+    return ferror(in) ? -1 : 0;
+}
+
+/* Packet callback of non packet formats */
+typedef struct {
+    input_packet_t  callback;
+    void*           ctx;
+} stream_ctx_t;
+
+static void stream_block(void* ctx, const uint32_t* pulses, size_t n){
+    stream_ctx_t* stream = (stream_ctx_t*)ctx;
+    stream->callback(stream->ctx, pulses, n, false);
+}
+
+int input_read_stream(FILE* in, const input_options_t* options, uint32_t max_pulse, input_packet_t callback, void* ctx){
+
+    stream_ctx_t stream = { callback, ctx };
+
+    switch (options->format){
+        case INPUT_OOK:
+            return input_read_ook(in, max_pulse, callback, ctx);
+        case INPUT_VCD:
+            return input_read_vcd(in, options->channel, max_pulse, stream_block, &stream);
+        case INPUT_LOGIC:
+            return input_read_logic(in, options->channel ? atoi(options->channel) : 0, options->unitsize,
+                                    options->samplerate > 0 ? options->samplerate : DEFAULT_LOGIC_SAMPLERATE,
+                                    max_pulse, stream_block, &stream);
+        case INPUT_CU8:
+        case INPUT_CS16:
+        case INPUT_AM8:
+            return input_read_sdr(in, options->format, options->samplerate > 0 ? options->samplerate : DEFAULT_SDR_SAMPLERATE,
+                                  max_pulse, stream_block, &stream);
+        default:
+            return input_read_pulses(in, max_pulse, stream_block, &stream);
+    }
+}
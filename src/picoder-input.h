@@ -0,0 +1,88 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_INPUT_H
+#define PICODER_INPUT_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#define INPUT_BLOCK       4096    /* max pulses per callback */
+#define INPUT_CHUNK      65536    /* bytes per read */
+
+#define DEFAULT_LOGIC_SAMPLERATE   1000000   /* Hz */
+#define DEFAULT_SDR_SAMPLERATE     2000000   /* Hz, same as encode render default */
+
+typedef enum {
+    INPUT_TEXT = 0,     /* command own text input */
+    INPUT_OOK,          /* rtl_433 pulse data file, 'rtl_433 -w file.ook' */
+    INPUT_VCD,          /* value change dump, logic analyzers and 'sigrok-cli -O vcd' */
+    INPUT_LOGIC,        /* raw logic samples, 'sigrok-cli -O binary' */
+    INPUT_CU8,          /* SDR IQ samples, unsigned 8 bits (rtl_sdr) */
+    INPUT_CS16,         /* SDR IQ samples, signed 16 bits little-endian */
+    INPUT_AM8           /* SDR amplitude samples, unsigned 8 bits */
+} input_format_t;
+
+/* Options of sample and logic capture formats */
+typedef struct {
+    input_format_t  format;
+    const char*     channel;      /* vcd signal reference or identifier, logic channel number, NULL first */
+    double          samplerate;   /* Hz, 0 format default */
+    int             unitsize;     /* logic bytes per sample */
+} input_options_t;
+
+/* Get input format from name, -1 if unknown */
+int input_format_by_name(const char* name);
+
+/* Receives each block of pulses read */
+typedef void (*input_block_t)(void* ctx, const uint32_t* pulses, size_t n);
+
+/*
+    Read pulse durations capture: numbers separated by any non digit, '#'
+    and ';' comment out to end of line, 0 skipped. Numbers saturate over
+    max_pulse. Returns 0 or -1 on read or malloc fails.
+*/
+int input_read_pulses(FILE* in, uint32_t max_pulse, input_block_t callback, void* ctx);
+
+/* Receives each packet, in blocks if longer than INPUT_BLOCK, end set on last block */
+typedef void (*input_packet_t)(void* ctx, const uint32_t* pulses, size_t n, bool end);
+
+/*
+    Read rtl_433 pulse data: ';' header lines, ';ook' or ';fsk' starts and
+    ';end' ends a packet, data lines are pulse and gap in ';timescale' units
+    (default 1us). Pulses are converted to uSecs, 0 skipped, saturated over
+    max_pulse. Streams in constant memory. Returns 0 or -1 on read or
+    malloc fails.
+*/
+int input_read_ook(FILE* in, uint32_t max_pulse, input_packet_t callback, void* ctx);
+
+/*
+    Read VCD value changes of one 1 bit signal, edge to edge durations in
+    uSecs by '$timescale'. Vector signals take their lowest bit, 'x' and
+    'z' keep level. Returns 0 or -1 on read fails or channel not found.
+*/
+int input_read_vcd(FILE* in, const char* channel, uint32_t max_pulse, input_block_t callback, void* ctx);
+
+/*
+    Read raw logic samples, unitsize bytes per sample little-endian, edge
+    to edge durations of channel bit at samplerate. Returns 0 or -1 on read
+    or malloc fails.
+*/
+int input_read_logic(FILE* in, int channel, int unitsize, double samplerate, uint32_t max_pulse, input_block_t callback, void* ctx);
+
+/*
+    Demodulate OOK of SDR samples: power of each sample (SIMD kernels),
+    adaptive noise floor and pulse level thresholds, durations of levels
+    at samplerate. Returns 0 or -1 on read or malloc fails.
+*/
+int input_read_sdr(FILE* in, input_format_t format, double samplerate, uint32_t max_pulse, input_block_t callback, void* ctx);
+
+/* Read any non text format, blocks of non packet formats never end a packet */
+int input_read_stream(FILE* in, const input_options_t* options, uint32_t max_pulse, input_packet_t callback, void* ctx);
+
+#endif
@@ -0,0 +1,298 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-cpu.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+
+/*
+    SIMD variants are built for the target architecture whatever the
+    compiler flags, by function target attributes, so a static portable
+    binary carries all of them. MSVC needs no attribute to use intrinsics.
+*/
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_X86     1
+#define TARGET_SSE42    __attribute__((target("sse4.2")))
+#define TARGET_AVX2     __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define KERNELS_X86     1
+#define TARGET_SSE42
+#define TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define KERNELS_NEON    1
+#include <arm_neon.h>
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_SWAR    1     /* 8 samples per 64 bits word */
+#endif
+
+/* Index of lowest set bit of a non zero mask */
+static inline int first_bit(uint32_t mask){
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/* Scalar kernels, also the tail of SIMD ones */
+
+static size_t power_cu8_scalar(const unsigned char* in, size_t len, uint32_t* power){
+
+    size_t n = 0;
+
+    for (size_t i = 0; i + 2 <= len; i += 2, n++){
+        int32_t re = ((int32_t)in[i] - 128) * 16;
+        int32_t im = ((int32_t)in[i + 1] - 128) * 16;
+        power[n] = (uint32_t)(re * re + im * im);
+    }
+    return n;
+}
+
+static size_t power_cs16_scalar(const unsigned char* in, size_t len, uint32_t* power){
+
+    size_t n = 0;
+
+    for (size_t i = 0; i + 4 <= len; i += 4, n++){
+        int32_t re = (int16_t)(in[i] | (in[i + 1] << 8)) >> 4;
+        int32_t im = (int16_t)(in[i + 2] | (in[i + 3] << 8)) >> 4;
+        power[n] = (uint32_t)(re * re + im * im);
+    }
+    return n;
+}
+
+static size_t level_run_scalar(const unsigned char* samples, size_t n, int shift, int level){
+
+    size_t i = 0;
+
+#ifdef KERNELS_SWAR
+    /* Skip 8 samples per word while the bit keeps level */
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t same = level ? ones : 0;
+
+    for (; i + 8 <= n; i += 8){
+        uint64_t word;
+        memcpy(&word, samples + i, 8);
+        uint64_t diff = ((word >> shift) & ones) ^ same;
+        if (diff != 0){
+            return i + ((size_t)__builtin_ctzll(diff) >> 3);
+        }
+    }
+#endif
+    while (i < n && ((samples[i] >> shift) & 1) == level){
+        i++;
+    }
+    return i;
+}
+
+const cpu_kernels_t kernels_scalar = {
+    power_cu8_scalar,
+    power_cs16_scalar,
+    level_run_scalar
+};
+
+#ifdef KERNELS_X86
+
+/* 8 IQ pairs per 16 bytes, madd sums I*I+Q*Q of each pair */
+TARGET_SSE42 static size_t power_cu8_sse42(const unsigned char* in, size_t len, uint32_t* power){
+
+    const __m128i offset = _mm_set1_epi16(128);
+    size_t        n      = 0;
+    size_t        i      = 0;
+
+    for (; i + 16 <= len; i += 16, n += 8){
+        __m128i bytes = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i lo    = _mm_slli_epi16(_mm_sub_epi16(_mm_cvtepu8_epi16(bytes), offset), 4);
+        __m128i hi    = _mm_slli_epi16(_mm_sub_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8)), offset), 4);
+        _mm_storeu_si128((__m128i*)(power + n),     _mm_madd_epi16(lo, lo));
+        _mm_storeu_si128((__m128i*)(power + n + 4), _mm_madd_epi16(hi, hi));
+    }
+    return n + power_cu8_scalar(in + i, len - i, power + n);
+}
+
+/* 4 IQ pairs per 16 bytes */
+TARGET_SSE42 static size_t power_cs16_sse42(const unsigned char* in, size_t len, uint32_t* power){
+
+    size_t n = 0;
+    size_t i = 0;
+
+    for (; i + 16 <= len; i += 16, n += 4){
+        __m128i iq = _mm_srai_epi16(_mm_loadu_si128((const __m128i*)(in + i)), 4);
+        _mm_storeu_si128((__m128i*)(power + n), _mm_madd_epi16(iq, iq));
+    }
+    return n + power_cs16_scalar(in + i, len - i, power + n);
+}
+
+/* Bit of each byte moved to its sign, 16 samples per movemask */
+TARGET_SSE42 static size_t level_run_sse42(const unsigned char* samples, size_t n, int shift, int level){
+
+    const __m128i  count = _mm_cvtsi32_si128(7 - shift);
+    const uint32_t same  = level ? 0xFFFFu : 0;
+    size_t         i     = 0;
+
+    for (; i + 16 <= n; i += 16){
+        __m128i  bits = _mm_sll_epi16(_mm_loadu_si128((const __m128i*)(samples + i)), count);
+        uint32_t diff = (uint32_t)_mm_movemask_epi8(bits) ^ same;
+        if (diff != 0){
+            return i + (size_t)first_bit(diff);
+        }
+    }
+    return i + level_run_scalar(samples + i, n - i, shift, level);
+}
+
+/* 16 IQ pairs per 32 bytes */
+TARGET_AVX2 static size_t power_cu8_avx2(const unsigned char* in, size_t len, uint32_t* power){
+
+    const __m256i offset = _mm256_set1_epi16(128);
+    size_t        n      = 0;
+    size_t        i      = 0;
+
+    for (; i + 32 <= len; i += 32, n += 16){
+        __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(in + i)));
+        __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(in + i + 16)));
+        lo = _mm256_slli_epi16(_mm256_sub_epi16(lo, offset), 4);
+        hi = _mm256_slli_epi16(_mm256_sub_epi16(hi, offset), 4);
+        _mm256_storeu_si256((__m256i*)(power + n),     _mm256_madd_epi16(lo, lo));
+        _mm256_storeu_si256((__m256i*)(power + n + 8), _mm256_madd_epi16(hi, hi));
+    }
+    return n + power_cu8_scalar(in + i, len - i, power + n);
+}
+
+/* 8 IQ pairs per 32 bytes */
+TARGET_AVX2 static size_t power_cs16_avx2(const unsigned char* in, size_t len, uint32_t* power){
+
+    size_t n = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32, n += 8){
+        __m256i iq = _mm256_srai_epi16(_mm256_loadu_si256((const __m256i*)(in + i)), 4);
+        _mm256_storeu_si256((__m256i*)(power + n), _mm256_madd_epi16(iq, iq));
+    }
+    return n + power_cs16_scalar(in + i, len - i, power + n);
+}
+
+TARGET_AVX2 static size_t level_run_avx2(const unsigned char* samples, size_t n, int shift, int level){
+
+    const __m128i  count = _mm_cvtsi32_si128(7 - shift);
+    const uint32_t same  = level ? 0xFFFFFFFFu : 0;
+    size_t         i     = 0;
+
+    for (; i + 32 <= n; i += 32){
+        __m256i  bits = _mm256_sll_epi16(_mm256_loadu_si256((const __m256i*)(samples + i)), count);
+        uint32_t diff = (uint32_t)_mm256_movemask_epi8(bits) ^ same;
+        if (diff != 0){
+            return i + (size_t)first_bit(diff);
+        }
+    }
+    return i + level_run_scalar(samples + i, n - i, shift, level);
+}
+
+const cpu_kernels_t kernels_sse42 = {
+    power_cu8_sse42,
+    power_cs16_sse42,
+    level_run_sse42
+};
+
+const cpu_kernels_t kernels_avx2 = {
+    power_cu8_avx2,
+    power_cs16_avx2,
+    level_run_avx2
+};
+
+#else
+
+const cpu_kernels_t kernels_sse42 = { NULL, NULL, NULL };
+const cpu_kernels_t kernels_avx2  = { NULL, NULL, NULL };
+
+#endif
+
+#ifdef KERNELS_NEON
+
+/* Power of 4 IQ pairs, I and Q deinterleaved */
+static inline int32x4_t power_neon(int16x4_t re, int16x4_t im){
+    return vmlal_s16(vmull_s16(re, re), im, im);
+}
+
+/* 16 IQ pairs per 32 bytes, deinterleaved by load */
+static size_t power_cu8_neon(const unsigned char* in, size_t len, uint32_t* power){
+
+    const int16x8_t offset = vdupq_n_s16(128);
+    size_t          n      = 0;
+    size_t          i      = 0;
+
+    for (; i + 32 <= len; i += 32, n += 16){
+        uint8x16x2_t iq    = vld2q_u8(in + i);
+        int16x8_t    re_lo = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(iq.val[0]))), offset), 4);
+        int16x8_t    im_lo = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(iq.val[1]))), offset), 4);
+        int16x8_t    re_hi = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(iq.val[0]))), offset), 4);
+        int16x8_t    im_hi = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(iq.val[1]))), offset), 4);
+        vst1q_u32(power + n,      vreinterpretq_u32_s32(power_neon(vget_low_s16(re_lo),  vget_low_s16(im_lo))));
+        vst1q_u32(power + n + 4,  vreinterpretq_u32_s32(power_neon(vget_high_s16(re_lo), vget_high_s16(im_lo))));
+        vst1q_u32(power + n + 8,  vreinterpretq_u32_s32(power_neon(vget_low_s16(re_hi),  vget_low_s16(im_hi))));
+        vst1q_u32(power + n + 12, vreinterpretq_u32_s32(power_neon(vget_high_s16(re_hi), vget_high_s16(im_hi))));
+    }
+    return n + power_cu8_scalar(in + i, len - i, power + n);
+}
+
+/* 8 IQ pairs per 32 bytes, little-endian */
+static size_t power_cs16_neon(const unsigned char* in, size_t len, uint32_t* power){
+
+    size_t n = 0;
+    size_t i = 0;
+
+    for (; i + 32 <= len; i += 32, n += 8){
+        int16x8x2_t iq = vld2q_s16((const int16_t*)(in + i));
+        int16x8_t   re = vshrq_n_s16(iq.val[0], 4);
+        int16x8_t   im = vshrq_n_s16(iq.val[1], 4);
+        vst1q_u32(power + n,     vreinterpretq_u32_s32(power_neon(vget_low_s16(re),  vget_low_s16(im))));
+        vst1q_u32(power + n + 4, vreinterpretq_u32_s32(power_neon(vget_high_s16(re), vget_high_s16(im))));
+    }
+    return n + power_cs16_scalar(in + i, len - i, power + n);
+}
+
+/* 16 samples per test, the block with the edge is left to scalar */
+static size_t level_run_neon(const unsigned char* samples, size_t n, int shift, int level){
+
+    const uint8x16_t mask = vdupq_n_u8((uint8_t)(1 << shift));
+    size_t           i    = 0;
+
+    for (; i + 16 <= n; i += 16){
+        uint8x16_t bits = vtstq_u8(vld1q_u8(samples + i), mask);
+        if (level){
+            bits = vmvnq_u8(bits);
+        }
+        if (vmaxvq_u8(bits) != 0){
+            break;
+        }
+    }
+    return i + level_run_scalar(samples + i, n - i, shift, level);
+}
+
+const cpu_kernels_t kernels_neon = {
+    power_cu8_neon,
+    power_cs16_neon,
+    level_run_neon
+};
+
+#else
+
+const cpu_kernels_t kernels_neon = { NULL, NULL, NULL };
+
+#endif
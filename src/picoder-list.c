@@ -7,6 +7,7 @@
 */
 
 #include "picoder-list.h"
+#include "picoder-stats.h"
 #include <getopt.h>
 
 typedef size_t rsize_t;
@@ -121,6 +122,7 @@ int list_cmd(int argc, char** argv){
         list_help(stdout);
     }else{
         if (error_flag==0){
+            stats_phase(STATS_OUTPUT);
             printf("Encode Protocol             Type      Devices\n");
             printf("-----------------------------------------------------------------------------------\n");
             while (pnode != NULL) {
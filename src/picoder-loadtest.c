@@ -0,0 +1,529 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-loadtest.h"
+#include "picoder-metrics.h"
+#include "picoder-net.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#ifndef MAX_LINE_LENGTH
+#define MAX_LINE_LENGTH     4096
+#endif
+
+#define MAX_CONNECTIONS       256
+#define DEFAULT_DURATION      10
+#define LOADTEST_WINDOW       4096        /* max requests in flight per connection */
+#define LOADTEST_DRAIN        5000000000  /* ns waiting replies after last request */
+#define LOADTEST_RECV         65536
+
+typedef struct {
+    const char*  address;
+    char**       requests;             /* corpus lines with '\n' */
+    size_t*      lengths;
+    size_t       n_requests;
+    double       period;               /* ns between requests of a connection, 0 closed loop */
+    uint64_t     duration;             /* ns */
+    uint64_t     max_requests;         /* total of every connection, 0 no limit */
+} loadtest_t;
+
+typedef struct {
+    const loadtest_t*  lt;
+    int                index;
+    uint64_t           max_requests;       /* share of lt requests, 0 no limit */
+    uint64_t           sent;
+    uint64_t           received;
+    uint64_t           errors;
+    uint64_t           decodes;
+    uint64_t           encodes;
+    uint64_t           max;
+    uint64_t           buckets[METRIC_BUCKETS];
+    bool               failed;
+} client_t;
+
+static struct option list_options[] = {
+  { "connect",     required_argument, NULL,      'c' },
+  { "input",       required_argument, NULL,      'i' },
+  { "connections", required_argument, NULL,      'n' },
+  { "rate",        required_argument, NULL,      'r' },
+  { "duration",    required_argument, NULL,      'd' },
+  { "requests",    required_argument, NULL,      'N' },
+  { "help",        no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void loadtest_help(FILE* out){
+    fprintf(out,"         loadtest [-h] -c host:port -i file           --> load test a 'serve' command\n");
+    fprintf(out,"               [-h | --help]                          --> show command options\n");
+    fprintf(out,"               [-c | --connect host:port]             --> server address\n");
+    fprintf(out,"               [-i | --input file]                    --> requests corpus, 'D <code>' or 'E <json>' lines\n");
+    fprintf(out,"               [-n | --connections n]                 --> concurrent connections (default 1)\n");
+    fprintf(out,"               [-r | --rate req/s]                    --> total open loop rate (default 0, closed loop)\n");
+    fprintf(out,"               [-d | --duration secs]                 --> test duration (default %d)\n", DEFAULT_DURATION);
+    fprintf(out,"               [-N | --requests n]                    --> total requests, ends before duration\n");
+}
+
+#ifndef _WIN32
+
+static bool send_all(int fd, const char* data, size_t len){
+    while (len > 0){
+        ssize_t n = send(fd, data, len, 0);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len  -= (size_t)n;
+    }
+    return true;
+}
+
+/*
+    Open loop sends every request at its intended time, whether or not
+    replies are late, and measures latency from that time so server
+    stalls are not hidden (coordinated omission). Closed loop sends next
+    request on reply.
+*/
+static void* loadtest_client(void* arg){
+
+    client_t*         c      = (client_t*)arg;
+    const loadtest_t* lt     = c->lt;
+    uint64_t*         due    = (uint64_t*)malloc(sizeof(*due) * LOADTEST_WINDOW);
+    char*             rbuf   = (char*)malloc(LOADTEST_RECV);
+    size_t            rlen   = 0;
+    size_t            next   = (size_t)c->index % lt->n_requests;
+    int               fd     = net_connect(lt->address, SOCK_STREAM);
+    int               on     = 1;
+
+    if (fd < 0 || due == NULL || rbuf == NULL){
+        c->failed = true;
+        goto done;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+    uint64_t start = metrics_now();
+    uint64_t end   = start + lt->duration;
+
+    for (;;){
+
+        uint64_t now       = metrics_now();
+        bool     finished  = (now >= end) || (c->max_requests > 0 && c->sent >= c->max_requests);
+        uint64_t in_flight = c->sent - c->received;
+        int      timeout   = 100;
+
+        if (!finished){
+            uint64_t intended = now;
+            if (lt->period > 0){
+                intended = start + (uint64_t)(c->sent * lt->period);
+            }
+            while (intended <= now && in_flight < LOADTEST_WINDOW && !(lt->period == 0 && in_flight > 0)){
+
+                const char* request = lt->requests[next];
+                if (!send_all(fd, request, lt->lengths[next])){
+                    c->failed = true;
+                    goto done;
+                }
+                if (request[0] == 'D'){
+                    c->decodes++;
+                }else{
+                    c->encodes++;
+                }
+                due[c->sent % LOADTEST_WINDOW] = intended;
+                c->sent++;
+                in_flight++;
+                next = (next + 1) % lt->n_requests;
+
+                if ((c->max_requests > 0 && c->sent >= c->max_requests) || lt->period == 0){
+                    break;
+                }
+                intended = start + (uint64_t)(c->sent * lt->period);
+            }
+            if (lt->period > 0 && intended > now){
+                timeout = (int)((intended - now) / 1000000);    /* rounded down, late sends count as latency */
+            }
+        }else if (in_flight == 0 || now >= end + LOADTEST_DRAIN){
+            break;
+        }
+
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, in_flight > 0 || lt->period > 0 ? timeout : 0);
+
+        if (ready < 0 && errno != EINTR){
+            c->failed = true;
+            break;
+        }
+        if (ready <= 0){
+            continue;
+        }
+
+        ssize_t n = recv(fd, rbuf + rlen, LOADTEST_RECV - rlen, 0);
+        if (n <= 0){
+            if (n < 0 && errno == EINTR){
+                continue;
+            }
+            c->failed = true;
+            break;
+        }
+        rlen += (size_t)n;
+        now   = metrics_now();
+
+        /* Complete reply lines, replies come in request order */
+        char* line = rbuf;
+        char* eol;
+        while ((eol = (char*)memchr(line, '\n', rlen - (size_t)(line - rbuf))) != NULL){
+            if (c->received < c->sent){
+                uint64_t latency = now - due[c->received % LOADTEST_WINDOW];
+                c->buckets[metrics_bucket(latency)]++;
+                if (latency > c->max){
+                    c->max = latency;
+                }
+                c->received++;
+            }
+            if (strncmp(line, "ERR", 3) == 0){
+                c->errors++;
+            }
+            line = eol + 1;
+        }
+        rlen -= (size_t)(line - rbuf);
+        memmove(rbuf, line, rlen);
+        if (rlen == LOADTEST_RECV){
+            fprintf(stderr,"error: reply too long\n");
+            c->failed = true;
+            break;
+        }
+    }
+
+done:
+    if (fd >= 0){
+        close(fd);
+    }
+    free(due);
+    free(rbuf);
+
+    return NULL;
+}
+
+static int loadtest_run(loadtest_t* lt, int connections){
+
+    client_t*  clients = (client_t*)calloc((size_t)connections, sizeof(*clients));
+    pthread_t  threads[MAX_CONNECTIONS];
+    uint64_t   buckets[METRIC_BUCKETS];
+    client_t   total;
+    int        started = 0;
+    int        failed  = 0;
+
+    if (clients == NULL){
+        fprintf(stderr,"error: malloc fail\n");
+        return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    uint64_t start = metrics_now();
+
+    for (int i = 0; i < connections; i++){
+        clients[i].lt    = lt;
+        clients[i].index = (int)((lt->n_requests * (size_t)i) / (size_t)connections);
+        /* Remainder of requests spread over first connections */
+        if (lt->max_requests > 0){
+            clients[i].max_requests = lt->max_requests / (uint64_t)connections + ((uint64_t)i < lt->max_requests % (uint64_t)connections);
+        }
+        if (pthread_create(&threads[i], NULL, loadtest_client, &clients[i]) != 0){
+            fprintf(stderr,"error: unable to start connection %d\n",i);
+            break;
+        }
+        started++;
+    }
+
+    memset(&total, 0, sizeof(total));
+    memset(buckets, 0, sizeof(buckets));
+
+    for (int i = 0; i < started; i++){
+        pthread_join(threads[i], NULL);
+        total.sent     += clients[i].sent;
+        total.received += clients[i].received;
+        total.errors   += clients[i].errors;
+        total.decodes  += clients[i].decodes;
+        total.encodes  += clients[i].encodes;
+        if (clients[i].max > total.max){
+            total.max = clients[i].max;
+        }
+        for (int b = 0; b < METRIC_BUCKETS; b++){
+            buckets[b] += clients[i].buckets[b];
+        }
+        if (clients[i].failed){
+            failed++;
+        }
+    }
+
+    double secs = (double)(metrics_now() - start) / 1e9;
+
+    if (lt->period > 0){
+        printf("loadtest: %d connections, open loop %.1f req/s, %.2f secs\n",started,connections * 1e9 / lt->period,secs);
+    }else{
+        printf("loadtest: %d connections, closed loop, %.2f secs\n",started,secs);
+    }
+    printf("loadtest: %llu sent (%llu decode, %llu encode), %llu received, %llu errors, %llu lost, %.1f req/s\n",
+        (unsigned long long)total.sent, (unsigned long long)total.decodes, (unsigned long long)total.encodes,
+        (unsigned long long)total.received, (unsigned long long)total.errors,
+        (unsigned long long)(total.sent - total.received), secs > 0 ? total.received / secs : 0);
+    if (total.received > 0){
+        /* Bucket upper bounds, clamped to the max seen */
+        const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+        double       latency[4];
+        for (int q = 0; q < 4; q++){
+            uint64_t ns = metrics_quantile(buckets, quantiles[q]);
+            latency[q] = (ns < total.max ? ns : total.max) / 1e6;
+        }
+        printf("loadtest: latency ms p50 %.3f p90 %.3f p99 %.3f p99.9 %.3f max %.3f\n",
+            latency[0], latency[1], latency[2], latency[3], total.max / 1e6);
+    }
+
+    free(clients);
+
+    if (failed > 0){
+        fprintf(stderr,"error: %d connections failed\n",failed);
+        return -1;
+    }
+    if (total.errors > 0 || total.sent > total.received){
+        fprintf(stderr,"error: %llu error replies, %llu requests lost\n",
+            (unsigned long long)total.errors, (unsigned long long)(total.sent - total.received));
+        return -1;
+    }
+    return (started == connections) ? 0 : -1;
+}
+
+#endif
+
+/* Load corpus lines in server protocol, returns number of requests or -1 */
+static long loadtest_load(loadtest_t* lt, const char* file){
+
+    FILE*  in      = fopen(file, "r");
+    char   line[MAX_LINE_LENGTH];
+    size_t size    = 0;
+    long   skipped = 0;
+
+    if (in == NULL){
+        fprintf(stderr,"error: unable to open file \"%s\"\n",file);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL){
+
+        size_t len = strlen(line);
+        while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r')){
+            line[--len] = '\0';
+        }
+        if (len < 3 || (line[0] != 'D' && line[0] != 'E') || line[1] != ' '){
+            skipped += (len > 0) ? 1 : 0;
+            continue;
+        }
+
+        if (lt->n_requests == size){
+            size = size ? size * 2 : 256;
+            char**  requests = (char**)realloc(lt->requests, sizeof(*requests) * size);
+            size_t* lengths  = (requests != NULL) ? (size_t*)realloc(lt->lengths, sizeof(*lengths) * size) : NULL;
+            if (requests != NULL){
+                lt->requests = requests;
+            }
+            if (lengths == NULL){
+                fclose(in);
+                fprintf(stderr,"error: malloc fail\n");
+                return -1;
+            }
+            lt->lengths = lengths;
+        }
+
+        line[len++] = '\n';
+        char* request = (char*)malloc(len + 1);
+        if (request == NULL){
+            fclose(in);
+            fprintf(stderr,"error: malloc fail\n");
+            return -1;
+        }
+        memcpy(request, line, len);
+        request[len] = '\0';
+        lt->requests[lt->n_requests] = request;
+        lt->lengths[lt->n_requests]  = len;
+        lt->n_requests++;
+    }
+
+    fclose(in);
+
+    if (skipped > 0){
+        fprintf(stderr,"loadtest: %ld invalid corpus lines skipped\n",skipped);
+    }
+
+    return (long)lt->n_requests;
+}
+
+int loadtest_cmd(int argc, char** argv){
+
+    char*   address     = NULL;
+    char*   input       = NULL;
+    int     connections = 1;
+    double  rate        = 0;
+    double  duration    = DEFAULT_DURATION;
+    long    requests    = 0;
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    if (argc > 1){
+        while ((ch = getopt_long(argc, argv, "c:i:n:r:d:N:h", list_options, NULL)) != -1) {
+
+            switch (ch) {
+                case 'c':
+                    if (address == NULL){
+                        address = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one server address is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'i':
+                    if (input == NULL){
+                        input = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one input file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'n':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_CONNECTIONS)){
+                        connections = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: connections must be > 0 and <= %d\n", MAX_CONNECTIONS);
+                        error_flag--;
+                    }
+                    break;
+                case 'r':
+                    if (atof(optarg) >= 0){
+                        rate = atof(optarg);
+                    }else{
+                        fprintf(stderr,"error: rate must be >= 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'd':
+                    if (atof(optarg) > 0){
+                        duration = atof(optarg);
+                    }else{
+                        fprintf(stderr,"error: duration must be > 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'N':
+                    if (atol(optarg) > 0){
+                        requests = atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: requests must be > 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'h':
+                    help_flag = true;
+                    break;
+                case 1:
+                    /*
+                    * Use this case if getopt_long() should go through all
+                    * arguments. If so, add a leading '-' character to optstring.
+                    * Actual code, if any, goes here.
+                    */
+                    break;
+                case ':':   /* missing option argument */
+                    //fprintf(stderr, "error: option '-%c' requires an argument\n", optopt);
+                    error_flag--;
+                    break;
+                case '?':
+                default:    /* invalid option */
+                    //fprintf(stderr, "error: option '-%c' is invalid\n", optopt);
+                    error_flag--;
+                    break;
+            }
+        }
+
+        if (optind < argc) {
+            fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+            while (optind < argc){
+                fprintf(stderr," %s", argv[optind++]);
+                error_flag--;
+            }
+            fprintf(stderr,"\n");
+        }
+
+        if (help_flag){
+            printf("command:\n");
+            loadtest_help(stdout);
+        }else{
+
+            if (address == NULL || input == NULL){
+                fprintf(stderr,"error: -c host:port and -i file are required\n");
+                error_flag--;
+            }
+            if (error_flag == 0 && requests > 0 && requests < connections){
+                fprintf(stderr,"error: requests must be >= connections\n");
+                error_flag--;
+            }
+
+            if (error_flag == 0){
+
+                loadtest_t lt;
+                memset(&lt, 0, sizeof(lt));
+                lt.address      = address;
+                lt.period       = (rate > 0) ? (1e9 * connections) / rate : 0;
+                lt.duration     = (uint64_t)(duration * 1e9);
+                lt.max_requests = (uint64_t)requests;
+
+                if (loadtest_load(&lt, input) <= 0){
+                    if (lt.n_requests == 0){
+                        fprintf(stderr,"error: no requests in \"%s\"\n",input);
+                    }
+                    error_flag--;
+                }
+#ifndef _WIN32
+                if (error_flag == 0){
+                    error_flag = loadtest_run(&lt, connections);
+                }
+#else
+                if (error_flag == 0){
+                    fprintf(stderr,"error: loadtest is not supported on Windows\n");
+                    error_flag--;
+                }
+#endif
+                for (size_t i = 0; i < lt.n_requests; i++){
+                    free(lt.requests[i]);
+                }
+                free(lt.requests);
+                free(lt.lengths);
+            }
+        }
+    }else{
+        fprintf(stderr,"error: -c host:port and -i file are required\n");
+        error_flag--;
+    }
+
+    return error_flag;
+}
@@ -0,0 +1,284 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-input.h"
+#include "picoder-cpu.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#define VCD_TOKEN_LENGTH    256
+
+/* Edge to edge durations in blocks of pulses */
+typedef struct {
+    uint32_t*      block;
+    size_t         n_block;
+    uint32_t       max_pulse;
+    input_block_t  callback;
+    void*          ctx;
+} edges_t;
+
+static bool edges_init(edges_t* e, uint32_t max_pulse, input_block_t callback, void* ctx){
+    e->block     = (uint32_t*)malloc(sizeof(*e->block) * INPUT_BLOCK);
+    e->n_block   = 0;
+    e->max_pulse = max_pulse;
+    e->callback  = callback;
+    e->ctx       = ctx;
+    if (e->block == NULL){
+        fprintf(stderr,"error: malloc fail!\n");
+    }
+    return e->block != NULL;
+}
+
+/* Duration in uSecs, at least 1 to keep levels alternating */
+static void edges_emit(edges_t* e, double us){
+    uint32_t pulse = (us >= (double)e->max_pulse) ? e->max_pulse : (uint32_t)(us + 0.5);
+    e->block[e->n_block++] = pulse > 0 ? pulse : 1;
+    if (e->n_block == INPUT_BLOCK){
+        e->callback(e->ctx, e->block, e->n_block);
+        e->n_block = 0;
+    }
+}
+
+static void edges_end(edges_t* e){
+    if (e->n_block > 0){
+        e->callback(e->ctx, e->block, e->n_block);
+    }
+    free(e->block);
+}
+
+/* Whitespace separated tokens of a chunked stream */
+typedef struct {
+    FILE*   in;
+    char*   chunk;
+    size_t  len;
+    size_t  pos;
+} tokens_t;
+
+/* Next token, truncated to size - 1, returns its length or 0 at end */
+static size_t next_token(tokens_t* t, char* token, size_t size){
+
+    size_t len = 0;
+
+    for (;;){
+        if (t->pos == t->len){
+            t->len = fread(t->chunk, 1, INPUT_CHUNK, t->in);
+            t->pos = 0;
+            if (t->len == 0){
+                break;
+            }
+        }
+        char c = t->chunk[t->pos++];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r'){
+            if (len > 0){
+                break;
+            }
+        }else if (len < size - 1){
+            token[len++] = c;
+        }
+    }
+    token[len] = '\0';
+    return len;
+}
+
+/* uSecs of '$timescale' number and unit, 0 if invalid */
+static double vcd_timescale(const char* text){
+
+    static const char*  units[]  = { "s", "ms", "us", "ns", "ps", "fs" };
+    static const double scales[] = { 1e6, 1e3, 1.0, 1e-3, 1e-6, 1e-9 };
+    char*               unit;
+    double              value    = strtod(text, &unit);
+
+    for (size_t i = 0; i < sizeof(units) / sizeof(units[0]); i++){
+        if (value > 0 && strcmp(unit, units[i]) == 0){
+            return value * scales[i];
+        }
+    }
+    return 0;
+}
+
+int input_read_vcd(FILE* in, const char* channel, uint32_t max_pulse, input_block_t callback, void* ctx){
+
+    tokens_t  t         = { in, (char*)malloc(INPUT_CHUNK), 0, 0 };
+    edges_t   e;
+    char      token[VCD_TOKEN_LENGTH];
+    char      id[VCD_TOKEN_LENGTH] = "";
+    double    scale     = 1e-3;     /* default 1ns */
+    uint64_t  time      = 0;
+    uint64_t  edge_time = 0;
+    int       level     = -1;       /* unknown */
+    bool      edge      = false;
+    bool      defined   = false;    /* $enddefinitions read */
+    int       result    = 0;
+
+    if (t.chunk == NULL || !edges_init(&e, max_pulse, callback, ctx)){
+        free(t.chunk);
+        return -1;
+    }
+
+    while (result == 0 && next_token(&t, token, sizeof(token)) > 0){
+
+        if (token[0] == '$'){
+
+            if (strcmp(token, "$timescale") == 0){
+                char text[VCD_TOKEN_LENGTH] = "";
+                while (next_token(&t, token, sizeof(token)) > 0 && strcmp(token, "$end") != 0){
+                    strncat(text, token, sizeof(text) - strlen(text) - 1);
+                }
+                scale = vcd_timescale(text);
+                if (scale <= 0){
+                    fprintf(stderr,"error: invalid vcd timescale '%s'\n",text);
+                    result = -1;
+                }
+            }else if (strcmp(token, "$var") == 0){
+                /* $var type size identifier reference [index] $end */
+                char fields[4][VCD_TOKEN_LENGTH];
+                int  n = 0;
+                while (next_token(&t, token, sizeof(token)) > 0 && strcmp(token, "$end") != 0){
+                    if (n < 4){
+                        strcpy(fields[n], token);
+                    }
+                    n++;
+                }
+                if (n >= 4 && id[0] == '\0' && (channel != NULL ? (strcmp(fields[3], channel) == 0 || strcmp(fields[2], channel) == 0)
+                                                                : strcmp(fields[1], "1") == 0)){
+                    strcpy(id, fields[2]);
+                }
+            }else if (strcmp(token, "$enddefinitions") == 0){
+                defined = true;
+                if (id[0] == '\0'){
+                    fprintf(stderr,"error: vcd signal '%s' not found\n", channel != NULL ? channel : "1 bit");
+                    result = -1;
+                }
+            }else if (strncmp(token, "$dump", 5) != 0 && strcmp(token, "$end") != 0){
+                /* $comment, $date, $version, $scope, $upscope... */
+                while (next_token(&t, token, sizeof(token)) > 0 && strcmp(token, "$end") != 0);
+            }
+            continue;
+        }
+
+        if (!defined){
+            continue;
+        }
+
+        const char* code  = NULL;
+        int         value = -1;
+
+        if (token[0] == '#'){
+            time = strtoull(token + 1, NULL, 10);
+            continue;
+        }else if (token[0] == 'b' || token[0] == 'B'){
+            /* Vector, lowest bit */
+            char last = token[strlen(token) - 1];
+            value = (last == '1') ? 1 : (last == '0' ? 0 : -1);
+            code  = (next_token(&t, token, sizeof(token)) > 0) ? token : NULL;
+        }else if (token[0] == 'r' || token[0] == 'R'){
+            value = (strtod(token + 1, NULL) != 0) ? 1 : 0;
+            code  = (next_token(&t, token, sizeof(token)) > 0) ? token : NULL;
+        }else{
+            value = (token[0] == '1') ? 1 : (token[0] == '0' ? 0 : -1);
+            code  = token + 1;
+        }
+
+        if (code == NULL || value < 0 || strcmp(code, id) != 0 || value == level){
+            continue;
+        }
+        if (level >= 0){
+            if (edge){
+                edges_emit(&e, (double)(time - edge_time) * scale);
+            }
+            edge_time = time;
+            edge      = true;
+        }
+        level = value;
+    }
+
+    /* Level kept up to last time */
+    if (result == 0 && edge && time > edge_time){
+        edges_emit(&e, (double)(time - edge_time) * scale);
+    }
+    if (result == 0 && !defined){
+        fprintf(stderr,"error: invalid vcd, no $enddefinitions\n");
+        result = -1;
+    }
+
+    edges_end(&e);
+    free(t.chunk);
+
+    return (result == 0 && !ferror(in)) ? 0 : -1;
+}
+
+int input_read_logic(FILE* in, int channel, int unitsize, double samplerate, uint32_t max_pulse, input_block_t callback, void* ctx){
+
+    size_t         size  = INPUT_CHUNK - INPUT_CHUNK % (size_t)unitsize;
+    unsigned char* chunk = (unsigned char*)malloc(size);
+    edges_t        e;
+    double         us    = 1e6 / samplerate;    /* per sample */
+    size_t         byte  = (size_t)channel / 8;
+    int            shift = channel % 8;
+    uint64_t       run   = 0;                   /* samples at level */
+    int            level = -1;
+    bool           edge  = false;
+    size_t         len;
+
+    if (channel < 0 || channel >= unitsize * 8){
+        fprintf(stderr,"error: logic channel must be >= 0 and < %d\n",unitsize * 8);
+        free(chunk);
+        return -1;
+    }
+    if (chunk == NULL || !edges_init(&e, max_pulse, callback, ctx)){
+        free(chunk);
+        return -1;
+    }
+
+    while ((len = fread(chunk, 1, size, in)) > 0){
+
+        size_t n = len / (size_t)unitsize;
+        size_t i = 0;
+
+        if (level < 0 && n > 0){
+            level = (chunk[byte] >> shift) & 1;
+        }
+
+        while (i < n){
+            if (unitsize == 1){
+                /* Samples while the channel bit keeps level */
+                size_t k = cpu_kernels.level_run(chunk + i, n - i, shift, level);
+                run += k;
+                i   += k;
+            }else
+            {
+                while (i < n && ((chunk[i * (size_t)unitsize + byte] >> shift) & 1) == level){
+                    run++;
+                    i++;
+                }
+            }
+
+            if (i < n){
+                /* Edge at sample i */
+                if (edge){
+                    edges_emit(&e, (double)run * us);
+                }
+                edge  = true;
+                level ^= 1;
+                run   = 1;
+                i++;
+            }
+        }
+    }
+
+    if (edge && run > 0){
+        edges_emit(&e, (double)run * us);
+    }
+
+    edges_end(&e);
+    free(chunk);
+
+    return ferror(in) ? -1 : 0;
+}
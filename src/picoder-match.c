@@ -0,0 +1,213 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-match.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#define EVEN_BITS    0x5555555555555555ULL
+
+#if defined(__GNUC__)
+#define match_popcount(x)    __builtin_popcountll(x)
+#define match_ctz(x)         __builtin_ctzll(x)
+#else
+static int match_ctz(uint64_t x){
+    int n = 0;
+    while ((x & 1) == 0){
+        x >>= 1;
+        n++;
+    }
+    return n;
+}
+
+static int match_popcount(uint64_t x){
+    x = x - ((x >> 1) & EVEN_BITS);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+#endif
+
+/* Mask of first 'bits' bits of word w */
+static uint64_t word_mask(int bits, int w){
+    int left = bits - w * 64;
+    return (left >= 64) ? ~0ULL : (left <= 0) ? 0 : ((1ULL << left) - 1);
+}
+
+bool match_desc(const match_desc_t* desc, const frame_view_t* view, const uint32_t* pulses, int n_pulses){
+
+    if (desc->rawlen != 0 && n_pulses != desc->rawlen && (n_pulses < desc->min_pulses || n_pulses > desc->max_pulses)){
+        return false;
+    }
+    if (desc->max_footer != 0 && (pulses[n_pulses - 1] < desc->min_footer || pulses[n_pulses - 1] > desc->max_footer)){
+        return false;
+    }
+    if (desc->flags == 0 || view->n_clusters == 0){
+        return true;
+    }
+
+    int      words  = (n_pulses + 63) / 64;
+    int      paired = ((n_pulses - 1) / 2) * 2;     /* pulses in whole pairs, footer out */
+    unsigned ones   = 0;
+
+    for (int w = 0; w < words; w++){
+
+        uint64_t longs = view->longs[w];
+
+        if (desc->flags & MATCH_PAIRS){
+            uint64_t pairs   = word_mask(paired, w) & EVEN_BITS;
+            uint64_t shorts  = view->shorts[w];
+            uint64_t classed = shorts | longs;
+            /* Both pulses classified and exactly one long */
+            if ((classed & (classed >> 1) & (longs ^ (longs >> 1)) & pairs) != pairs){
+                return false;
+            }
+        }
+        if ((desc->flags & MATCH_BITS) && (longs & desc->mask[w]) != desc->value[w]){
+            return false;
+        }
+        if (desc->flags & MATCH_PARITY){
+            ones += (unsigned)match_popcount(longs & desc->parity_mask[w]);
+        }
+    }
+
+    return !(desc->flags & MATCH_PARITY) || (ones & 1) == desc->parity;
+}
+
+bool match_any(match_set_t* set, const frame_view_t* view, const uint32_t* pulses, int n_pulses){
+
+    if (n_pulses > 0){
+        for (int i = 0; i < set->count; i++){
+            if (match_desc(&set->descs[i], view, pulses, n_pulses)){
+                set->accepted++;
+                return true;
+            }
+        }
+    }
+    set->rejected++;
+
+    return false;
+}
+
+bool match_set_build(match_set_t* set){
+
+    int count = 0;
+
+    memset(set, 0, sizeof(*set));
+
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL; pnode = pnode->next){
+        count++;
+    }
+    set->descs = (match_desc_t*)calloc((size_t)(count ? count : 1), sizeof(*set->descs));
+
+    if (set->descs == NULL){
+        return false;
+    }
+
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL; pnode = pnode->next){
+
+        protocol_t*   protocol = pnode->listener;
+        match_desc_t* desc     = &set->descs[set->count++];
+
+        desc->protocol   = protocol;
+        desc->rawlen     = (uint16_t)protocol->rawlen;
+        desc->min_pulses = (uint16_t)protocol->minrawlen;
+        desc->max_pulses = (uint16_t)protocol->maxrawlen;
+        if (desc->rawlen == 0 && desc->max_pulses != 0){
+            desc->rawlen = desc->min_pulses;
+        }
+        set->views = set->views || desc->flags != 0;
+    }
+
+    return true;
+}
+
+void match_set_free(match_set_t* set){
+    free(set->descs);
+    memset(set, 0, sizeof(*set));
+}
+
+bool match_stream_init(match_stream_t* stream, match_set_t* set){
+
+    memset(stream, 0, sizeof(*stream));
+
+    stream->set   = set;
+    stream->words = (set->count + 63) / 64;
+    stream->rows  = FRAME_VIEW_PULSES + 2;
+    stream->alive = (uint64_t*)calloc((size_t)(stream->words ? stream->words : 1), sizeof(uint64_t));
+    stream->fits  = (uint64_t*)calloc((size_t)stream->rows * (size_t)(stream->words ? stream->words : 1), sizeof(uint64_t));
+
+    if (stream->alive == NULL || stream->fits == NULL){
+        match_stream_free(stream);
+        return false;
+    }
+
+    for (int i = 0; i < set->count; i++){
+
+        const match_desc_t* desc = &set->descs[i];
+        uint64_t            bit  = 1ULL << (i & 63);
+
+        /* Longest frame accepted, any length if not set */
+        int max = (desc->rawlen == 0) ? stream->rows : (desc->max_pulses > desc->rawlen ? desc->max_pulses : desc->rawlen);
+
+        for (int row = 0; row < stream->rows && row <= max; row++){
+            stream->fits[row * stream->words + (i >> 6)] |= bit;
+        }
+    }
+    match_stream_reset(stream);
+
+    return true;
+}
+
+void match_stream_free(match_stream_t* stream){
+    free(stream->alive);
+    free(stream->fits);
+    memset(stream, 0, sizeof(*stream));
+}
+
+void match_stream_reset(match_stream_t* stream){
+    /* Row 0 has every candidate */
+    memcpy(stream->alive, stream->fits, sizeof(*stream->alive) * (size_t)stream->words);
+    stream->none = (stream->set->count == 0);
+}
+
+bool match_stream_push(match_stream_t* stream, int n_pulses){
+
+    int       row  = (n_pulses + 1 < stream->rows) ? n_pulses + 1 : stream->rows - 1;   /* footer still to come */
+    uint64_t* fits = stream->fits + row * stream->words;
+    uint64_t  any  = 0;
+
+    for (int w = 0; w < stream->words; w++){
+        uint64_t alive = stream->alive[w] & fits[w];
+        stream->alive[w] = alive;
+        any |= alive;
+    }
+    stream->none = (any == 0);
+
+    return !stream->none;
+}
+
+bool match_stream_end(match_stream_t* stream, const frame_view_t* view, const uint32_t* pulses, int n_pulses){
+
+    match_set_t* set = stream->set;
+
+    for (int w = 0; w < stream->words; w++){
+        for (uint64_t alive = stream->alive[w]; alive != 0; alive &= alive - 1){
+            int i = w * 64 + match_ctz(alive);
+            if (match_desc(&set->descs[i], view, pulses, n_pulses)){
+                set->accepted++;
+                return true;
+            }
+        }
+    }
+    set->rejected++;
+
+    return false;
+}
@@ -0,0 +1,94 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_MATCH_H
+#define PICODER_MATCH_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#include "picoder-frame.h"
+
+#define MATCH_PAIRS     0x01    /* every pulse pair is one short and one long pulse */
+#define MATCH_BITS      0x02    /* long pulses masked by mask are value */
+#define MATCH_PARITY    0x04    /* long pulses masked by parity_mask have parity */
+
+/*
+    Match descriptor of a protocol, a frame it rejects can not be decoded by
+    the protocol. Bit vectors are over long pulses of the frame view, bit i
+    of word i / 64, and only checked if the frame is classified.
+*/
+typedef struct {
+    protocol_t*  protocol;
+    uint16_t     rawlen;                         /* 0 if any, else exact or min..max */
+    uint16_t     min_pulses;
+    uint16_t     max_pulses;
+    uint32_t     min_footer;                     /* 0 if any */
+    uint32_t     max_footer;
+    uint8_t      flags;
+    uint8_t      parity;                         /* 0 even, 1 odd */
+    uint64_t     mask[FRAME_VIEW_WORDS];
+    uint64_t     value[FRAME_VIEW_WORDS];
+    uint64_t     parity_mask[FRAME_VIEW_WORDS];
+} match_desc_t;
+
+typedef struct {
+    match_desc_t*  descs;
+    int            count;
+    bool           views;        /* some descriptor checks the frame view */
+    uint64_t       accepted;     /* frames matched by a descriptor */
+    uint64_t       rejected;     /* frames matched by none */
+} match_set_t;
+
+/*
+    Build descriptors of every protocol from the lengths it sets, the only
+    condition decodePulseTrain() enforces for every parser. Footer gaps are
+    checked by each parser, if at all, and bit rules learned from clustered
+    sample codes could reject jittered frames parsers decode with their
+    fixed thresholds, so neither is set.
+*/
+bool match_set_build(match_set_t* set);
+
+void match_set_free(match_set_t* set);
+
+/* Check descriptor, view must be built from pulses (n_clusters 0 if not classified) */
+bool match_desc(const match_desc_t* desc, const frame_view_t* view, const uint32_t* pulses, int n_pulses);
+
+/* Returns true if any descriptor matches frame, counted as accepted or rejected */
+bool match_any(match_set_t* set, const frame_view_t* view, const uint32_t* pulses, int n_pulses);
+
+/*
+    Incremental match of a frame as its pulses arrive: candidates are only
+    dropped when the frame gets longer than they accept. A 20% cluster can
+    hold two pulses on both sides of a parser threshold, so pulse structure
+    is not checked until the footer, where the surviving candidates are
+    checked against the finished view.
+*/
+typedef struct {
+    match_set_t*  set;
+    int           words;        /* candidate bitset words */
+    uint64_t*     alive;
+    uint64_t*     fits;         /* candidates accepting frames of at least L pulses, row L */
+    int           rows;         /* fits rows, last one is for longer frames */
+    bool          none;         /* no candidate left, frame will be rejected */
+} match_stream_t;
+
+bool match_stream_init(match_stream_t* stream, match_set_t* set);
+
+void match_stream_free(match_stream_t* stream);
+
+/* Start a new frame, every candidate alive */
+void match_stream_reset(match_stream_t* stream);
+
+/* Advance candidates to a frame of n_pulses so far, footer still to come. Returns false if none left */
+bool match_stream_push(match_stream_t* stream, int n_pulses);
+
+/* Footer pushed and view finished, check survivors. Counted as accepted or rejected */
+bool match_stream_end(match_stream_t* stream, const frame_view_t* view, const uint32_t* pulses, int n_pulses);
+
+#endif
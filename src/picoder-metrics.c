@@ -0,0 +1,473 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-metrics.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+static const char* counter_names[METRIC_COUNTERS][2] = {
+    { "picoder_frames_in_total",       "Frames segmented from input" },
+    { "picoder_frames_out_total",      "Frames decoded" },
+    { "picoder_decode_misses_total",   "Frames without protocol match" },
+    { "picoder_decode_errors_total",   "Frames failed to decode or output" },
+    { "picoder_table_hits_total",      "Lookup table hits" },
+    { "picoder_table_misses_total",    "Lookup table misses" }
+};
+
+static const char* stage_names[METRIC_STAGES] = { "segment", "decode", "emit" };
+
+static const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+/* Prometheus buckets at powers of two, 1 uSec to 68 secs */
+#define BUCKET_FIRST_POWER   10
+#define BUCKET_LAST_POWER    36
+
+static uint64_t name_hash(const char* name, size_t len){
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++){
+        hash ^= (uint8_t)name[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static int log2_floor(uint64_t value){
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int log = 0;
+    while (value >>= 1){
+        log++;
+    }
+    return log;
+#endif
+}
+
+int metrics_bucket(uint64_t ns){
+    /* Buckets hold (lower, upper], so 2^power ends the bucket below it as Prometheus le bounds */
+    ns -= (ns > 0);
+    if (ns < METRIC_SUB_BUCKETS){
+        return (int)ns;
+    }
+    int e     = log2_floor(ns);
+    int index = (e - 2) * METRIC_SUB_BUCKETS + (int)((ns >> (e - 3)) & (METRIC_SUB_BUCKETS - 1));
+    return index < METRIC_BUCKETS ? index : METRIC_BUCKETS - 1;
+}
+
+uint64_t metrics_bucket_upper(int index){
+    if (index < METRIC_SUB_BUCKETS){
+        return (uint64_t)index + 1;
+    }
+    int e   = index / METRIC_SUB_BUCKETS + 2;
+    int sub = index % METRIC_SUB_BUCKETS;
+    return (uint64_t)(METRIC_SUB_BUCKETS + sub + 1) << (e - 3);
+}
+
+uint64_t metrics_quantile(const uint64_t* buckets, double quantile){
+
+    uint64_t count = 0;
+    uint64_t seen  = 0;
+    int      b     = 0;
+
+    for (int i = 0; i < METRIC_BUCKETS; i++){
+        count += buckets[i];
+    }
+    if (count == 0){
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(quantile * (double)count);
+    while (b < METRIC_BUCKETS - 1 && (seen += buckets[b]) <= rank){
+        b++;
+    }
+    return metrics_bucket_upper(b);
+}
+
+metrics_t* metrics_new(void){
+
+    metrics_t* metrics = (metrics_t*)calloc(1, sizeof(*metrics));
+    size_t     n_slots = 16;
+
+    if (metrics == NULL){
+        return NULL;
+    }
+
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL; pnode = pnode->next){
+        metrics->n_protocols++;
+    }
+    while (n_slots < metrics->n_protocols * 2){
+        n_slots *= 2;
+    }
+
+    metrics->names = (const char**)calloc(metrics->n_protocols + 1, sizeof(*metrics->names));
+    metrics->slots = (uint16_t*)calloc(n_slots, sizeof(*metrics->slots));
+    metrics->mask  = n_slots - 1;
+
+    if (metrics->names == NULL || metrics->slots == NULL){
+        free(metrics->names);
+        free(metrics->slots);
+        free(metrics);
+        return NULL;
+    }
+
+    size_t i = 0;
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL; pnode = pnode->next, i++){
+        const char* name = pnode->listener->id;
+        size_t      slot = (size_t)name_hash(name, strlen(name)) & metrics->mask;
+        while (metrics->slots[slot] != 0){
+            slot = (slot + 1) & metrics->mask;
+        }
+        metrics->names[i]    = name;
+        metrics->slots[slot] = (uint16_t)(i + 1);
+    }
+
+#ifndef _WIN32
+    pthread_mutex_init(&metrics->lock, NULL);
+    pthread_cond_init(&metrics->stop, NULL);
+#endif
+
+    return metrics;
+}
+
+metrics_shard_t* metrics_shard(metrics_t* metrics){
+
+    metrics_shard_t* shard = (metrics_shard_t*)calloc(1, sizeof(*shard));
+
+    if (shard == NULL){
+        return NULL;
+    }
+    shard->matches = (uint64_t*)calloc(metrics->n_protocols + 1, sizeof(*shard->matches));
+    if (shard->matches == NULL){
+        free(shard);
+        return NULL;
+    }
+
+#ifndef _WIN32
+    pthread_mutex_lock(&metrics->lock);
+#endif
+    shard->next     = metrics->shards;
+    metrics->shards = shard;
+#ifndef _WIN32
+    pthread_mutex_unlock(&metrics->lock);
+#endif
+
+    return shard;
+}
+
+uint64_t metrics_now(void){
+    struct timespec ts;
+#ifndef _WIN32
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_inc(metrics_shard_t* shard, metric_counter_t counter){
+    METRIC_ADD(shard->counters[counter], 1);
+}
+
+void metrics_observe(metrics_shard_t* shard, metric_stage_t stage, uint64_t ns){
+    METRIC_ADD(shard->buckets[stage][metrics_bucket(ns)], 1);
+    METRIC_ADD(shard->sums[stage], ns);
+}
+
+static const char* skip_space(const char* p){
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'){
+        p++;
+    }
+    return p;
+}
+
+/* Skip json object or array, returns next char or NULL */
+static const char* skip_value(const char* p){
+
+    int  depth     = 0;
+    bool in_string = false;
+
+    for (; *p != '\0'; p++){
+        if (in_string){
+            if (*p == '\\' && p[1] != '\0'){
+                p++;
+            }else if (*p == '"'){
+                in_string = false;
+            }
+        }else if (*p == '"'){
+            in_string = true;
+        }else if (*p == '{' || *p == '['){
+            depth++;
+        }else if ((*p == '}' || *p == ']') && --depth == 0){
+            return p + 1;
+        }
+    }
+    return NULL;
+}
+
+void metrics_match(metrics_t* metrics, metrics_shard_t* shard, const char* json){
+
+    /* Scan keys of "protocols" array objects, no json tree build */
+    const char* p = strstr(json, "\"protocols\"");
+
+    p = (p != NULL) ? strchr(p, '[') : NULL;
+    p = (p != NULL) ? skip_space(p + 1) : NULL;
+
+    while (p != NULL && *p == '{'){
+
+        const char* name = skip_space(p + 1);
+        const char* end  = (*name == '"') ? strchr(name + 1, '"') : NULL;
+
+        if (end != NULL){
+            size_t len  = (size_t)(end - name - 1);
+            size_t slot = (size_t)name_hash(name + 1, len) & metrics->mask;
+            while (metrics->slots[slot] != 0){
+                size_t index = metrics->slots[slot] - 1;
+                if (strncmp(metrics->names[index], name + 1, len) == 0 && metrics->names[index][len] == '\0'){
+                    METRIC_ADD(shard->matches[index], 1);
+                    break;
+                }
+                slot = (slot + 1) & metrics->mask;
+            }
+        }
+
+        p = skip_value(p);
+        p = (p != NULL) ? skip_space(p) : NULL;
+        if (p != NULL && *p == ','){
+            p = skip_space(p + 1);
+        }
+    }
+}
+
+/* Sum of every shard */
+static void metrics_sum(metrics_t* metrics, metrics_shard_t* total){
+
+#ifndef _WIN32
+    pthread_mutex_lock(&metrics->lock);
+#endif
+    for (metrics_shard_t* shard = metrics->shards; shard != NULL; shard = shard->next){
+        for (int c = 0; c < METRIC_COUNTERS; c++){
+            total->counters[c] += METRIC_LOAD(shard->counters[c]);
+        }
+        for (int s = 0; s < METRIC_STAGES; s++){
+            for (int b = 0; b < METRIC_BUCKETS; b++){
+                total->buckets[s][b] += METRIC_LOAD(shard->buckets[s][b]);
+            }
+            total->sums[s] += METRIC_LOAD(shard->sums[s]);
+        }
+        for (size_t p = 0; p < metrics->n_protocols; p++){
+            total->matches[p] += METRIC_LOAD(shard->matches[p]);
+        }
+    }
+#ifndef _WIN32
+    pthread_mutex_unlock(&metrics->lock);
+#endif
+}
+
+static void write_histograms(FILE* out, const metrics_shard_t* total){
+
+    fprintf(out,"# HELP picoder_stage_seconds Latency of frame processing stages\n");
+    fprintf(out,"# TYPE picoder_stage_seconds histogram\n");
+
+    for (int s = 0; s < METRIC_STAGES; s++){
+
+        uint64_t count = 0;
+        int      b     = 0;
+
+        for (int power = BUCKET_FIRST_POWER; power <= BUCKET_LAST_POWER; power++){
+            /* Buckets under 2^power end at its first sub-bucket */
+            for (; b < (power - 2) * METRIC_SUB_BUCKETS; b++){
+                count += total->buckets[s][b];
+            }
+            fprintf(out,"picoder_stage_seconds_bucket{stage=\"%s\",le=\"%g\"} %llu\n", stage_names[s], (double)(1ULL << power) / 1e9, (unsigned long long)count);
+        }
+        for (; b < METRIC_BUCKETS; b++){
+            count += total->buckets[s][b];
+        }
+        fprintf(out,"picoder_stage_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %llu\n", stage_names[s], (unsigned long long)count);
+        fprintf(out,"picoder_stage_seconds_sum{stage=\"%s\"} %.9f\n", stage_names[s], (double)total->sums[s] / 1e9);
+        fprintf(out,"picoder_stage_seconds_count{stage=\"%s\"} %llu\n", stage_names[s], (unsigned long long)count);
+    }
+
+    /* Full log-linear resolution only for quantiles */
+    fprintf(out,"# HELP picoder_stage_quantile_seconds Latency quantiles of frame processing stages\n");
+    fprintf(out,"# TYPE picoder_stage_quantile_seconds gauge\n");
+
+    for (int s = 0; s < METRIC_STAGES; s++){
+
+        uint64_t count = 0;
+        for (int b = 0; b < METRIC_BUCKETS; b++){
+            count += total->buckets[s][b];
+        }
+        if (count == 0){
+            continue;
+        }
+        for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++){
+            fprintf(out,"picoder_stage_quantile_seconds{stage=\"%s\",quantile=\"%g\"} %g\n", stage_names[s], quantiles[q],
+                    (double)metrics_quantile(total->buckets[s], quantiles[q]) / 1e9);
+        }
+    }
+}
+
+int metrics_write(metrics_t* metrics, const char* file){
+
+    metrics_shard_t* total = (metrics_shard_t*)calloc(1, sizeof(*total));
+    size_t           len   = strlen(file);
+    char*            temp  = (char*)malloc(len + 5);
+    FILE*            out   = NULL;
+    int              error = 0;
+
+    if (total != NULL){
+        total->matches = (uint64_t*)calloc(metrics->n_protocols + 1, sizeof(*total->matches));
+    }
+    if (total == NULL || total->matches == NULL || temp == NULL){
+        error = -1;
+    }else{
+        metrics_sum(metrics, total);
+
+        /* Write aside and rename, readers never see a partial file */
+        memcpy(temp, file, len);
+        memcpy(temp + len, ".tmp", 5);
+        out = fopen(temp, "w");
+        if (out == NULL){
+            error = -1;
+        }
+    }
+
+    if (out != NULL){
+        for (int c = 0; c < METRIC_COUNTERS; c++){
+            fprintf(out,"# HELP %s %s\n", counter_names[c][0], counter_names[c][1]);
+            fprintf(out,"# TYPE %s counter\n", counter_names[c][0]);
+            fprintf(out,"%s %llu\n", counter_names[c][0], (unsigned long long)total->counters[c]);
+        }
+
+        fprintf(out,"# HELP picoder_protocol_matches_total Frames decoded by protocol\n");
+        fprintf(out,"# TYPE picoder_protocol_matches_total counter\n");
+        for (size_t p = 0; p < metrics->n_protocols; p++){
+            if (total->matches[p] > 0){
+                fprintf(out,"picoder_protocol_matches_total{protocol=\"%s\"} %llu\n", metrics->names[p], (unsigned long long)total->matches[p]);
+            }
+        }
+
+        write_histograms(out, total);
+
+        if (ferror(out)){
+            error = -1;
+        }
+        if (fclose(out) != 0){
+            error = -1;
+        }
+#ifdef _WIN32
+        remove(file);
+#endif
+        if (error == 0 && rename(temp, file) != 0){
+            error = -1;
+        }
+    }
+
+    if (total != NULL){
+        free(total->matches);
+    }
+    free(total);
+    free(temp);
+
+    return error;
+}
+
+#ifndef _WIN32
+static void* metrics_exporter(void* arg){
+
+    metrics_t* metrics = (metrics_t*)arg;
+
+    pthread_mutex_lock(&metrics->lock);
+    while (metrics->running){
+        struct timespec deadline;
+        timespec_get(&deadline, TIME_UTC);
+        deadline.tv_sec += metrics->interval;
+        pthread_cond_timedwait(&metrics->stop, &metrics->lock, &deadline);
+        if (metrics->running){
+            pthread_mutex_unlock(&metrics->lock);
+            metrics_write(metrics, metrics->file);
+            pthread_mutex_lock(&metrics->lock);
+        }
+    }
+    pthread_mutex_unlock(&metrics->lock);
+
+    return NULL;
+}
+#endif
+
+bool metrics_export(metrics_t* metrics, const char* file, int interval){
+
+    size_t len = strlen(file);
+
+    metrics->file = (char*)malloc(len + 1);
+    if (metrics->file == NULL){
+        return false;
+    }
+    memcpy(metrics->file, file, len + 1);
+    metrics->interval = interval;
+
+    /* First write checks file is writable */
+    if (metrics_write(metrics, file) != 0){
+        fprintf(stderr,"error: unable to write metrics '%s'\n",file);
+        return false;
+    }
+
+#ifndef _WIN32
+    metrics->running = true;
+    if (pthread_create(&metrics->exporter, NULL, metrics_exporter, metrics) != 0){
+        fprintf(stderr,"error: unable to start metrics exporter\n");
+        metrics->running = false;
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+void metrics_free(metrics_t* metrics){
+
+    if (metrics == NULL){
+        return;
+    }
+
+#ifndef _WIN32
+    pthread_mutex_lock(&metrics->lock);
+    bool running = metrics->running;
+    metrics->running = false;
+    pthread_cond_signal(&metrics->stop);
+    pthread_mutex_unlock(&metrics->lock);
+    if (running){
+        pthread_join(metrics->exporter, NULL);
+    }
+#endif
+
+    if (metrics->file != NULL){
+        metrics_write(metrics, metrics->file);
+        free(metrics->file);
+    }
+
+    while (metrics->shards != NULL){
+        metrics_shard_t* next = metrics->shards->next;
+        free(metrics->shards->matches);
+        free(metrics->shards);
+        metrics->shards = next;
+    }
+
+#ifndef _WIN32
+    pthread_mutex_destroy(&metrics->lock);
+    pthread_cond_destroy(&metrics->stop);
+#endif
+
+    free(metrics->names);
+    free(metrics->slots);
+    free(metrics);
+}
@@ -0,0 +1,119 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_METRICS_H
+#define PICODER_METRICS_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define DEFAULT_METRICS_INTERVAL    10      /* secs between metrics file rewrites */
+
+typedef enum {
+    METRIC_FRAMES_IN = 0,       /* frames segmented */
+    METRIC_FRAMES_OUT,          /* frames decoded */
+    METRIC_DECODE_MISSES,       /* frames no protocol match */
+    METRIC_DECODE_ERRORS,       /* decode or output fails */
+    METRIC_TABLE_HITS,          /* lookup table hits */
+    METRIC_TABLE_MISSES,        /* lookup table misses */
+    METRIC_COUNTERS
+} metric_counter_t;
+
+typedef enum {
+    METRIC_SEGMENT = 0,         /* from input to frame ready */
+    METRIC_DECODE,              /* lookup table and decodePulseTrain() */
+    METRIC_EMIT,                /* output of decoded frame */
+    METRIC_STAGES
+} metric_stage_t;
+
+/*
+    Log-linear latency histogram in nanoseconds: 8 linear sub-buckets per
+    power of two, values up to 8 exact, up to 2^48 ns. Upper bounds are
+    inclusive, as Prometheus le bounds.
+*/
+#define METRIC_SUB_BUCKETS     8
+#define METRIC_BUCKETS       368
+
+/*
+    Counters of one thread. Only the owner thread writes its shard, readers
+    sum every shard, relaxed atomic loads and stores keep values untorn
+    without locked instructions in the hot path.
+*/
+typedef struct metrics_shard_t {
+    uint64_t                 counters[METRIC_COUNTERS];
+    uint64_t                 buckets[METRIC_STAGES][METRIC_BUCKETS];
+    uint64_t                 sums[METRIC_STAGES];
+    uint64_t*                matches;       /* per protocol matches */
+    struct metrics_shard_t*  next;
+} metrics_shard_t;
+
+typedef struct {
+    size_t            n_protocols;
+    const char**      names;          /* protocol names, index of matches */
+    uint16_t*         slots;          /* names hash, index + 1, 0 if empty */
+    size_t            mask;
+    metrics_shard_t*  shards;
+    char*             file;
+    int               interval;
+#ifndef _WIN32
+    pthread_mutex_t   lock;           /* shards list and exporter stop */
+    pthread_cond_t    stop;
+    pthread_t         exporter;
+    bool              running;
+#endif
+} metrics_t;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define METRIC_LOAD(x)       __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#define METRIC_STORE(x, v)   __atomic_store_n(&(x), (v), __ATOMIC_RELAXED)
+#else
+#define METRIC_LOAD(x)       (x)
+#define METRIC_STORE(x, v)   ((x) = (v))
+#endif
+
+/* Owner thread increment, no read-modify-write lock needed */
+#define METRIC_ADD(x, v)     METRIC_STORE(x, METRIC_LOAD(x) + (v))
+
+metrics_t* metrics_new(void);
+
+/* New shard for the calling thread, NULL on fails */
+metrics_shard_t* metrics_shard(metrics_t* metrics);
+
+/* Histogram bucket of nanoseconds value */
+int metrics_bucket(uint64_t ns);
+
+/* Inclusive upper bound of histogram bucket in nanoseconds */
+uint64_t metrics_bucket_upper(int index);
+
+/* Value of quantile 0..1 of METRIC_BUCKETS histogram, bucket upper bound */
+uint64_t metrics_quantile(const uint64_t* buckets, double quantile);
+
+/* Monotonic time in nanoseconds */
+uint64_t metrics_now(void);
+
+void metrics_inc(metrics_shard_t* shard, metric_counter_t counter);
+
+void metrics_observe(metrics_shard_t* shard, metric_stage_t stage, uint64_t ns);
+
+/* Count protocol matches of decodePulseTrain() json */
+void metrics_match(metrics_t* metrics, metrics_shard_t* shard, const char* json);
+
+/* Write metrics in Prometheus text format, file is replaced atomically */
+int metrics_write(metrics_t* metrics, const char* file);
+
+/* Rewrite file every interval secs from a background thread (final write only on Windows) */
+bool metrics_export(metrics_t* metrics, const char* file, int interval);
+
+/* Stop exporter, write file last time and free */
+void metrics_free(metrics_t* metrics);
+
+#endif
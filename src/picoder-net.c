@@ -0,0 +1,178 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-net.h"
+
+#ifndef _WIN32
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#ifdef NET_RESOLVE
+#include <netdb.h>
+#endif
+
+#define MAX_HOST_LENGTH    256
+
+#ifndef NET_BACKLOG
+#define NET_BACKLOG        128
+#endif
+
+/* Split "host:port", host empty if only ":port" */
+static bool split_address(const char* address, char* host, const char** port){
+
+    const char* colon = strrchr(address, ':');
+    const char* start = address;
+    size_t      len;
+
+    if (colon == NULL || colon[1] == '\0'){
+        return false;
+    }
+    len = (size_t)(colon - address);
+    if (len >= 2 && address[0] == '[' && address[len - 1] == ']'){
+        start++;
+        len -= 2;
+    }
+    if (len >= MAX_HOST_LENGTH){
+        return false;
+    }
+    memcpy(host, start, len);
+    host[len] = '\0';
+    *port     = colon + 1;
+
+    return true;
+}
+
+/*
+    Numeric IPv4 or IPv6 host, "localhost" or empty (any to listen,
+    loopback to connect). Returns address length, 0 if not numeric.
+*/
+static socklen_t parse_address(const char* host, const char* port, bool listen_flag, struct sockaddr_storage* sa){
+
+    char* end;
+    long  number = strtol(port, &end, 10);
+
+    if (*end != '\0' || number < 0 || number > 65535){
+        return 0;
+    }
+
+    memset(sa, 0, sizeof(*sa));
+
+    struct sockaddr_in*  in4 = (struct sockaddr_in*)sa;
+    struct sockaddr_in6* in6 = (struct sockaddr_in6*)sa;
+
+    if (host[0] == '\0' || strcmp(host, "localhost") == 0){
+        in4->sin_family      = AF_INET;
+        in4->sin_port        = htons((uint16_t)number);
+        in4->sin_addr.s_addr = htonl(host[0] == '\0' && listen_flag ? INADDR_ANY : INADDR_LOOPBACK);
+        return sizeof(*in4);
+    }
+    if (inet_pton(AF_INET, host, &in4->sin_addr) == 1){
+        in4->sin_family = AF_INET;
+        in4->sin_port   = htons((uint16_t)number);
+        return sizeof(*in4);
+    }
+    if (inet_pton(AF_INET6, host, &in6->sin6_addr) == 1){
+        in6->sin6_family = AF_INET6;
+        in6->sin6_port   = htons((uint16_t)number);
+        return sizeof(*in6);
+    }
+    return 0;
+}
+
+/* Socket connected or bound to address, -1 on fails */
+static int net_socket(const struct sockaddr* sa, socklen_t len, int type, bool listen_flag){
+
+    int fd = socket(sa->sa_family, type, 0);
+    int rc;
+
+    if (fd < 0){
+        return -1;
+    }
+    if (listen_flag){
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        rc = bind(fd, sa, len);
+        if (rc == 0 && type == SOCK_STREAM){
+            rc = listen(fd, NET_BACKLOG);
+        }
+    }else{
+        rc = connect(fd, sa, len);
+    }
+    if (rc != 0){
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+/*
+    Open numeric address, connect or bind. Host names are resolved only by
+    dynamic builds (NET_RESOLVE), getaddrinfo of static glibc binaries
+    needs the NSS shared libraries at runtime.
+*/
+static int net_open(const char* address, int type, bool listen_flag){
+
+    char                    host[MAX_HOST_LENGTH];
+    const char*             port;
+    struct sockaddr_storage sa;
+    socklen_t               len;
+    int                     fd = -1;
+
+    if (!split_address(address, host, &port)){
+        fprintf(stderr,"error: address '%s' invalid, must be host:port\n",address);
+        return -1;
+    }
+
+    len = parse_address(host, port, listen_flag, &sa);
+    if (len > 0){
+        fd = net_socket((const struct sockaddr*)&sa, len, type, listen_flag);
+    }else{
+#ifdef NET_RESOLVE
+        struct addrinfo  hints;
+        struct addrinfo* list = NULL;
+        int              rc;
+
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = type;
+
+        rc = getaddrinfo(host, port, &hints, &list);
+        if (rc != 0){
+            fprintf(stderr,"error: address '%s' %s\n",address,gai_strerror(rc));
+            return -1;
+        }
+        for (struct addrinfo* ai = list; ai != NULL && fd < 0; ai = ai->ai_next){
+            fd = net_socket(ai->ai_addr, ai->ai_addrlen, type, listen_flag);
+        }
+        freeaddrinfo(list);
+#else
+        fprintf(stderr,"error: address '%s' invalid, must be numeric ip:port\n",address);
+        return -1;
+#endif
+    }
+
+    if (fd < 0){
+        fprintf(stderr,"error: unable to %s '%s'\n", listen_flag ? "listen on" : "connect to", address);
+    }
+    return fd;
+}
+
+int net_connect(const char* address, int type){
+    return net_open(address, type, false);
+}
+
+int net_listen(const char* address, int type){
+    return net_open(address, type, true);
+}
+
+#endif
@@ -0,0 +1,32 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_NET_H
+#define PICODER_NET_H
+
+#include <stdio.h>
+
+/*
+    Sockets of network commands, POSIX only. Addresses are "ipv4:port",
+    "[ipv6]:port", "localhost:port" or ":port" for any local address, host
+    names only on dynamic builds. Returns socket descriptor or -1 showing
+    error.
+*/
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+
+/* Socket connected to address, type SOCK_DGRAM or SOCK_STREAM */
+int net_connect(const char* address, int type);
+
+/* Socket bound to address, listening if SOCK_STREAM */
+int net_listen(const char* address, int type);
+#endif
+
+#endif
@@ -0,0 +1,165 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-noise.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+bool noise_profile_parse(const char* spec, noise_profile_t* profile){
+
+    static const char* names[] = { "jitter", "drop", "split", "glitch", "truncate" };
+
+    double* values[] = { &profile->jitter, &profile->drop, &profile->split, &profile->glitch, &profile->truncate };
+
+    memset(profile, 0, sizeof(*profile));
+
+    while (*spec != '\0'){
+
+        const char* end   = strchr(spec, ',');
+        const char* equal = strchr(spec, '=');
+        size_t      len   = (end != NULL) ? (size_t)(end - spec) : strlen(spec);
+        int         found = -1;
+
+        if (equal == NULL || (end != NULL && equal > end)){
+            return false;
+        }
+        for (int i = 0; i < (int)(sizeof(names) / sizeof(*names)); i++){
+            if (strlen(names[i]) == (size_t)(equal - spec) && strncmp(spec, names[i], (size_t)(equal - spec)) == 0){
+                found = i;
+            }
+        }
+
+        char*  tail;
+        double value = strtod(equal + 1, &tail);
+
+        if (found < 0 || tail != spec + len || tail == equal + 1 || value < 0 || (found > 0 && value > 1)){
+            return false;
+        }
+        *values[found] = value;
+
+        spec += len;
+        if (*spec == ','){
+            spec++;
+        }
+    }
+    return true;
+}
+
+void noise_profile_scale(const noise_profile_t* profile, double level, noise_profile_t* scaled){
+    scaled->jitter   = profile->jitter * level;
+    scaled->drop     = fmin(profile->drop * level, 1.0);
+    scaled->split    = fmin(profile->split * level, 1.0);
+    scaled->glitch   = fmin(profile->glitch * level, 1.0);
+    scaled->truncate = fmin(profile->truncate * level, 1.0);
+}
+
+void noise_seed(noise_t* noise, const noise_profile_t* profile, uint64_t seed){
+    noise->profile   = *profile;
+    noise->state     = seed;
+    noise->has_spare = false;
+}
+
+/* splitmix64 */
+static uint64_t noise_next(noise_t* noise){
+    uint64_t z = (noise->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [0,1) */
+static double noise_uniform(noise_t* noise){
+    return (double)(noise_next(noise) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static bool noise_chance(noise_t* noise, double probability){
+    return probability > 0 && noise_uniform(noise) < probability;
+}
+
+/* Standard normal, Box-Muller pairs */
+static double noise_gaussian(noise_t* noise){
+    if (noise->has_spare){
+        noise->has_spare = false;
+        return noise->spare;
+    }
+    double u = 1.0 - noise_uniform(noise);
+    double v = noise_uniform(noise);
+    double r = sqrt(-2.0 * log(u));
+    noise->spare     = r * sin(2.0 * M_PI * v);
+    noise->has_spare = true;
+    return r * cos(2.0 * M_PI * v);
+}
+
+static uint32_t noise_jitter(noise_t* noise, uint32_t pulse){
+    if (noise->profile.jitter <= 0){
+        return pulse;
+    }
+    double value = pulse * (1.0 + noise->profile.jitter * noise_gaussian(noise));
+    return (value < 1.0) ? 1 : (value > 4e9) ? 4000000000U : (uint32_t)(value + 0.5);
+}
+
+int noise_apply(noise_t* noise, const uint32_t* in, int n_pulses, uint32_t* out, int max_pulses){
+
+    const noise_profile_t* p = &noise->profile;
+    int                    n = 0;
+
+    if (n_pulses <= 0 || max_pulses <= 0){
+        return 0;
+    }
+
+    /* Truncated frames lose pulse pairs before the footer, so levels are kept */
+    int last = n_pulses - 1;
+    if (n_pulses > 3 && noise_chance(noise, p->truncate)){
+        last -= 2 * (1 + (int)(noise_uniform(noise) * ((n_pulses - 2) / 2)));
+    }
+
+    /* Drop and split keep parity of pulses, room left for footer */
+    for (int i = 0; i < last && n < max_pulses - 1; i++){
+
+        uint32_t pulse = in[i];
+
+        if (n > 0 && i + 1 < last && noise_chance(noise, p->drop)){
+            /* Level lost, previous and next pulses of same level are merged */
+            out[n - 1] += pulse + noise_jitter(noise, in[++i]);
+            continue;
+        }
+
+        pulse = noise_jitter(noise, pulse);
+
+        uint32_t cut = 0;
+        if (noise_chance(noise, p->split)){
+            cut = (uint32_t)(pulse * (0.1 + 0.2 * noise_uniform(noise)));
+        }else if (noise_chance(noise, p->glitch)){
+            cut = NOISE_GLITCH_MIN + (uint32_t)((NOISE_GLITCH_MAX - NOISE_GLITCH_MIN) * noise_uniform(noise));
+        }
+
+        if (cut > 0 && cut + 2 < pulse && n + 4 <= max_pulses){
+            /* Opposite level inside pulse, total duration kept */
+            uint32_t before = 1 + (uint32_t)((pulse - cut - 2) * noise_uniform(noise));
+            out[n++] = before;
+            out[n++] = cut;
+            out[n++] = pulse - cut - before;
+        }else{
+            out[n++] = pulse;
+        }
+    }
+
+    /* Footer at the level it had, last pulse merged if cut by max_pulses */
+    if (n > 0 && ((n ^ last) & 1) == 1){
+        n--;
+        if (n > 0){
+            out[n - 1] += out[n];
+        }
+    }
+    out[n++] = noise_jitter(noise, in[n_pulses - 1]);
+
+    return n;
+}
@@ -0,0 +1,52 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_NOISE_H
+#define PICODER_NOISE_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+/* Profile of noise level 1.0, see noise_profile_parse() */
+#define DEFAULT_NOISE_PROFILE   "jitter=0.2,drop=0.02,split=0.02,glitch=0.02,truncate=0.2"
+
+#define NOISE_GLITCH_MIN    20      /* uSecs */
+#define NOISE_GLITCH_MAX   100
+
+/* Perturbation probabilities are per pulse, but truncate which is per frame */
+typedef struct {
+    double  jitter;         /* gaussian standard deviation relative to pulse */
+    double  drop;           /* pulse lost, merged with both neighbours */
+    double  split;          /* pulse broken by an opposite level of 10% to 30% of it */
+    double  glitch;         /* opposite level spike of NOISE_GLITCH_MIN to MAX uSecs inside pulse */
+    double  truncate;       /* frame cut at random pulse, footer kept */
+} noise_profile_t;
+
+/* Seeded perturbation engine, same seed and profile give same output */
+typedef struct {
+    noise_profile_t  profile;
+    uint64_t         state;
+    double           spare;
+    bool             has_spare;
+} noise_t;
+
+/* Parse "name=value[,name=value...]" of profile members, missing ones are 0 */
+bool noise_profile_parse(const char* spec, noise_profile_t* profile);
+
+/* Scale every probability and jitter of profile by level */
+void noise_profile_scale(const noise_profile_t* profile, double level, noise_profile_t* scaled);
+
+void noise_seed(noise_t* noise, const noise_profile_t* profile, uint64_t seed);
+
+/*
+    Perturb pulse train 'in' to 'out' (in and out must not overlap), levels
+    alternate as in the input. Returns number of pulses, at most max_pulses.
+*/
+int noise_apply(noise_t* noise, const uint32_t* in, int n_pulses, uint32_t* out, int max_pulses);
+
+#endif
@@ -0,0 +1,403 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-output.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#ifndef OUTPUT_BUFFER_SIZE
+#define OUTPUT_BUFFER_SIZE    1024
+#endif
+
+static const char* output_formats[] = { "json", "ndjson", "cbor", "msgpack", NULL };
+
+int output_format_by_name(const char* name){
+    for (int i = 0; output_formats[i] != NULL; i++){
+        if (strcasecmp(output_formats[i], name) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+void output_buffer_free(output_buffer_t* buf){
+    if (buf->data != NULL){
+        free(buf->data);
+    }
+    buf->data = NULL;
+    buf->len  = 0;
+    buf->size = 0;
+}
+
+void output_set_binary(FILE* out){
+#ifdef _WIN32
+    _setmode(_fileno(out), _O_BINARY);
+#else
+    (void)out;
+#endif
+}
+
+/* Make room for 'len' more bytes, buffer only grows */
+static bool buffer_reserve(output_buffer_t* buf, size_t len){
+    if (buf->len + len > buf->size){
+        size_t size = buf->size ? buf->size : OUTPUT_BUFFER_SIZE;
+        while (buf->len + len > size){
+            size *= 2;
+        }
+        char* data = (char*)realloc(buf->data, size);
+        if (data == NULL){
+            return false;
+        }
+        buf->data = data;
+        buf->size = size;
+    }
+    return true;
+}
+
+bool output_buffer_append(output_buffer_t* buf, const char* str, size_t len){
+    if (buffer_reserve(buf, len)){
+        memcpy(buf->data + buf->len, str, len);
+        buf->len += len;
+        return true;
+    }
+    return false;
+}
+
+static bool buffer_append_number(output_buffer_t* buf, double number){
+    if (buffer_reserve(buf, 32)){
+        buf->len += (size_t)snprintf(buf->data + buf->len, 32, "%.15g", number);
+        return true;
+    }
+    return false;
+}
+
+static bool buffer_append_string(output_buffer_t* buf, const char* str){
+    static const char hex[] = "0123456789abcdef";
+
+    /* Worst case every char escaped as \u00XX plus quotes */
+    if (!buffer_reserve(buf, strlen(str) * 6 + 2)){
+        return false;
+    }
+    char* p = buf->data + buf->len;
+    *p++ = '"';
+    for (const unsigned char* s = (const unsigned char*)str; *s; s++){
+        switch (*s){
+            case '"':  *p++ = '\\'; *p++ = '"';  break;
+            case '\\': *p++ = '\\'; *p++ = '\\'; break;
+            case '\n': *p++ = '\\'; *p++ = 'n';  break;
+            case '\r': *p++ = '\\'; *p++ = 'r';  break;
+            case '\t': *p++ = '\\'; *p++ = 't';  break;
+            default:
+                if (*s < 0x20){
+                    *p++ = '\\'; *p++ = 'u'; *p++ = '0'; *p++ = '0';
+                    *p++ = hex[*s >> 4];
+                    *p++ = hex[*s & 0x0F];
+                }else{
+                    *p++ = (char)*s;
+                }
+                break;
+        }
+    }
+    *p++ = '"';
+    buf->len = (size_t)(p - buf->data);
+    return true;
+}
+
+static bool buffer_append_value(output_buffer_t* buf, const JsonNode* node){
+    JsonNode* child = NULL;
+    bool      ok    = true;
+
+    switch (node->tag){
+        case JSON_NULL:
+            return output_buffer_append(buf, "null", 4);
+        case JSON_BOOL:
+            return node->bool_ ? output_buffer_append(buf, "true", 4) : output_buffer_append(buf, "false", 5);
+        case JSON_STRING:
+            return buffer_append_string(buf, node->string_);
+        case JSON_NUMBER:
+            return buffer_append_number(buf, node->number_);
+        case JSON_ARRAY:
+        case JSON_OBJECT:
+            ok = output_buffer_append(buf, node->tag == JSON_ARRAY ? "[" : "{", 1);
+            json_foreach(child, node){
+                if (ok && child != json_first_child(node)){
+                    ok = output_buffer_append(buf, ",", 1);
+                }
+                if (ok && node->tag == JSON_OBJECT){
+                    ok = buffer_append_string(buf, child->key) && output_buffer_append(buf, ":", 1);
+                }
+                if (ok){
+                    ok = buffer_append_value(buf, child);
+                }
+            }
+            return ok && output_buffer_append(buf, node->tag == JSON_ARRAY ? "]" : "}", 1);
+    }
+    return false;
+}
+
+int output_ndjson(FILE* out, output_buffer_t* buf, const char* json, const double* timestamp){
+
+    JsonNode* root     = json_decode(json);
+    JsonNode* message  = NULL;
+    JsonNode* field    = NULL;
+    int       messages = 0;
+
+    if (root == NULL){
+        return -1;
+    }
+
+    /* Decoder json: {"protocols":[{"name":{fields}},...]}, anything else is an empty result */
+    JsonNode* protocols = json_find_member(root, "protocols");
+
+    if (protocols != NULL && protocols->tag == JSON_ARRAY){
+
+        json_foreach(message, protocols){
+
+            JsonNode* fields = json_first_child(message);
+
+            if (fields == NULL || fields->key == NULL){
+                continue;
+            }
+
+            bool ok = true;
+            buf->len = 0;
+
+            ok = output_buffer_append(buf, "{\"protocol\":", 12) && buffer_append_string(buf, fields->key);
+
+            if (fields->tag == JSON_OBJECT){
+                json_foreach(field, fields){
+                    if (ok){
+                        ok = output_buffer_append(buf, ",", 1)
+                          && buffer_append_string(buf, field->key)
+                          && output_buffer_append(buf, ":", 1)
+                          && buffer_append_value(buf, field);
+                    }
+                }
+            }
+
+            if (ok && timestamp != NULL){
+                ok = output_buffer_append(buf, ",\"ts\":", 6) && buffer_reserve(buf, 32);
+                if (ok){
+                    buf->len += (size_t)snprintf(buf->data + buf->len, 32, "%.6f", *timestamp);
+                }
+            }
+
+            if (ok && output_buffer_append(buf, "}\n", 2)){
+                fwrite(buf->data, 1, buf->len, out);
+                messages++;
+            }else{
+                messages = -1;
+                break;
+            }
+        }
+    }
+
+    json_delete(root);
+
+    return messages;
+}
+
+/* Binary encoders, CBOR (RFC 8949) and MessagePack, big-endian integers */
+
+#define CBOR_UINT     0
+#define CBOR_NEGINT   1
+#define CBOR_TEXT     3
+#define CBOR_ARRAY    4
+#define CBOR_MAP      5
+
+static bool buffer_append_be(output_buffer_t* buf, uint8_t first, uint64_t value, int bytes){
+    if (buffer_reserve(buf, (size_t)bytes + 1)){
+        buf->data[buf->len++] = (char)first;
+        for (int i = bytes - 1; i >= 0; i--){
+            buf->data[buf->len++] = (char)((value >> (i * 8)) & 0xFF);
+        }
+        return true;
+    }
+    return false;
+}
+
+static bool cbor_head(output_buffer_t* buf, uint8_t major, uint64_t value){
+    major = (uint8_t)(major << 5);
+    if (value < 24)         return buffer_append_be(buf, major | (uint8_t)value, 0, 0);
+    if (value <= 0xFF)      return buffer_append_be(buf, major | 24, value, 1);
+    if (value <= 0xFFFF)    return buffer_append_be(buf, major | 25, value, 2);
+    if (value <= 0xFFFFFFFF)return buffer_append_be(buf, major | 26, value, 4);
+    return buffer_append_be(buf, major | 27, value, 8);
+}
+
+static bool msgpack_uint(output_buffer_t* buf, uint64_t value){
+    if (value < 0x80)       return buffer_append_be(buf, (uint8_t)value, 0, 0);
+    if (value <= 0xFF)      return buffer_append_be(buf, 0xCC, value, 1);
+    if (value <= 0xFFFF)    return buffer_append_be(buf, 0xCD, value, 2);
+    if (value <= 0xFFFFFFFF)return buffer_append_be(buf, 0xCE, value, 4);
+    return buffer_append_be(buf, 0xCF, value, 8);
+}
+
+static bool msgpack_int(output_buffer_t* buf, int64_t value){
+    if (value >= -32)       return buffer_append_be(buf, (uint8_t)(int8_t)value, 0, 0);
+    if (value >= INT8_MIN)  return buffer_append_be(buf, 0xD0, (uint64_t)value, 1);
+    if (value >= INT16_MIN) return buffer_append_be(buf, 0xD1, (uint64_t)value, 2);
+    if (value >= INT32_MIN) return buffer_append_be(buf, 0xD2, (uint64_t)value, 4);
+    return buffer_append_be(buf, 0xD3, (uint64_t)value, 8);
+}
+
+/* Container header: map or array of 'count' items */
+static bool binary_container(output_buffer_t* buf, output_format_t format, bool map, uint32_t count){
+    if (format == OUTPUT_CBOR){
+        return cbor_head(buf, map ? CBOR_MAP : CBOR_ARRAY, count);
+    }
+    if (count < 16)     return buffer_append_be(buf, (uint8_t)((map ? 0x80 : 0x90) | count), 0, 0);
+    if (count <= 0xFFFF)return buffer_append_be(buf, map ? 0xDE : 0xDC, count, 2);
+    return buffer_append_be(buf, map ? 0xDF : 0xDD, count, 4);
+}
+
+static bool binary_string(output_buffer_t* buf, output_format_t format, const char* str){
+    size_t len = strlen(str);
+    bool   ok;
+
+    if (format == OUTPUT_CBOR){
+        ok = cbor_head(buf, CBOR_TEXT, len);
+    }else if (len < 32){
+        ok = buffer_append_be(buf, (uint8_t)(0xA0 | len), 0, 0);
+    }else if (len <= 0xFF){
+        ok = buffer_append_be(buf, 0xD9, len, 1);
+    }else if (len <= 0xFFFF){
+        ok = buffer_append_be(buf, 0xDA, len, 2);
+    }else{
+        ok = buffer_append_be(buf, 0xDB, len, 4);
+    }
+    return ok && output_buffer_append(buf, str, len);
+}
+
+/* Integral values as integers, others as 64-bit float */
+static bool binary_number(output_buffer_t* buf, output_format_t format, double number){
+    if (number == floor(number) && fabs(number) < 9007199254740992.0){
+        int64_t value = (int64_t)number;
+        if (format == OUTPUT_CBOR){
+            return value >= 0 ? cbor_head(buf, CBOR_UINT, (uint64_t)value) : cbor_head(buf, CBOR_NEGINT, (uint64_t)(-1 - value));
+        }
+        return value >= 0 ? msgpack_uint(buf, (uint64_t)value) : msgpack_int(buf, value);
+    }
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    return buffer_append_be(buf, format == OUTPUT_CBOR ? 0xFB : 0xCB, bits, 8);
+}
+
+static uint32_t count_children(const JsonNode* node){
+    JsonNode* child = NULL;
+    uint32_t  count = 0;
+    json_foreach(child, node){
+        count++;
+    }
+    return count;
+}
+
+static bool binary_value(output_buffer_t* buf, output_format_t format, const JsonNode* node){
+    JsonNode* child = NULL;
+    bool      ok    = true;
+    bool      cbor  = (format == OUTPUT_CBOR);
+
+    switch (node->tag){
+        case JSON_NULL:
+            return buffer_append_be(buf, cbor ? 0xF6 : 0xC0, 0, 0);
+        case JSON_BOOL:
+            return buffer_append_be(buf, node->bool_ ? (cbor ? 0xF5 : 0xC3) : (cbor ? 0xF4 : 0xC2), 0, 0);
+        case JSON_STRING:
+            return binary_string(buf, format, node->string_);
+        case JSON_NUMBER:
+            return binary_number(buf, format, node->number_);
+        case JSON_ARRAY:
+        case JSON_OBJECT:
+            ok = binary_container(buf, format, node->tag == JSON_OBJECT, count_children(node));
+            json_foreach(child, node){
+                if (ok && node->tag == JSON_OBJECT){
+                    ok = binary_string(buf, format, child->key);
+                }
+                if (ok){
+                    ok = binary_value(buf, format, child);
+                }
+            }
+            return ok;
+    }
+    return false;
+}
+
+int output_binary(FILE* out, output_buffer_t* buf, output_format_t format, const char* json, const double* timestamp){
+
+    JsonNode* root     = json_decode(json);
+    JsonNode* message  = NULL;
+    JsonNode* field    = NULL;
+    int       messages = 0;
+
+    if (root == NULL){
+        return -1;
+    }
+
+    JsonNode* protocols = json_find_member(root, "protocols");
+
+    if (protocols != NULL && protocols->tag == JSON_ARRAY){
+
+        json_foreach(message, protocols){
+
+            JsonNode* fields = json_first_child(message);
+
+            if (fields == NULL || fields->key == NULL){
+                continue;
+            }
+
+            uint32_t count = 1 + (timestamp != NULL ? 1 : 0) + (fields->tag == JSON_OBJECT ? count_children(fields) : 0);
+
+            /* Reserve record length prefix, filled once the payload is built */
+            buf->len = 4;
+            bool ok = buffer_reserve(buf, 0)
+                   && binary_container(buf, format, true, count)
+                   && binary_string(buf, format, "protocol")
+                   && binary_string(buf, format, fields->key);
+
+            if (fields->tag == JSON_OBJECT){
+                json_foreach(field, fields){
+                    if (ok){
+                        ok = binary_string(buf, format, field->key) && binary_value(buf, format, field);
+                    }
+                }
+            }
+
+            if (ok && timestamp != NULL){
+                uint64_t bits;
+                memcpy(&bits, timestamp, sizeof(bits));
+                ok = binary_string(buf, format, "ts")
+                  && buffer_append_be(buf, format == OUTPUT_CBOR ? 0xFB : 0xCB, bits, 8);
+            }
+
+            if (ok){
+                uint32_t len = (uint32_t)(buf->len - 4);
+                buf->data[0] = (char)(len >> 24);
+                buf->data[1] = (char)(len >> 16);
+                buf->data[2] = (char)(len >> 8);
+                buf->data[3] = (char)(len);
+                fwrite(buf->data, 1, buf->len, out);
+                messages++;
+            }else{
+                messages = -1;
+                break;
+            }
+        }
+    }
+
+    json_delete(root);
+
+    return messages;
+}
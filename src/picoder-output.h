@@ -0,0 +1,59 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_OUTPUT_H
+#define PICODER_OUTPUT_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+/* Output formats for decoded messages */
+typedef enum {
+    OUTPUT_JSON = 0,    /* pretty-printed pilight json (default) */
+    OUTPUT_NDJSON,      /* one compact json line per decoded message */
+    OUTPUT_CBOR,        /* length-delimited CBOR record per decoded message */
+    OUTPUT_MSGPACK      /* length-delimited MessagePack record per decoded message */
+} output_format_t;
+
+/* Growable output buffer, reused between frames */
+typedef struct {
+    char*   data;
+    size_t  len;
+    size_t  size;
+} output_buffer_t;
+
+/* Get output format from name, -1 if unknown */
+int output_format_by_name(const char* name);
+
+/* Append bytes to output buffer, false on malloc fails */
+bool output_buffer_append(output_buffer_t* buf, const char* str, size_t len);
+
+/* Release output buffer memory */
+void output_buffer_free(output_buffer_t* buf);
+
+/*
+    Decoded messages are only returned by PiCode as json text: the formats
+    below parse the compact decoder json once and walk its node tree.
+
+    Write decoded messages from a compact decoder json as flat ndjson lines:
+        {"protocol":"name",<message fields>[,"ts":seconds]}
+    Returns the number of messages written, 0 if nothing decoded, -1 on error.
+*/
+int output_ndjson(FILE* out, output_buffer_t* buf, const char* json, const double* timestamp);
+
+/*
+    Write decoded messages as binary records with the same flat fields as ndjson.
+    Each record is a 32-bit big-endian payload length followed by a CBOR or
+    MessagePack map. Returns as output_ndjson().
+*/
+int output_binary(FILE* out, output_buffer_t* buf, output_format_t format, const char* json, const double* timestamp);
+
+/* Set stream to binary mode, needed for binary formats on Windows */
+void output_set_binary(FILE* out);
+
+#endif
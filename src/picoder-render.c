@@ -0,0 +1,160 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-render.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#define WAV_HEADER    44
+
+int render_format_by_name(const char* name){
+    if (strcmp(name, "cu8") == 0){
+        return RENDER_CU8;
+    }else if (strcmp(name, "cs8") == 0){
+        return RENDER_CS8;
+    }else if (strcmp(name, "wav") == 0){
+        return RENDER_WAV;
+    }
+    return -1;
+}
+
+static void put_le(char* buf, uint32_t value, int bytes){
+    for (int i = 0; i < bytes; i++){
+        buf[i] = (char)(value >> (8 * i));
+    }
+}
+
+/* Unknown sizes are max if output is not seekable, fixed on close */
+static void wav_header(char* header, double samplerate, uint32_t data){
+    uint32_t rate = (uint32_t)samplerate;
+    memcpy(header, "RIFF", 4);
+    put_le(header + 4, data == 0xFFFFFFFFU ? data : data + WAV_HEADER - 8, 4);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put_le(header + 16, 16, 4);         /* fmt size */
+    put_le(header + 20, 1, 2);          /* PCM */
+    put_le(header + 22, 1, 2);          /* mono */
+    put_le(header + 24, rate, 4);
+    put_le(header + 28, rate, 4);       /* bytes per sec */
+    put_le(header + 32, 1, 2);          /* block align */
+    put_le(header + 34, 8, 2);          /* bits */
+    memcpy(header + 36, "data", 4);
+    put_le(header + 40, data, 4);
+}
+
+bool render_open(render_t* r, FILE* out, render_format_t format, double samplerate, uint32_t gap){
+
+    static const unsigned char high[][2] = { { 255, 128 }, { 127, 0 }, { 255, 0 } };
+    static const unsigned char low[][2]  = { { 128, 128 }, {   0, 0 }, { 128, 0 } };
+
+    memset(r, 0, sizeof(*r));
+    r->out        = out;
+    r->format     = format;
+    r->samplerate = samplerate;
+    r->gap        = gap;
+    r->sample     = (format == RENDER_WAV) ? 1 : 2;
+    r->levels[0]  = (char*)malloc(RENDER_CHUNK);
+    r->levels[1]  = (char*)malloc(RENDER_CHUNK);
+    r->buf        = (char*)malloc(RENDER_CHUNK);
+
+    if (r->levels[0] == NULL || r->levels[1] == NULL || r->buf == NULL){
+        fprintf(stderr,"error: malloc fail!\n");
+        render_close(r);
+        return false;
+    }
+
+    /* Level patterns filled once, runs are copied from them */
+    if (r->sample == 1){
+        memset(r->levels[0], low[format][0], RENDER_CHUNK);
+        memset(r->levels[1], high[format][0], RENDER_CHUNK);
+    }else{
+        for (size_t i = 0; i < RENDER_CHUNK; i += 2){
+            memcpy(r->levels[0] + i, low[format], 2);
+            memcpy(r->levels[1] + i, high[format], 2);
+        }
+    }
+
+    if (format == RENDER_WAV){
+        char header[WAV_HEADER];
+        wav_header(header, samplerate, 0xFFFFFFFFU);
+        r->failed = fwrite(header, 1, WAV_HEADER, out) != WAV_HEADER;
+    }
+
+    return !r->failed;
+}
+
+/* Append duration at level, sample count from total time so rounding never drifts */
+static void render_run(render_t* r, int level, double us){
+
+    r->time += us;
+
+    uint64_t end   = (uint64_t)(r->time * r->samplerate / 1e6 + 0.5);
+    size_t   bytes = (size_t)(end - r->samples) * r->sample;
+
+    r->samples = end;
+
+    while (bytes > 0 && !r->failed){
+        size_t n = RENDER_CHUNK - r->len;
+        if (n > bytes){
+            n = bytes;
+        }
+        memcpy(r->buf + r->len, r->levels[level], n);
+        r->len += n;
+        bytes  -= n;
+        if (r->len == RENDER_CHUNK){
+            r->failed = fwrite(r->buf, 1, r->len, r->out) != r->len;
+            r->len    = 0;
+        }
+    }
+}
+
+bool render_frame(render_t* r, const uint32_t* pulses, int n_pulses, int repeats){
+
+    /* Leading silence of a gap, at least the footer, so receivers see the first frame start */
+    if (r->time == 0 && n_pulses > 0){
+        render_run(r, 0, r->gap > pulses[n_pulses - 1] ? r->gap : pulses[n_pulses - 1]);
+    }
+
+    for (int repeat = 0; repeat < repeats; repeat++){
+        /* Pulse trains start high */
+        for (int i = 0; i < n_pulses; i++){
+            render_run(r, (i & 1) == 0, pulses[i]);
+        }
+    }
+    if (r->gap > 0){
+        render_run(r, 0, r->gap);
+    }
+    return !r->failed;
+}
+
+bool render_close(render_t* r){
+
+    if (r->buf != NULL && r->len > 0 && !r->failed){
+        r->failed = fwrite(r->buf, 1, r->len, r->out) != r->len;
+    }
+    if (r->out != NULL && !r->failed && r->format == RENDER_WAV){
+        /* Fix sizes, seek fails on pipes keeping max sizes */
+        uint64_t data = r->samples * r->sample;
+        if (data < 0xFFFFFFFFULL - WAV_HEADER && fseek(r->out, 0, SEEK_SET) == 0){
+            char header[WAV_HEADER];
+            wav_header(header, r->samplerate, (uint32_t)data);
+            r->failed = fwrite(header, 1, WAV_HEADER, r->out) != WAV_HEADER || fseek(r->out, 0, SEEK_END) != 0;
+        }
+    }
+    if (r->out != NULL && fflush(r->out) != 0){
+        r->failed = true;
+    }
+
+    free(r->levels[0]);
+    free(r->levels[1]);
+    free(r->buf);
+    r->levels[0] = r->levels[1] = r->buf = NULL;
+
+    return !r->failed;
+}
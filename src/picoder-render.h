@@ -0,0 +1,56 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_RENDER_H
+#define PICODER_RENDER_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#define DEFAULT_RENDER_SAMPLERATE   2000000   /* Hz, hackrf min */
+#define RENDER_CHUNK                  65536   /* bytes per write */
+
+/*
+    OOK baseband samples, carrier at center frequency:
+        cu8   IQ unsigned 8 bits, high (255,128) low (128,128)
+        cs8   IQ signed 8 bits (hackrf_transfer), high (127,0) low (0,0)
+        wav   mono PCM unsigned 8 bits, high 255 low 128
+*/
+typedef enum {
+    RENDER_CU8 = 0,
+    RENDER_CS8,
+    RENDER_WAV
+} render_format_t;
+
+typedef struct {
+    FILE*            out;
+    render_format_t  format;
+    double           samplerate;
+    uint32_t         gap;               /* uSecs of silence after each frame */
+    size_t           sample;            /* bytes per sample */
+    char*            levels[2];         /* low and high samples, RENDER_CHUNK bytes each */
+    char*            buf;
+    size_t           len;
+    double           time;              /* uSecs rendered */
+    uint64_t         samples;           /* samples rendered */
+    bool             failed;
+} render_t;
+
+/* Get render format from name, -1 if unknown */
+int render_format_by_name(const char* name);
+
+/* Start rendering to out, writes WAV header. Shows error on fails */
+bool render_open(render_t* r, FILE* out, render_format_t format, double samplerate, uint32_t gap);
+
+/* Render pulse train repeats times, then the gap. First frame starts after a gap, at least its footer */
+bool render_frame(render_t* r, const uint32_t* pulses, int n_pulses, int repeats);
+
+/* Flush, fix WAV sizes if output is seekable and free. Returns false on write fails */
+bool render_close(render_t* r);
+
+#endif
@@ -0,0 +1,640 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-replay.h"
+#include "picoder-input.h"
+#include "picoder-metrics.h"
+#include "picoder-net.h"
+#include "picoder-output.h"
+#include "picoder-shm.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+
+#ifndef MAX_PULSE_LENGTH
+#define MAX_PULSE_LENGTH    100000UL
+#endif
+
+#ifndef MAX_REPLAY_STREAMS
+#define MAX_REPLAY_STREAMS    64
+#endif
+
+#define DEFAULT_GAP         5000    /* pulses from this length end a frame */
+#define LATE_NS          1000000    /* frames sent 1 mSec after schedule are late */
+
+typedef enum { REPLAY_TEXT = 0, REPLAY_BINARY } replay_format_t;
+
+typedef struct {
+    size_t    offset;       /* first pulse */
+    uint32_t  count;
+    uint64_t  duration;     /* uSecs, footer gap included */
+} replay_frame_t;
+
+/* Capture frames, read once and shared by every stream */
+typedef struct {
+    uint32_t*        pulses;
+    size_t           n_pulses;
+    size_t           size;
+    replay_frame_t*  frames;
+    size_t           n_frames;
+    size_t           frames_size;
+    size_t           frame_start;
+    uint32_t         max_count;
+    uint64_t         duration;     /* total uSecs */
+    uint64_t         pending;      /* uSecs of current frame */
+    uint32_t         gap;
+    bool             failed;
+} capture_t;
+
+typedef struct {
+    const capture_t*  capture;
+    double            speed;        /* 0 if unlimited */
+    int               loops;
+    replay_format_t   format;
+    FILE*             out;          /* NULL if socket or shm ring */
+    const char*       address;
+    shm_ring_t*       ring;         /* NULL if file or socket */
+} replay_t;
+
+typedef struct {
+    const replay_t*  replay;
+    int              fd;            /* datagram socket, -1 if file */
+    uint64_t         frames;
+    uint64_t         pulses;
+    uint64_t         bytes;
+    uint64_t         late;          /* sent LATE_NS after schedule */
+    uint64_t         dropped;       /* socket send fails, pulses over ring capacity */
+    uint64_t         lag_max;
+    uint64_t         lag_sum;
+    uint64_t         write_ns;      /* time blocked writing */
+    uint64_t         elapsed_ns;
+    bool             failed;        /* out of memory or write error, stopped */
+} stream_t;
+
+static struct option list_options[] = {
+  { "input",      required_argument, NULL,      'i' },
+  { "gap",        required_argument, NULL,      'g' },
+  { "speed",      required_argument, NULL,      'x' },
+  { "loops",      required_argument, NULL,      'l' },
+  { "streams",    required_argument, NULL,      'n' },
+  { "format",     required_argument, NULL,      'F' },
+  { "output",     required_argument, NULL,      'o' },
+  { "udp",        required_argument, NULL,      'U' },
+  { "shm",        required_argument, NULL,      'm' },
+  { "help",       no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void replay_help(FILE* out){
+    fprintf(out,"         replay [-h] -i capture [-x speed]            --> re-emit capture frames at recorded timing\n");
+    fprintf(out,"                [-h | --help]                         --> show command options\n");
+    fprintf(out,"                [-i | --input capture]                --> pulse durations file ('-' stdin)\n");
+    fprintf(out,"                [-g | --gap uSecs]                    --> min length of frame gaps (default %d)\n", DEFAULT_GAP);
+    fprintf(out,"                [-x | --speed factor]                 --> set speed factor, 0 unlimited (default 1)\n");
+    fprintf(out,"                [-l | --loops loops]                  --> replay capture loops times (default 1)\n");
+    fprintf(out,"                [-n | --streams streams]              --> set parallel streams, up to %d\n", MAX_REPLAY_STREAMS);
+    fprintf(out,"                [-F | --format format]                --> set frames format text or binary\n");
+    fprintf(out,"                [-o | --output file]                  --> write frames to file (default stdout)\n");
+    fprintf(out,"                [-U | --udp host:port]                --> send one datagram per frame\n");
+    fprintf(out,"                [-m | --shm name]                     --> write pulses to shared memory ring, one stream\n");
+}
+
+static void capture_end_frame(capture_t* c){
+
+    if (c->n_frames == c->frames_size){
+        size_t          size   = c->frames_size ? c->frames_size * 2 : 1024;
+        replay_frame_t* frames = (replay_frame_t*)realloc(c->frames, sizeof(*frames) * size);
+        if (frames == NULL){
+            c->failed = true;
+            return;
+        }
+        c->frames      = frames;
+        c->frames_size = size;
+    }
+
+    replay_frame_t* frame = &c->frames[c->n_frames++];
+    frame->offset   = c->frame_start;
+    frame->count    = (uint32_t)(c->n_pulses - c->frame_start);
+    frame->duration = c->pending;
+
+    if (frame->count > c->max_count){
+        c->max_count = frame->count;
+    }
+    c->duration    += c->pending;
+    c->pending      = 0;
+    c->frame_start  = c->n_pulses;
+}
+
+static void capture_block(void* ctx, const uint32_t* pulses, size_t n){
+
+    capture_t* c = (capture_t*)ctx;
+
+    if (c->failed){
+        return;
+    }
+    if (c->n_pulses + n > c->size){
+        size_t size = c->size ? c->size : INPUT_BLOCK;
+        while (size < c->n_pulses + n){
+            size *= 2;
+        }
+        uint32_t* buffer = (uint32_t*)realloc(c->pulses, sizeof(*buffer) * size);
+        if (buffer == NULL){
+            c->failed = true;
+            return;
+        }
+        c->pulses = buffer;
+        c->size   = size;
+    }
+
+    for (size_t i = 0; i < n && !c->failed; i++){
+        c->pulses[c->n_pulses++] = pulses[i];
+        c->pending += pulses[i];
+        if (pulses[i] >= c->gap){
+            capture_end_frame(c);
+        }
+    }
+}
+
+static void sleep_until(uint64_t ns){
+#ifndef _WIN32
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+#else
+    uint64_t now = metrics_now();
+    if (ns > now){
+        Sleep((DWORD)((ns - now) / 1000000ULL));
+    }
+#endif
+}
+
+static void put_u32(char* buf, uint32_t value){
+    buf[0] = (char)value;
+    buf[1] = (char)(value >> 8);
+    buf[2] = (char)(value >> 16);
+    buf[3] = (char)(value >> 24);
+}
+
+/* Frame as comma separated pulse train line or uint32 LE count and pulses */
+static size_t format_frame(const replay_t* r, const replay_frame_t* frame, char* buf){
+
+    const uint32_t* pulses = r->capture->pulses + frame->offset;
+    size_t          len    = 0;
+
+    if (r->format == REPLAY_BINARY){
+        put_u32(buf, frame->count);
+        len = 4;
+        for (uint32_t i = 0; i < frame->count; i++, len += 4){
+            put_u32(buf + len, pulses[i]);
+        }
+    }else{
+        for (uint32_t i = 0; i < frame->count; i++){
+            /* Fast unsigned to text, pulses never exceed 10 digits */
+            char     digits[10];
+            int      n     = 0;
+            uint32_t value = pulses[i];
+            do {
+                digits[n++] = (char)('0' + value % 10);
+                value /= 10;
+            } while (value > 0);
+            if (i > 0){
+                buf[len++] = ',';
+            }
+            while (n > 0){
+                buf[len++] = digits[--n];
+            }
+        }
+        buf[len++] = '\n';
+    }
+    return len;
+}
+
+#ifndef _WIN32
+/* Frame as shm ring records, pulse start times back from now */
+static size_t format_records(const replay_t* r, const replay_frame_t* frame, shm_record_t* records){
+
+    const uint32_t* pulses = r->capture->pulses + frame->offset;
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    uint64_t start = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec - frame->duration * 1000ULL;
+
+    for (uint32_t i = 0; i < frame->count; i++){
+        records[i].pulse     = pulses[i];
+        records[i].reserved  = 0;
+        records[i].timestamp = start;
+        start += pulses[i] * 1000ULL;
+    }
+    return frame->count * sizeof(*records);
+}
+#endif
+
+/*
+    Emit every frame at its recorded end time scaled by speed. Lag is time
+    from schedule to write end: the consumer or socket pushing back.
+*/
+static void* replay_stream(void* arg){
+
+    stream_t*        s     = (stream_t*)arg;
+    const replay_t*  r     = s->replay;
+    const capture_t* c     = r->capture;
+    char*            buf   = (char*)malloc((size_t)c->max_count * sizeof(shm_record_t) + 8);
+    uint64_t         start = metrics_now();
+    uint64_t         sched = 0;    /* recorded nSecs */
+
+    for (int loop = 0; loop < r->loops && buf != NULL; loop++){
+        for (size_t f = 0; f < c->n_frames; f++){
+
+            const replay_frame_t* frame  = &c->frames[f];
+            uint64_t              target = 0;
+
+            sched += frame->duration * 1000ULL;
+            if (r->speed > 0){
+                target = start + (uint64_t)((double)sched / r->speed);
+                sleep_until(target);
+            }
+
+#ifndef _WIN32
+            size_t   len = (r->ring == NULL) ? format_frame(r, frame, buf) : format_records(r, frame, (shm_record_t*)buf);
+#else
+            size_t   len = format_frame(r, frame, buf);
+#endif
+            uint64_t w0  = metrics_now();
+
+            if (r->ring != NULL){
+#ifndef _WIN32
+                size_t n = len / sizeof(shm_record_t);
+                s->dropped += n - shm_ring_write(r->ring, (const shm_record_t*)buf, n);
+#endif
+            }else if (r->out != NULL){
+                if (fwrite(buf, 1, len, r->out) != len || (r->speed > 0 && fflush(r->out) != 0)){
+                    fprintf(stderr,"error: writing frames\n");
+                    s->failed = true;
+                    loop = r->loops;
+                    break;
+                }
+            }
+#ifndef _WIN32
+            else if (r->address != NULL && send(s->fd, buf, len, 0) < 0){
+                s->dropped++;
+            }
+#endif
+            uint64_t w1 = metrics_now();
+
+            s->write_ns += w1 - w0;
+            if (r->speed > 0){
+                uint64_t lag = w1 > target ? w1 - target : 0;
+                s->lag_sum += lag;
+                s->lag_max  = lag > s->lag_max ? lag : s->lag_max;
+                s->late    += lag > LATE_NS;
+            }
+            s->frames++;
+            s->pulses += frame->count;
+            s->bytes  += len;
+        }
+    }
+
+    s->elapsed_ns = metrics_now() - start;
+    if (buf == NULL){
+        fprintf(stderr,"error: malloc(%lu) fail!\n",(unsigned long)((size_t)c->max_count * sizeof(shm_record_t) + 8));
+        s->failed = true;
+    }
+    free(buf);
+
+    return NULL;
+}
+
+static void replay_report(const stream_t* s, const char* name){
+
+    double secs = (double)s->elapsed_ns / 1e9;
+
+    fprintf(stderr,"replay: %-9s %llu frames, %llu pulses, %llu bytes in %.3f secs, %.1f frames/s",
+            name, (unsigned long long)s->frames, (unsigned long long)s->pulses, (unsigned long long)s->bytes,
+            secs, secs > 0 ? (double)s->frames / secs : 0);
+    if (s->replay->speed > 0 && s->frames > 0){
+        fprintf(stderr,", lag mean %.3f max %.3f ms, %llu late", (double)s->lag_sum / (double)s->frames / 1e6,
+                (double)s->lag_max / 1e6, (unsigned long long)s->late);
+    }
+    if (s->dropped > 0){
+        fprintf(stderr,", %llu dropped", (unsigned long long)s->dropped);
+    }
+    fprintf(stderr,", writing %.1f%%\n", s->elapsed_ns ? 100.0 * (double)s->write_ns / (double)s->elapsed_ns : 0);
+}
+
+static int replay_run(replay_t* r, int n_streams){
+
+    stream_t streams[MAX_REPLAY_STREAMS];
+    stream_t total;
+    int      error_flag = 0;
+
+    memset(streams, 0, sizeof(streams));
+    memset(&total, 0, sizeof(total));
+
+    for (int i = 0; i < n_streams; i++){
+        streams[i].replay = r;
+        streams[i].fd     = -1;
+#ifndef _WIN32
+        if (r->address != NULL){
+            streams[i].fd = net_connect(r->address, SOCK_DGRAM);
+            if (streams[i].fd < 0){
+                error_flag--;
+            }
+        }
+#endif
+    }
+
+    if (error_flag == 0){
+#ifndef _WIN32
+        pthread_t threads[MAX_REPLAY_STREAMS];
+        int       started = 0;
+
+        for (int i = 1; i < n_streams; i++){
+            if (pthread_create(&threads[started], NULL, replay_stream, &streams[i]) == 0){
+                started++;
+            }
+        }
+        replay_stream(&streams[0]);
+        for (int i = 0; i < started; i++){
+            pthread_join(threads[i], NULL);
+        }
+#else
+        replay_stream(&streams[0]);
+#endif
+        if (r->out != NULL && fflush(r->out) != 0){
+            fprintf(stderr,"error: writing frames\n");
+            error_flag--;
+        }
+        for (int i = 0; i < n_streams; i++){
+            if (streams[i].failed){
+                error_flag--;
+            }
+        }
+
+        total.replay = r;
+        for (int i = 0; i < n_streams; i++){
+            char name[16];
+            snprintf(name, sizeof(name), "stream %d:", i + 1);
+            if (n_streams > 1){
+                replay_report(&streams[i], name);
+            }
+            total.frames   += streams[i].frames;
+            total.pulses   += streams[i].pulses;
+            total.bytes    += streams[i].bytes;
+            total.late     += streams[i].late;
+            total.dropped  += streams[i].dropped;
+            total.lag_sum  += streams[i].lag_sum;
+            total.write_ns += streams[i].write_ns / (uint64_t)n_streams;
+            total.lag_max    = streams[i].lag_max > total.lag_max ? streams[i].lag_max : total.lag_max;
+            total.elapsed_ns = streams[i].elapsed_ns > total.elapsed_ns ? streams[i].elapsed_ns : total.elapsed_ns;
+        }
+        replay_report(&total, "total:");
+
+        /* Speed assumes every loop was sent */
+        double recorded = (double)r->capture->duration / 1e6;
+        if (error_flag == 0 && recorded > 0 && total.elapsed_ns > 0){
+            fprintf(stderr,"replay: recorded  %zu frames in %.3f secs, %.1f frames/s per stream, achieved speed x%.2f\n",
+                    r->capture->n_frames, recorded, (double)r->capture->n_frames / recorded,
+                    recorded * r->loops / ((double)total.elapsed_ns / 1e9));
+        }
+    }
+
+#ifndef _WIN32
+    for (int i = 0; i < n_streams; i++){
+        if (streams[i].fd >= 0){
+            close(streams[i].fd);
+        }
+    }
+#endif
+
+    return error_flag;
+}
+
+int replay_cmd(int argc, char** argv){
+
+    capture_t   capture;
+    replay_t    replay     = { &capture, 1.0, 1, REPLAY_TEXT, NULL, NULL, NULL };
+    shm_ring_t  ring;
+    char*       input      = NULL;
+    char*       output     = NULL;
+    char*       shm        = NULL;
+    int         n_streams  = 1;
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    memset(&capture, 0, sizeof(capture));
+    capture.gap = DEFAULT_GAP;
+
+    if (argc > 1){
+        while ((ch = getopt_long(argc, argv, "i:g:x:l:n:F:o:U:m:h", list_options, NULL)) != -1) {
+
+            switch (ch) {
+                case 'i':
+                    if (input == NULL){
+                        input = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one input file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'g':
+                    if ((atol(optarg) > 0) && ((uint32_t)atol(optarg) <= MAX_PULSE_LENGTH)){
+                        capture.gap = (uint32_t)atol(optarg);
+                    }else{
+                        fprintf(stderr,"error: gap must be > 0 and <= %lu\n",MAX_PULSE_LENGTH);
+                        error_flag--;
+                    }
+                    break;
+                case 'x':
+                    if (atof(optarg) >= 0){
+                        replay.speed = atof(optarg);
+                    }else{
+                        fprintf(stderr,"error: speed must be >= 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'l':
+                    if (atoi(optarg) > 0){
+                        replay.loops = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: loops must be > 0\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'n':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_REPLAY_STREAMS)){
+                        n_streams = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: streams must be > 0 and <= %d\n",MAX_REPLAY_STREAMS);
+                        error_flag--;
+                    }
+                    break;
+                case 'F':
+                    if (strcmp(optarg, "text") == 0){
+                        replay.format = REPLAY_TEXT;
+                    }else if (strcmp(optarg, "binary") == 0){
+                        replay.format = REPLAY_BINARY;
+                    }else{
+                        fprintf(stderr,"error: frames format '%s' invalid\n",optarg);
+                        error_flag--;
+                    }
+                    break;
+                case 'o':
+                    if (output == NULL && replay.address == NULL && shm == NULL){
+                        output = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one output is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'U':
+                    if (output == NULL && replay.address == NULL && shm == NULL){
+                        replay.address = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one output is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'm':
+                    if (output == NULL && replay.address == NULL && shm == NULL){
+                        shm = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one output is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'h':
+                    help_flag = true;
+                    break;
+                case 1:
+                    /*
+                    * Use this case if getopt_long() should go through all
+                    * arguments. If so, add a leading '-' character to optstring.
+                    * Actual code, if any, goes here.
+                    */
+                    break;
+                case ':':   /* missing option argument */
+                    //fprintf(stderr, "error: option '-%c' requires an argument\n", optopt);
+                    error_flag--;
+                    break;
+                case '?':
+                default:    /* invalid option */
+                    //fprintf(stderr, "error: option '-%c' is invalid\n", optopt);
+                    error_flag--;
+                    break;
+            }
+        }
+
+        if (optind < argc) {
+            fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+            while (optind < argc){
+                fprintf(stderr," %s", argv[optind++]);
+                error_flag--;
+            }
+            fprintf(stderr,"\n");
+        }
+
+        if (help_flag){
+            printf("command:\n");
+            replay_help(stdout);
+        }else{
+
+            if (input == NULL){
+                fprintf(stderr,"error: -i capture is required\n");
+                error_flag--;
+            }
+#ifdef _WIN32
+            if (replay.address != NULL || shm != NULL || n_streams > 1){
+                fprintf(stderr,"error: udp, shm and streams are not supported on Windows\n");
+                error_flag--;
+            }
+#endif
+            if (shm != NULL && n_streams > 1){
+                fprintf(stderr,"error: shm ring has a single producer, one stream only\n");
+                error_flag--;
+            }
+
+            if (error_flag == 0){
+
+                FILE* in = strcmp(input, "-") == 0 ? stdin : fopen(input, "r");
+
+                if (in != NULL){
+                    if (input_read_pulses(in, MAX_PULSE_LENGTH, capture_block, &capture) != 0 || capture.failed){
+                        fprintf(stderr,"error: reading '%s'\n",input);
+                        error_flag--;
+                    }else if (capture.n_pulses > capture.frame_start){
+                        /* Trailing pulses without gap */
+                        capture_end_frame(&capture);
+                    }
+                    if (in != stdin){
+                        fclose(in);
+                    }
+                }else{
+                    fprintf(stderr,"error: unable to open '%s'\n",input);
+                    error_flag--;
+                }
+
+                if (error_flag == 0 && capture.n_frames == 0){
+                    fprintf(stderr,"error: no frames in '%s'\n",input);
+                    error_flag--;
+                }
+            }
+
+#ifndef _WIN32
+            if (error_flag == 0 && shm != NULL){
+                if (shm_ring_open(&ring, shm, SHM_RING_CAPACITY, true)){
+                    replay.ring = &ring;
+                }else{
+                    error_flag--;
+                }
+            }
+#endif
+            if (error_flag == 0 && replay.address == NULL && replay.ring == NULL){
+                replay.out = (output == NULL || strcmp(output, "-") == 0) ? stdout : fopen(output, "wb");
+                if (replay.out == NULL){
+                    fprintf(stderr,"error: unable to open '%s'\n",output);
+                    error_flag--;
+                }else if (replay.format == REPLAY_BINARY && replay.out == stdout){
+                    output_set_binary(stdout);
+                }
+            }
+
+            if (error_flag == 0){
+                error_flag = replay_run(&replay, n_streams);
+            }
+
+            if (replay.out != NULL && replay.out != stdout && fclose(replay.out) != 0 && error_flag == 0){
+                fprintf(stderr,"error: writing frames\n");
+                error_flag--;
+            }
+#ifndef _WIN32
+            if (replay.ring != NULL){
+                shm_ring_close(replay.ring);
+            }
+#endif
+            free(capture.pulses);
+            free(capture.frames);
+        }
+    }else{
+        fprintf(stderr,"error: -i capture is required\n");
+        error_flag--;
+    }
+
+    return error_flag;
+}
@@ -0,0 +1,117 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-sample.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#ifndef MAX_SAMPLE_OPTIONS
+#define MAX_SAMPLE_OPTIONS    8
+#endif
+
+#ifndef MAX_SAMPLE_VALUES
+#define MAX_SAMPLE_VALUES     4     /* encoded id values per state */
+#endif
+
+/* Device id candidates as json values, tried in order until encode success */
+static const char* id_values[] = { "1", "0", "2", "3", "5", "10", "15", "31", "\"A1\"", "\"B2\"", NULL };
+
+/* Build json with every id option set to value and an optional extra member, empty if truncated */
+static void sample_json(char* json, char** ids, int n_ids, const char* value, const char* extra, const char* extra_value){
+
+    size_t len = 0;
+
+    json[len++] = '{';
+    for (int i = 0; i < n_ids && len < MAX_SAMPLE_JSON; i++){
+        len += (size_t)snprintf(json + len, MAX_SAMPLE_JSON - len, "%s\"%s\":%s", i ? "," : "", ids[i], value);
+    }
+    if (extra != NULL && len < MAX_SAMPLE_JSON){
+        len += (size_t)snprintf(json + len, MAX_SAMPLE_JSON - len, "%s\"%s\":%s", n_ids ? "," : "", extra, extra_value);
+    }
+    if (len < MAX_SAMPLE_JSON - 1){
+        json[len++] = '}';
+        json[len]   = '\0';
+    }else{
+        json[0] = '\0';
+    }
+}
+
+int sample_codes(protocol_t* protocol, uint32_t* pulses, uint16_t max_pulses, sample_callback_t callback, void* ctx){
+
+    char* ids[MAX_SAMPLE_OPTIONS]    = {0};
+    char* extras[MAX_SAMPLE_OPTIONS] = {0};
+    bool  is_state[MAX_SAMPLE_OPTIONS];
+    int   n_ids     = 0;
+    int   n_extras  = 0;
+    int   n_samples = 0;
+    char  json[MAX_SAMPLE_JSON];
+
+    if (protocol == NULL || protocol->createCode == NULL){
+        return 0;
+    }
+
+    int   option_index    = 0;
+    char* option_id       = NULL;
+    char* option_name     = NULL;
+    int   option_argtype  = 0;
+    int   option_conftype = 0;
+
+    while (options_list(protocol->options, option_index++, &option_id) == 0){
+
+        option_name = NULL;
+        options_get_name_by_id(protocol->options, option_id, &option_name);
+        options_get_argtype(protocol->options, option_id, 0, &option_argtype);
+        options_get_conftype(protocol->options, option_id, 0, &option_conftype);
+
+        if (option_name == NULL){
+            continue;
+        }
+        if (option_argtype == OPTION_HAS_VALUE && option_conftype == DEVICES_ID && n_ids < MAX_SAMPLE_OPTIONS){
+            ids[n_ids++] = option_name;
+        }else if (n_extras < MAX_SAMPLE_OPTIONS){
+            if (option_argtype == OPTION_NO_VALUE && option_conftype == DEVICES_STATE){
+                is_state[n_extras]  = true;
+                extras[n_extras++]  = option_name;
+            }else if (option_argtype == OPTION_HAS_VALUE && option_conftype == DEVICES_VALUE){
+                is_state[n_extras]  = false;
+                extras[n_extras++]  = option_name;
+            }
+        }
+    }
+
+    /* One pass per state or value option, one without if protocol has none */
+    for (int e = 0; e < (n_extras ? n_extras : 1); e++){
+
+        int encoded = 0;
+
+        for (int v = 0; id_values[v] != NULL && encoded < MAX_SAMPLE_VALUES; v++){
+
+            if (n_extras){
+                /* States as "on":1, values take the id value too */
+                sample_json(json, ids, n_ids, id_values[v], extras[e], is_state[e] ? "1" : id_values[v]);
+            }else{
+                sample_json(json, ids, n_ids, id_values[v], NULL, NULL);
+            }
+
+            int n_pulses = json[0] ? encodeToPulseTrain(pulses, max_pulses, protocol, json) : -1;
+
+            if (n_pulses > 0){
+                callback(ctx, protocol, json, pulses, n_pulses);
+                encoded++;
+                n_samples++;
+            }
+            if (n_ids == 0){
+                break;
+            }
+        }
+    }
+
+    return n_samples;
+}
@@ -0,0 +1,45 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_SAMPLE_H
+#define PICODER_SAMPLE_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+/* pilight option argument and config types, see pilight options.h */
+#ifndef OPTION_NO_VALUE
+#define OPTION_NO_VALUE     1
+#endif
+#ifndef OPTION_HAS_VALUE
+#define OPTION_HAS_VALUE    2
+#endif
+#ifndef DEVICES_ID
+#define DEVICES_ID          1
+#endif
+#ifndef DEVICES_STATE
+#define DEVICES_STATE       2
+#endif
+#ifndef DEVICES_VALUE
+#define DEVICES_VALUE       3
+#endif
+
+#ifndef MAX_SAMPLE_JSON
+#define MAX_SAMPLE_JSON   256
+#endif
+
+/* Called for every sample code encoded */
+typedef void (*sample_callback_t)(void* ctx, protocol_t* protocol, const char* json, const uint32_t* pulses, int n_pulses);
+
+/*
+    Encode a set of sample codes of protocol, combining every state option
+    with a few device id values. Returns the number of samples encoded.
+*/
+int sample_codes(protocol_t* protocol, uint32_t* pulses, uint16_t max_pulses, sample_callback_t callback, void* ctx);
+
+#endif
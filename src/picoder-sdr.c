@@ -0,0 +1,159 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-input.h"
+#include "picoder-cpu.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+/*
+    Every format is scaled to 12 bits amplitude (+-2048) so power, I*I+Q*Q,
+    fits int32 and the detector thresholds are format independent.
+*/
+#define SDR_SMOOTH         8        /* power moving average samples, power of 2 */
+#define SDR_RISE_RATIO     4        /* pulse starts at 6 dB over noise floor */
+#define SDR_MIN_POWER      256      /* and over amplitude 16 */
+#define SDR_NOISE_SHIFT    10       /* noise floor moving average, 1/1024 */
+#define SDR_HIGH_SHIFT     4        /* pulse level moving average, 1/16 */
+#define SDR_SEED_SAMPLES   1024     /* noise floor seeded from their minimum */
+
+/* Power of each sample of chunk, returns number of samples */
+static size_t sdr_power(input_format_t format, const unsigned char* in, size_t len, uint32_t* power){
+
+    size_t n = 0;
+
+    if (format == INPUT_CU8){
+        n = cpu_kernels.power_cu8(in, len, power);
+    }else if (format == INPUT_CS16){
+        n = cpu_kernels.power_cs16(in, len, power);
+    }else{
+        /* Amplitude, plain loop vectorized by compiler */
+        for (size_t i = 0; i < len; i++, n++){
+            uint32_t amplitude = (uint32_t)in[i] * 8;
+            power[n] = amplitude * amplitude;
+        }
+    }
+    return n;
+}
+
+/*
+    Adaptive OOK detector over power averaged on SDR_SMOOTH samples, so
+    noise peaks do not start pulses: the noise floor follows the signal
+    while low, a pulse starts rising SDR_RISE_RATIO over it (not on the
+    decay of the last pulse) and ends under the midpoint of noise floor
+    and pulse level, which follows the signal while high.
+*/
+int input_read_sdr(FILE* in, input_format_t format, double samplerate, uint32_t max_pulse, input_block_t callback, void* ctx){
+
+    unsigned char* chunk   = (unsigned char*)malloc(INPUT_CHUNK);
+    uint32_t*      power   = (uint32_t*)malloc(sizeof(*power) * INPUT_CHUNK);
+    uint32_t*      block   = (uint32_t*)malloc(sizeof(*block) * INPUT_BLOCK);
+    size_t         n_block = 0;
+    size_t         sample  = (format == INPUT_CU8) ? 2 : (format == INPUT_CS16 ? 4 : 1);
+    double         us      = 1e6 / samplerate;
+    int64_t        noise   = -1;
+    int64_t        high    = 0;
+    int64_t        noise_sum = 0;   /* moving averages scaled by their shift, no rounding drift */
+    int64_t        high_sum  = 0;
+    int64_t        last    = 0;     /* previous averaged power */
+    uint32_t       window[SDR_SMOOTH];
+    uint64_t       sum     = 0;
+    uint64_t       index   = 0;
+    uint64_t       run     = 0;
+    bool           level   = false;
+    bool           edge    = false;
+    size_t         len;
+
+    if (chunk == NULL || power == NULL || block == NULL){
+        free(chunk);
+        free(power);
+        free(block);
+        fprintf(stderr,"error: malloc fail!\n");
+        return -1;
+    }
+
+    while ((len = fread(chunk, 1, INPUT_CHUNK, in)) > 0){
+
+        size_t n = sdr_power(format, chunk, len - len % sample, power);
+
+        /* Minimum of first samples, a capture may start with the carrier on */
+        if (noise < 0 && n > 0){
+            uint32_t seed = power[0];
+            for (size_t i = 1; i < n && i < SDR_SEED_SAMPLES; i++){
+                if (power[i] < seed){
+                    seed = power[i];
+                }
+            }
+            noise     = seed;
+            noise_sum = noise << SDR_NOISE_SHIFT;
+            for (int w = 0; w < SDR_SMOOTH; w++){
+                window[w] = seed;
+            }
+            sum = (uint64_t)seed * SDR_SMOOTH;
+        }
+
+        for (size_t i = 0; i < n; i++, index++){
+
+            sum += power[i];
+            sum -= window[index & (SDR_SMOOTH - 1)];
+            window[index & (SDR_SMOOTH - 1)] = power[i];
+
+            int64_t p = (int64_t)(sum / SDR_SMOOTH);
+            bool    next;
+
+            if (level){
+                high_sum += p - high;
+                high      = high_sum >> SDR_HIGH_SHIFT;
+                next  = p > noise + ((high - noise) >> 1);
+            }else{
+                noise_sum += p - noise;
+                noise      = noise_sum >> SDR_NOISE_SHIFT;
+                next   = p > last && p > noise * SDR_RISE_RATIO && p > noise + SDR_MIN_POWER;
+                if (next){
+                    high     = p;
+                    high_sum = p << SDR_HIGH_SHIFT;
+                }
+            }
+
+            last = p;
+
+            if (next != level){
+                /* First low run has no start */
+                if (edge){
+                    double   duration = (double)run * us;
+                    uint32_t pulse    = duration >= (double)max_pulse ? max_pulse : (uint32_t)(duration + 0.5);
+                    block[n_block++]  = pulse > 0 ? pulse : 1;
+                    if (n_block == INPUT_BLOCK){
+                        callback(ctx, block, n_block);
+                        n_block = 0;
+                    }
+                }
+                edge  = true;
+                level = next;
+                run   = 0;
+            }
+            run++;
+        }
+    }
+
+    if (edge && run > 0){
+        double duration = (double)run * us;
+        block[n_block++] = duration >= (double)max_pulse ? max_pulse : (uint32_t)(duration + 0.5);
+    }
+    if (n_block > 0){
+        callback(ctx, block, n_block);
+    }
+
+    free(chunk);
+    free(power);
+    free(block);
+
+    return ferror(in) ? -1 : 0;
+}
@@ -0,0 +1,453 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-serve.h"
+#include "picoder-encode.h"
+#include "picoder-output.h"
+#include "picoder-metrics.h"
+#include "picoder-net.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#ifndef MAX_PULSES
+#define MAX_PULSES    255
+#endif
+
+#ifndef MAX_LINE_LENGTH
+#define MAX_LINE_LENGTH     4096
+#endif
+
+/*
+    Line protocol, one reply line per request line in request order:
+        D <pilight string | pulse train>   -> compact decoded json, '[]' if no match
+        E <full json>                      -> pilight string
+    Invalid requests reply "ERR <message>".
+*/
+
+typedef struct connection_t connection_t;
+
+typedef struct {
+    validator_t       validator;
+    metrics_t*        metrics;
+    uint16_t          max_pulses;
+#ifndef _WIN32
+    pthread_mutex_t   codec_lock;     /* pilight protocols keep state in globals */
+    pthread_mutex_t   conn_lock;      /* open connections list */
+    pthread_cond_t    conn_done;      /* signaled when a connection ends */
+    connection_t*     connections;
+    int               active;
+#endif
+} server_t;
+
+struct connection_t {
+    server_t*      server;
+    int            fd;
+    connection_t*  next;
+};
+
+static struct option list_options[] = {
+  { "listen",     required_argument, NULL,      'l' },
+  { "metrics",    required_argument, NULL,      'M' },
+  { "interval",   required_argument, NULL,      'I' },
+  { "help",       no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void serve_help(FILE* out){
+    fprintf(out,"         serve [-h] -l host:port                      --> serve decode and encode requests over tcp\n");
+    fprintf(out,"               [-h | --help]                          --> show command options\n");
+    fprintf(out,"               [-l | --listen host:port]              --> listen address, ':port' for any\n");
+    fprintf(out,"               [-M | --metrics file]                  --> rewrite Prometheus metrics file periodically\n");
+    fprintf(out,"               [-I | --interval secs]                 --> set metrics file interval (default %d)\n", DEFAULT_METRICS_INTERVAL);
+}
+
+#ifndef _WIN32
+
+static volatile sig_atomic_t stop_flag = 0;
+
+static void serve_signal(int sig){
+    (void)sig;
+    stop_flag = 1;
+}
+
+/* Comma separated pulse train, returns pulses or -1 */
+static int parse_train(char* train, uint32_t* pulses, int max_pulses){
+
+    int   n_pulses = 0;
+    char* end;
+
+    while (*train != '\0'){
+        unsigned long pulse = strtoul(train, &end, 10);
+        if (end == train || pulse == 0 || n_pulses == max_pulses){
+            return -1;
+        }
+        if (*end != ',' && *end != '\0'){
+            return -1;
+        }
+        pulses[n_pulses++] = (uint32_t)pulse;
+        train = (*end == ',') ? end + 1 : end;
+    }
+    return n_pulses;
+}
+
+static void reply_error(output_buffer_t* reply, const char* message){
+    output_buffer_append(reply, "ERR ", 4);
+    output_buffer_append(reply, message, strlen(message));
+}
+
+/* Append reply of request line, returns metric counter of result */
+static metric_counter_t serve_request(server_t* srv, metrics_shard_t* shard, char* line, uint32_t* pulses, output_buffer_t* reply){
+
+    metric_counter_t result = METRIC_DECODE_ERRORS;
+    char             error[VALIDATE_ERROR];
+
+    if (line[0] == 'D' && line[1] == ' '){
+
+        int n_pulses = (line[2] == 'c') ? stringToPulseTrain(line + 2, pulses, MAX_PULSES) : parse_train(line + 2, pulses, MAX_PULSES);
+
+        if (n_pulses > 0){
+            pthread_mutex_lock(&srv->codec_lock);
+            char* json = decodePulseTrain(pulses, (uint8_t)n_pulses, NULL);
+            pthread_mutex_unlock(&srv->codec_lock);
+            if (json != NULL){
+                output_buffer_append(reply, json, strlen(json));
+                result = (json[0] == '{') ? METRIC_FRAMES_OUT : METRIC_DECODE_MISSES;
+                if (shard != NULL && result == METRIC_FRAMES_OUT){
+                    metrics_match(srv->metrics, shard, json);
+                }
+                free(json);
+            }else{
+                reply_error(reply, "decode pulse train fails");
+            }
+        }else{
+            reply_error(reply, "invalid pulse train");
+        }
+
+    }else if (line[0] == 'E' && line[1] == ' '){
+
+        pthread_mutex_lock(&srv->codec_lock);
+        int n_pulses = encode_full_json(&srv->validator, NULL, line + 2, pulses, srv->max_pulses, error);
+        pthread_mutex_unlock(&srv->codec_lock);
+
+        char* code = (n_pulses >= 0) ? pulseTrainToString(pulses, (uint16_t)n_pulses, 0) : NULL;
+        if (code != NULL){
+            output_buffer_append(reply, code, strlen(code));
+            result = METRIC_FRAMES_OUT;
+            free(code);
+        }else{
+            reply_error(reply, n_pulses >= 0 ? "encoding pulse train" : error);
+        }
+
+    }else{
+        reply_error(reply, "invalid request, must be 'D <string|train>' or 'E <full json>'");
+    }
+
+    output_buffer_append(reply, "\n", 1);
+
+    return result;
+}
+
+static bool send_all(int fd, const char* data, size_t len){
+    while (len > 0){
+        ssize_t n = send(fd, data, len, 0);
+        if (n < 0){
+            if (errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len  -= (size_t)n;
+    }
+    return true;
+}
+
+static void* serve_connection(void* arg){
+
+    connection_t*    conn   = (connection_t*)arg;
+    server_t*        srv    = conn->server;
+    FILE*            in     = fdopen(conn->fd, "r");
+    uint32_t*        pulses = (uint32_t*)malloc(sizeof(*pulses) * ((srv->max_pulses > MAX_PULSES ? srv->max_pulses : MAX_PULSES) + 1));
+    metrics_shard_t* shard  = (srv->metrics != NULL) ? metrics_shard(srv->metrics) : NULL;
+    output_buffer_t  reply  = { NULL, 0, 0 };
+    char             line[MAX_LINE_LENGTH];
+
+    while (in != NULL && pulses != NULL && fgets(line, sizeof(line), in) != NULL){
+
+        uint64_t start = (shard != NULL) ? metrics_now() : 0;
+        size_t   len   = strlen(line);
+
+        reply.len = 0;
+
+        if (len > 0 && line[len-1] != '\n' && !feof(in)){
+            int c;
+            while ((c = fgetc(in)) != EOF && c != '\n');
+            reply_error(&reply, "line too long");
+            output_buffer_append(&reply, "\n", 1);
+            if (shard != NULL){
+                metrics_inc(shard, METRIC_DECODE_ERRORS);
+            }
+        }else{
+            while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r' || line[len-1] == ' ')){
+                line[--len] = '\0';
+            }
+            metric_counter_t result = serve_request(srv, shard, line, pulses, &reply);
+            if (shard != NULL){
+                uint64_t now = metrics_now();
+                metrics_observe(shard, METRIC_DECODE, now - start);
+                metrics_inc(shard, METRIC_FRAMES_IN);
+                metrics_inc(shard, result);
+                start = now;
+            }
+        }
+
+        /* One send per reply, TCP_NODELAY set on accept */
+        if (!send_all(conn->fd, reply.data, reply.len)){
+            break;
+        }
+        if (shard != NULL){
+            metrics_observe(shard, METRIC_EMIT, metrics_now() - start);
+        }
+    }
+
+    output_buffer_free(&reply);
+    free(pulses);
+
+    /* Out of the list before close, so stop never shuts down a reused fd */
+    pthread_mutex_lock(&srv->conn_lock);
+    for (connection_t** c = &srv->connections; *c != NULL; c = &(*c)->next){
+        if (*c == conn){
+            *c = conn->next;
+            break;
+        }
+    }
+    if (in != NULL){
+        fclose(in);
+    }else{
+        close(conn->fd);
+    }
+    srv->active--;
+    pthread_cond_signal(&srv->conn_done);
+    pthread_mutex_unlock(&srv->conn_lock);
+
+    free(conn);
+
+    return NULL;
+}
+
+static int serve_run(server_t* srv, int fd){
+
+    struct sigaction sa;
+    pthread_attr_t   attr;
+    unsigned long    connections = 0;
+
+    /* Without SA_RESTART accept() returns on signals */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = serve_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    while (!stop_flag){
+
+        int client = accept(fd, NULL, NULL);
+
+        if (client < 0){
+            if (errno != EINTR && errno != ECONNABORTED){
+                fprintf(stderr,"error: accept fails (%d)\n",errno);
+                break;
+            }
+            continue;
+        }
+
+        int on = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+        connection_t* conn = (connection_t*)malloc(sizeof(*conn));
+        pthread_t     thread;
+        if (conn != NULL){
+            conn->server = srv;
+            conn->fd     = client;
+            pthread_mutex_lock(&srv->conn_lock);
+            if (pthread_create(&thread, &attr, serve_connection, conn) == 0){
+                conn->next       = srv->connections;
+                srv->connections = conn;
+                srv->active++;
+                pthread_mutex_unlock(&srv->conn_lock);
+                connections++;
+                continue;
+            }
+            pthread_mutex_unlock(&srv->conn_lock);
+            free(conn);
+        }
+        fprintf(stderr,"error: unable to serve connection\n");
+        close(client);
+    }
+
+    pthread_attr_destroy(&attr);
+
+    /* Wake connection threads blocked on read and wait for all of them to end */
+    pthread_mutex_lock(&srv->conn_lock);
+    for (connection_t* c = srv->connections; c != NULL; c = c->next){
+        shutdown(c->fd, SHUT_RDWR);
+    }
+    while (srv->active > 0){
+        pthread_cond_wait(&srv->conn_done, &srv->conn_lock);
+    }
+    pthread_mutex_unlock(&srv->conn_lock);
+
+    fprintf(stderr,"serve: %lu connections served\n",connections);
+
+    return 0;
+}
+
+#endif
+
+int serve_cmd(int argc, char** argv){
+
+    char*  address  = NULL;
+    char*  metrics  = NULL;
+    int    interval = DEFAULT_METRICS_INTERVAL;
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    if (argc > 1){
+        while ((ch = getopt_long(argc, argv, "l:M:I:h", list_options, NULL)) != -1) {
+
+            switch (ch) {
+                case 'l':
+                    if (address == NULL){
+                        address = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one listen address is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'M':
+                    if (metrics == NULL){
+                        metrics = optarg;
+                    }else{
+                        fprintf(stderr,"error: only one metrics file is allowed\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'I':
+                    if ((atoi(optarg) > 0) && (atoi(optarg) <= 3600)){
+                        interval = atoi(optarg);
+                    }else{
+                        fprintf(stderr,"error: interval must be > 0 and <= 3600\n");
+                        error_flag--;
+                    }
+                    break;
+                case 'h':
+                    help_flag = true;
+                    break;
+                case 1:
+                    /*
+                    * Use this case if getopt_long() should go through all
+                    * arguments. If so, add a leading '-' character to optstring.
+                    * Actual code, if any, goes here.
+                    */
+                    break;
+                case ':':   /* missing option argument */
+                    //fprintf(stderr, "error: option '-%c' requires an argument\n", optopt);
+                    error_flag--;
+                    break;
+                case '?':
+                default:    /* invalid option */
+                    //fprintf(stderr, "error: option '-%c' is invalid\n", optopt);
+                    error_flag--;
+                    break;
+            }
+        }
+
+        if (optind < argc) {
+            fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+            while (optind < argc){
+                fprintf(stderr," %s", argv[optind++]);
+                error_flag--;
+            }
+            fprintf(stderr,"\n");
+        }
+
+        if (help_flag){
+            printf("command:\n");
+            serve_help(stdout);
+        }else{
+
+            if (address == NULL){
+                fprintf(stderr,"error: -l host:port is required\n");
+                error_flag--;
+            }
+#ifndef _WIN32
+            if (error_flag == 0){
+
+                server_t srv;
+                int      fd = net_listen(address, SOCK_STREAM);
+
+                memset(&srv, 0, sizeof(srv));
+                srv.max_pulses = protocol_maxrawlen();
+                pthread_mutex_init(&srv.codec_lock, NULL);
+                pthread_mutex_init(&srv.conn_lock, NULL);
+                pthread_cond_init(&srv.conn_done, NULL);
+
+                if (fd < 0){
+                    error_flag--;
+                }
+                if (error_flag == 0 && metrics != NULL){
+                    srv.metrics = metrics_new();
+                    if (srv.metrics == NULL || !metrics_export(srv.metrics, metrics, interval)){
+                        error_flag--;
+                    }
+                }
+                if (error_flag == 0){
+                    fprintf(stderr,"serve: listening on %s\n",address);
+                    error_flag = serve_run(&srv, fd);
+                }
+                if (fd >= 0){
+                    close(fd);
+                }
+
+                /* Every connection thread ended in serve_run() */
+                metrics_free(srv.metrics);
+                validator_free(&srv.validator);
+                pthread_cond_destroy(&srv.conn_done);
+                pthread_mutex_destroy(&srv.conn_lock);
+                pthread_mutex_destroy(&srv.codec_lock);
+            }
+#else
+            if (error_flag == 0){
+                fprintf(stderr,"error: serve is not supported on Windows\n");
+                error_flag--;
+            }
+#endif
+        }
+    }else{
+        fprintf(stderr,"error: -l host:port is required\n");
+        error_flag--;
+    }
+
+    return error_flag;
+}
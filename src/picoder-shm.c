@@ -0,0 +1,265 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-shm.h"
+
+#ifndef _WIN32
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+#define SHM_NAME_LENGTH   256
+#define SHM_ATTACH_MS     1000    /* wait creator to initialize header */
+
+_Static_assert(sizeof(shm_header_t) == SHM_RING_HEADER, "shm ring header layout");
+_Static_assert(sizeof(shm_record_t) == 16, "shm ring record layout");
+
+#define RING_LOAD(x, order)       __atomic_load_n(&(x), order)
+#define RING_STORE(x, v, order)   __atomic_store_n(&(x), (v), order)
+
+static void sleep_ms(long ms){
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static void futex_wait(uint32_t* word, uint32_t value, int timeout_ms){
+#ifdef __linux__
+    struct timespec ts = { timeout_ms / 1000, (long)(timeout_ms % 1000) * 1000000L };
+    /* Shared futex, ring is mapped by two processes */
+    syscall(SYS_futex, word, FUTEX_WAIT, value, &ts, NULL, 0);
+#else
+    /* No portable cross process wait, poll each mSec */
+    for (int i = 0; i < timeout_ms && RING_LOAD(*word, __ATOMIC_ACQUIRE) == value; i++){
+        sleep_ms(1);
+    }
+#endif
+}
+
+static void futex_wake(uint32_t* word){
+    __atomic_fetch_add(word, 1, __ATOMIC_RELEASE);
+#ifdef __linux__
+    syscall(SYS_futex, word, FUTEX_WAKE, 1, NULL, NULL, 0);
+#endif
+}
+
+/* Map header of existing ring, wait creator to write magic */
+static shm_header_t* attach_header(int fd, const char* name){
+
+    struct stat st;
+
+    for (int ms = 0; ms <= SHM_ATTACH_MS; ms++){
+        if (fstat(fd, &st) == 0 && st.st_size >= SHM_RING_HEADER){
+            shm_header_t* header = (shm_header_t*)mmap(NULL, SHM_RING_HEADER, PROT_READ, MAP_SHARED, fd, 0);
+            if (header == MAP_FAILED){
+                break;
+            }
+            uint32_t magic;
+            memcpy(&magic, SHM_RING_MAGIC, 4);
+            for (; ms <= SHM_ATTACH_MS; ms++){
+                if (RING_LOAD(*(uint32_t*)header->magic, __ATOMIC_ACQUIRE) == magic){
+                    return header;
+                }
+                sleep_ms(1);
+            }
+            munmap(header, SHM_RING_HEADER);
+            break;
+        }
+        sleep_ms(1);
+    }
+    fprintf(stderr,"error: '%s' is not a picoder shm ring\n",name);
+    return NULL;
+}
+
+bool shm_ring_open(shm_ring_t* ring, const char* name, uint32_t capacity, bool producer){
+
+    char path[SHM_NAME_LENGTH];
+    bool created = true;
+
+    memset(ring, 0, sizeof(*ring));
+
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0){
+        fprintf(stderr,"error: shm ring capacity must be a power of 2\n");
+        return false;
+    }
+    if (snprintf(path, sizeof(path), "%s%s", name[0] == '/' ? "" : "/", name) >= (int)sizeof(path) || strchr(path + 1, '/') != NULL){
+        fprintf(stderr,"error: invalid shm name '%s'\n",name);
+        return false;
+    }
+
+    int fd = shm_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST){
+        created = false;
+        fd = shm_open(path, O_RDWR, 0600);
+    }
+    if (fd < 0){
+        fprintf(stderr,"error: unable to open shm '%s' (%d)\n",name,errno);
+        return false;
+    }
+
+    if (created){
+        if (ftruncate(fd, (off_t)(SHM_RING_HEADER + (size_t)capacity * sizeof(shm_record_t))) != 0){
+            fprintf(stderr,"error: unable to size shm '%s' (%d)\n",name,errno);
+            close(fd);
+            shm_unlink(path);
+            return false;
+        }
+    }else{
+        shm_header_t* header = attach_header(fd, name);
+        if (header == NULL){
+            close(fd);
+            return false;
+        }
+        capacity = header->capacity;
+        bool valid = header->version == SHM_RING_VERSION && header->record_size == sizeof(shm_record_t)
+                  && capacity > 0 && (capacity & (capacity - 1)) == 0;
+        munmap(header, SHM_RING_HEADER);
+        if (!valid){
+            fprintf(stderr,"error: unsupported shm ring '%s'\n",name);
+            close(fd);
+            return false;
+        }
+    }
+
+    ring->size   = SHM_RING_HEADER + (size_t)capacity * sizeof(shm_record_t);
+    ring->header = (shm_header_t*)mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (ring->header == MAP_FAILED){
+        fprintf(stderr,"error: unable to map shm '%s' (%d)\n",name,errno);
+        ring->header = NULL;
+        return false;
+    }
+
+    shm_header_t* h = ring->header;
+
+    if (created){
+        /* New object is zero filled, magic published last */
+        h->version     = SHM_RING_VERSION;
+        h->record_size = sizeof(shm_record_t);
+        h->capacity    = capacity;
+        uint32_t magic;
+        memcpy(&magic, SHM_RING_MAGIC, 4);
+        RING_STORE(*(uint32_t*)h->magic, magic, __ATOMIC_RELEASE);
+    }
+
+    ring->records  = (shm_record_t*)((char*)h + SHM_RING_HEADER);
+    ring->mask     = capacity - 1;
+    ring->producer = producer;
+
+    if (producer){
+        ring->index = RING_LOAD(h->head, __ATOMIC_RELAXED);
+        __atomic_fetch_and(&h->flags, ~(uint32_t)SHM_RING_CLOSED, __ATOMIC_RELEASE);
+    }else{
+        ring->index = RING_LOAD(h->tail, __ATOMIC_RELAXED);
+        /* Closed and drained by a previous consumer, wait next producer */
+        if ((RING_LOAD(h->flags, __ATOMIC_ACQUIRE) & SHM_RING_CLOSED) && RING_LOAD(h->head, __ATOMIC_ACQUIRE) == ring->index){
+            __atomic_fetch_and(&h->flags, ~(uint32_t)SHM_RING_CLOSED, __ATOMIC_RELEASE);
+        }
+    }
+
+    return true;
+}
+
+void shm_ring_close(shm_ring_t* ring){
+
+    if (ring->header == NULL){
+        return;
+    }
+    if (ring->producer){
+        __atomic_fetch_or(&ring->header->flags, SHM_RING_CLOSED, __ATOMIC_SEQ_CST);
+        futex_wake(&ring->header->wake);
+    }else{
+        RING_STORE(ring->header->waiting, 0, __ATOMIC_RELAXED);
+    }
+    munmap(ring->header, ring->size);
+    ring->header = NULL;
+}
+
+size_t shm_ring_write(shm_ring_t* ring, const shm_record_t* records, size_t n){
+
+    shm_header_t* h        = ring->header;
+    uint64_t      tail     = RING_LOAD(h->tail, __ATOMIC_ACQUIRE);
+    uint64_t      space    = (ring->mask + 1) - (ring->index - tail);
+    size_t        written  = n < space ? n : (size_t)space;
+    size_t        first    = (size_t)((ring->mask + 1) - (ring->index & ring->mask));
+
+    if (first > written){
+        first = written;
+    }
+    memcpy(&ring->records[ring->index & ring->mask], records, first * sizeof(*records));
+    memcpy(&ring->records[0], records + first, (written - first) * sizeof(*records));
+
+    ring->index += written;
+    RING_STORE(h->head, ring->index, __ATOMIC_RELEASE);
+
+    if (written < n){
+        __atomic_fetch_add(&h->dropped, n - written, __ATOMIC_RELAXED);
+    }
+
+    /* Pairs with consumer waiting store then head load, one of both sees the other */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (RING_LOAD(h->waiting, __ATOMIC_RELAXED)){
+        futex_wake(&h->wake);
+    }
+
+    return written;
+}
+
+size_t shm_ring_peek(shm_ring_t* ring, const shm_record_t** records){
+
+    uint64_t head  = RING_LOAD(ring->header->head, __ATOMIC_ACQUIRE);
+    size_t   first = (size_t)((ring->mask + 1) - (ring->index & ring->mask));
+    size_t   n     = (size_t)(head - ring->index);
+
+    *records = &ring->records[ring->index & ring->mask];
+
+    return n < first ? n : first;
+}
+
+void shm_ring_release(shm_ring_t* ring, size_t n){
+    ring->index += n;
+    RING_STORE(ring->header->tail, ring->index, __ATOMIC_RELEASE);
+}
+
+int shm_ring_wait(shm_ring_t* ring, int timeout_ms){
+
+    shm_header_t* h    = ring->header;
+    uint32_t      wake = RING_LOAD(h->wake, __ATOMIC_ACQUIRE);
+
+    RING_STORE(h->waiting, 1, __ATOMIC_SEQ_CST);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (RING_LOAD(h->head, __ATOMIC_ACQUIRE) == ring->index && !(RING_LOAD(h->flags, __ATOMIC_ACQUIRE) & SHM_RING_CLOSED)){
+        futex_wait(&h->wake, wake, timeout_ms);
+    }
+
+    RING_STORE(h->waiting, 0, __ATOMIC_RELAXED);
+
+    if (RING_LOAD(h->head, __ATOMIC_ACQUIRE) != ring->index){
+        return 1;
+    }
+    return (RING_LOAD(h->flags, __ATOMIC_ACQUIRE) & SHM_RING_CLOSED) ? -1 : 0;
+}
+
+uint64_t shm_ring_dropped(const shm_ring_t* ring){
+    return RING_LOAD(ring->header->dropped, __ATOMIC_RELAXED);
+}
+
+#endif
@@ -0,0 +1,111 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_SHM_H
+#define PICODER_SHM_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+/*
+    Shared memory ring of timestamped pulses, single producer and single
+    consumer, POSIX shared memory object "/name". Native byte order, every
+    index on its own 64 bytes cache line:
+
+        offset   0   char[4]   magic "PISR", written last by creator
+                 4   uint16    version (1)
+                 6   uint16    record size (16)
+                 8   uint32    capacity in records, power of 2
+                12   uint32    flags, SHM_RING_CLOSED
+                16   uint64    records dropped by producer, ring full
+                64   uint64    head, records written by producer
+               128   uint64    tail, records read by consumer
+               136   uint32    consumer waiting
+               140   uint32    wake sequence, futex word
+               192   records   capacity * record
+
+        record   uint32    pulse uSecs
+                 uint32    reserved (0)
+                 uint64    pulse start nSecs CLOCK_REALTIME, 0 if unknown
+
+    Producer copies records at head % capacity, then stores head with
+    release order. Consumer loads head with acquire order, reads records in
+    place and stores tail. Producer never blocks: records over capacity are
+    dropped and counted. Consumer sleeps on the wake sequence futex (Linux)
+    after setting waiting; producer, after storing head, increments wake
+    sequence and wakes it only if waiting is set, so no syscall is needed
+    while the consumer keeps up. Producer sets SHM_RING_CLOSED at end of
+    stream, a new producer clears it.
+*/
+
+#define SHM_RING_MAGIC        "PISR"
+#define SHM_RING_VERSION      1
+#define SHM_RING_HEADER       192
+#define SHM_RING_CLOSED       0x0001
+
+#ifndef SHM_RING_CAPACITY
+#define SHM_RING_CAPACITY     65536    /* records of a new ring */
+#endif
+
+typedef struct {
+    uint32_t  pulse;
+    uint32_t  reserved;
+    uint64_t  timestamp;
+} shm_record_t;
+
+typedef struct {
+    char      magic[4];
+    uint16_t  version;
+    uint16_t  record_size;
+    uint32_t  capacity;
+    uint32_t  flags;
+    uint64_t  dropped;
+    char      reserved0[40];
+    uint64_t  head;
+    char      reserved1[56];
+    uint64_t  tail;
+    uint32_t  waiting;
+    uint32_t  wake;
+    char      reserved2[48];
+} shm_header_t;
+
+typedef struct {
+    shm_header_t*  header;
+    shm_record_t*  records;
+    size_t         size;        /* mapped bytes */
+    uint64_t       mask;        /* capacity - 1 */
+    uint64_t       index;       /* own index, head if producer, tail if consumer */
+    bool           producer;
+} shm_ring_t;
+
+#ifndef _WIN32
+
+/* Attach ring, created with capacity (power of 2) if not exists. Shows error on fails */
+bool shm_ring_open(shm_ring_t* ring, const char* name, uint32_t capacity, bool producer);
+
+/* Producer end of stream sets SHM_RING_CLOSED, then unmap */
+void shm_ring_close(shm_ring_t* ring);
+
+/* Producer append, returns records written, the rest dropped */
+size_t shm_ring_write(shm_ring_t* ring, const shm_record_t* records, size_t n);
+
+/* Consumer records readable in place up to ring end, 0 if empty */
+size_t shm_ring_peek(shm_ring_t* ring, const shm_record_t** records);
+
+/* Consumer done with n records returned by shm_ring_peek() */
+void shm_ring_release(shm_ring_t* ring, size_t n);
+
+/* Consumer wait for records, returns 1 if readable, 0 on timeout or signal, -1 if closed and empty */
+int shm_ring_wait(shm_ring_t* ring, int timeout_ms);
+
+/* Records dropped by producer */
+uint64_t shm_ring_dropped(const shm_ring_t* ring);
+
+#endif
+
+#endif
@@ -7,6 +7,7 @@
 */
 
 #include "picoder-show.h"
+#include "picoder-stats.h"
 #include <getopt.h>
 
 extern const char* devtype[];
@@ -104,6 +105,7 @@ int show_cmd(int argc, char** argv){
             
             if (error_flag==0){ 
 
+                stats_phase(STATS_OUTPUT);
                 printf("Protocol:    %s\n",protocol->id);   
                 printf("Encode:      %s\n",protocol->createCode==NULL ? "Unsupported":"Supported");   
                 printf("Device type: %d (%s)\n",protocol->devtype,devtype[protocol->devtype]);  
@@ -0,0 +1,914 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-spec.h"
+#include "picoder-sample.h"
+#include "picoder-stats.h"
+#include <getopt.h>
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <time.h>
+
+#ifndef MAX_PULSES
+#define MAX_PULSES    255
+#endif
+
+#ifndef MAX_SPEC_LINE
+#define MAX_SPEC_LINE    1024
+#endif
+
+#ifndef MAX_SPEC_FILES
+#define MAX_SPEC_FILES     8
+#endif
+
+#ifndef MAX_SPEC_SAMPLES
+#define MAX_SPEC_SAMPLES  64
+#endif
+
+#define MAX_SPEC_LABEL     32
+
+#define DEFAULT_SPEC_REPEATS   1000
+#define MAX_SPEC_REPEATS     100000
+
+/* Builtin specs generated from specs/ by CMake, as SPEC_BUILTIN initializers */
+#ifdef HAVE_SPEC_TABLE
+#include "picoder-specs.h"
+#endif
+
+#ifndef SPEC_BUILTIN
+#define SPEC_BUILTIN
+#endif
+
+static const spec_t spec_builtin[] = { SPEC_BUILTIN { NULL } };
+
+/* Symbol of count pulses within bounds, count is constant when inlined */
+static inline bool symbol_match(const spec_symbol_t* symbol, const uint32_t* pulses, int count){
+    for (int i = 0; i < count; i++){
+        if (pulses[i] < symbol->min[i] || pulses[i] > symbol->max[i]){
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline bool match_bits(const spec_t* spec, const uint32_t* pulses, uint64_t* bits, int count){
+
+    uint64_t value = 0;
+
+    for (int b = 0; b < spec->bits; b++, pulses += count){
+        if (symbol_match(&spec->zero, pulses, count)){
+            value <<= 1;
+        }else if (symbol_match(&spec->one, pulses, count)){
+            value = (value << 1) | 1;
+        }else{
+            return false;
+        }
+    }
+    *bits = value;
+    return true;
+}
+
+bool spec_match(const spec_t* spec, const uint32_t* pulses, int n_pulses, uint64_t* bits){
+
+    if (n_pulses != spec->n_pulses
+        || !symbol_match(&spec->footer, pulses + n_pulses - spec->footer.count, spec->footer.count)
+        || !symbol_match(&spec->header, pulses, spec->header.count)){
+        return false;
+    }
+    pulses += spec->header.count;
+
+    /* Common symbol sizes get their own unrolled loop */
+    switch (spec->zero.count){
+        case 2:
+            return match_bits(spec, pulses, bits, 2);
+        case 4:
+            return match_bits(spec, pulses, bits, 4);
+        default:
+            return match_bits(spec, pulses, bits, spec->zero.count);
+    }
+}
+
+static uint32_t reverse_bits(uint32_t value, int width){
+    uint32_t reversed = 0;
+    for (int i = 0; i < width; i++){
+        reversed = (reversed << 1) | ((value >> i) & 1);
+    }
+    return reversed;
+}
+
+static uint32_t field_value(const spec_t* spec, const spec_field_t* field, uint64_t bits){
+
+    uint32_t value = (uint32_t)((bits >> (spec->bits - field->offset - field->width)) & ((1ULL << field->width) - 1));
+
+    return (field->flags & SPEC_FIELD_REVERSE) ? reverse_bits(value, field->width) : value;
+}
+
+/* Label at index of '/' separated labels, NULL if none */
+static const char* label_at(const char* labels, uint32_t index, size_t* len){
+
+    while (index > 0 && labels != NULL){
+        labels = strchr(labels, '/');
+        if (labels != NULL){
+            labels++;
+        }
+        index--;
+    }
+    if (labels != NULL){
+        const char* end = strchr(labels, '/');
+        *len = end ? (size_t)(end - labels) : strlen(labels);
+    }
+    return labels;
+}
+
+static int label_count(const char* labels){
+    int count = 1;
+    while ((labels = strchr(labels, '/')) != NULL){
+        labels++;
+        count++;
+    }
+    return count;
+}
+
+static JsonNode* spec_json(const spec_t* spec, uint64_t bits){
+
+    JsonNode* fields = json_mkobject();
+
+    for (int f = 0; f < spec->n_fields; f++){
+
+        const spec_field_t* field = &spec->fields[f];
+        uint32_t            value = field_value(spec, field, bits);
+
+        if (field->flags & SPEC_FIELD_CONST){
+            if (value != field->value){
+                json_delete(fields);
+                return NULL;
+            }
+        }else if (field->flags & SPEC_FIELD_LABELS){
+            char        label[MAX_SPEC_LABEL];
+            size_t      len  = 0;
+            const char* name = label_at(field->labels, value, &len);
+            if (name == NULL || len >= sizeof(label)){
+                json_delete(fields);
+                return NULL;
+            }
+            memcpy(label, name, len);
+            label[len] = '\0';
+            json_append_member(fields, field->name, json_mkstring(label));
+        }else{
+            json_append_member(fields, field->name, json_mknumber(value, 0));
+        }
+    }
+
+    JsonNode* root      = json_mkobject();
+    JsonNode* protocols = json_mkarray();
+    JsonNode* message   = json_mkobject();
+
+    json_append_member(message, spec->protocol, fields);
+    json_append_element(protocols, message);
+    json_append_member(root, "protocols", protocols);
+
+    return root;
+}
+
+/*
+    Compact json written directly, as json_stringify() without indent. Names
+    and labels of specs have nothing to escape. NULL if a constant differs.
+*/
+static char* spec_compact(const spec_t* spec, uint64_t bits){
+
+    size_t size = strlen(spec->protocol) + 32;
+
+    for (int f = 0; f < spec->n_fields; f++){
+        size += strlen(spec->fields[f].name) + 16 + MAX_SPEC_LABEL;
+    }
+
+    char*  json = (char*)malloc(size);
+    size_t len;
+
+    if (json == NULL){
+        return NULL;
+    }
+    len = (size_t)snprintf(json, size, "{\"protocols\":[{\"%s\":{", spec->protocol);
+
+    for (int f = 0, n = 0; f < spec->n_fields; f++){
+
+        const spec_field_t* field = &spec->fields[f];
+        uint32_t            value = field_value(spec, field, bits);
+
+        if (field->flags & SPEC_FIELD_CONST){
+            if (value != field->value){
+                free(json);
+                return NULL;
+            }
+        }else if (field->flags & SPEC_FIELD_LABELS){
+            size_t      label_len = 0;
+            const char* label     = label_at(field->labels, value, &label_len);
+            if (label == NULL || label_len >= MAX_SPEC_LABEL){
+                free(json);
+                return NULL;
+            }
+            len += (size_t)snprintf(json + len, size - len, "%s\"%s\":\"%.*s\"", n++ ? "," : "", field->name, (int)label_len, label);
+        }else{
+            len += (size_t)snprintf(json + len, size - len, "%s\"%s\":%lu", n++ ? "," : "", field->name, (unsigned long)value);
+        }
+    }
+    snprintf(json + len, size - len, "}}]}");
+
+    return json;
+}
+
+char* spec_decode(const spec_table_t* table, const uint32_t* pulses, int n_pulses, const char* indent){
+
+    uint64_t bits;
+
+    for (int s = 0; s < table->count; s++){
+        const spec_t* spec = &table->specs[s];
+        if (spec_match(spec, pulses, n_pulses, &bits)){
+            if (indent == NULL){
+                char* json = spec_compact(spec, bits);
+                if (json != NULL){
+                    return json;
+                }
+                continue;
+            }
+            JsonNode* root = spec_json(spec, bits);
+            if (root != NULL){
+                char* json = json_stringify(root, indent);
+                json_delete(root);
+                return json;
+            }
+        }
+    }
+    return NULL;
+}
+
+int spec_encode(const spec_t* spec, const char* json_data, uint32_t* pulses, uint16_t max_pulses, char* error){
+
+    JsonNode* json = json_decode(json_data);
+    uint64_t  bits = 0;
+
+    if (json == NULL){
+        snprintf(error, SPEC_ERROR, "json data invalid");
+        return -1;
+    }
+
+    for (int f = 0; f < spec->n_fields; f++){
+
+        const spec_field_t* field = &spec->fields[f];
+        uint32_t            value = 0;
+
+        if (field->flags & SPEC_FIELD_CONST){
+            value = field->value;
+        }else if (field->flags & SPEC_FIELD_LABELS){
+            /* One "label":1 member selects the value, as pilight state options */
+            JsonNode* member = NULL;
+            json_foreach(member, json){
+                size_t      len   = 0;
+                const char* label = NULL;
+                for (value = 0; member->key != NULL && (label = label_at(field->labels, value, &len)) != NULL; value++){
+                    if (strlen(member->key) == len && strncmp(member->key, label, len) == 0){
+                        break;
+                    }
+                }
+                if (label != NULL){
+                    break;
+                }
+            }
+            if (member == NULL){
+                snprintf(error, SPEC_ERROR, "one of '%s' required", field->labels);
+                json_delete(json);
+                return -1;
+            }
+        }else{
+            JsonNode* member = json_find_member(json, field->name);
+            double    max    = (double)((1ULL << field->width) - 1);
+            if (member == NULL || member->tag != JSON_NUMBER || member->number_ < 0 || member->number_ > max
+                || member->number_ != (double)(uint32_t)member->number_){
+                snprintf(error, SPEC_ERROR, "'%s' must be from 0 to %.0f", field->name, max);
+                json_delete(json);
+                return -1;
+            }
+            value = (uint32_t)member->number_;
+        }
+
+        if (field->flags & SPEC_FIELD_REVERSE){
+            value = reverse_bits(value, field->width);
+        }
+        bits |= (uint64_t)value << (spec->bits - field->offset - field->width);
+    }
+    json_delete(json);
+
+    if (spec->n_pulses > max_pulses){
+        snprintf(error, SPEC_ERROR, "%d pulses exceed %d", spec->n_pulses, max_pulses);
+        return -1;
+    }
+
+    int n_pulses = 0;
+
+    for (int i = 0; i < spec->header.count; i++){
+        pulses[n_pulses++] = spec->pulse * spec->header.length[i];
+    }
+    for (int b = spec->bits - 1; b >= 0; b--){
+        const spec_symbol_t* symbol = ((bits >> b) & 1) ? &spec->one : &spec->zero;
+        for (int i = 0; i < symbol->count; i++){
+            pulses[n_pulses++] = spec->pulse * symbol->length[i];
+        }
+    }
+    for (int i = 0; i < spec->footer.count; i++){
+        pulses[n_pulses++] = spec->pulse * spec->footer.length[i];
+    }
+
+    return n_pulses;
+}
+
+/* Letters, digits, '_', '-' and separator only, json strings without escapes */
+static bool plain_name(const char* name, char separator){
+    if (name == NULL || *name == '\0'){
+        return false;
+    }
+    for (; *name != '\0'; name++){
+        if (!isalnum((unsigned char)*name) && *name != '_' && *name != '-' && *name != separator){
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Check spec made by hand or generated, error set if invalid */
+static bool spec_validate(const spec_t* spec, char* error){
+
+    bool distinct = false;
+
+    if (!plain_name(spec->protocol, '\0')){
+        snprintf(error, SPEC_ERROR, "protocol name invalid");
+    }else if (spec->pulse == 0){
+        snprintf(error, SPEC_ERROR, "pulse required");
+    }else if (spec->bits == 0 || spec->bits > MAX_SPEC_BITS){
+        snprintf(error, SPEC_ERROR, "bits must be from 1 to %d", MAX_SPEC_BITS);
+    }else if (spec->tolerance >= 100){
+        snprintf(error, SPEC_ERROR, "tolerance must be < 100");
+    }else if (spec->zero.count == 0 || spec->zero.count != spec->one.count){
+        snprintf(error, SPEC_ERROR, "zero and one must have the same number of pulses");
+    }else if (spec->footer.count == 0){
+        snprintf(error, SPEC_ERROR, "footer required");
+    }else if (spec->n_pulses > MAX_PULSES){
+        snprintf(error, SPEC_ERROR, "%d pulses exceed %d", spec->n_pulses, MAX_PULSES);
+    }else{
+        /* Some pulse must tell zero and one apart whatever its deviation */
+        for (int i = 0; i < spec->zero.count; i++){
+            if (spec->zero.max[i] < spec->one.min[i] || spec->one.max[i] < spec->zero.min[i]){
+                distinct = true;
+            }
+        }
+        if (!distinct){
+            snprintf(error, SPEC_ERROR, "zero and one overlap within tolerance");
+            return false;
+        }
+        for (int f = 0; f < spec->n_fields; f++){
+            const spec_field_t* field = &spec->fields[f];
+            if (!plain_name(field->name, '\0') || ((field->flags & SPEC_FIELD_LABELS) && !plain_name(field->labels, '/'))){
+                snprintf(error, SPEC_ERROR, "field name or labels invalid");
+                return false;
+            }
+            if (field->width == 0 || field->width > 32 || field->offset + field->width > spec->bits){
+                snprintf(error, SPEC_ERROR, "field '%s' out of bits", field->name);
+                return false;
+            }
+            if ((field->flags & SPEC_FIELD_LABELS) && (field->width > 8 || label_count(field->labels) != (1 << field->width))){
+                snprintf(error, SPEC_ERROR, "field '%s' needs %d labels", field->name, field->width > 8 ? 256 : 1 << field->width);
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+static void symbol_bounds(spec_symbol_t* symbol, uint32_t pulse, uint8_t tolerance, bool footer){
+    for (int i = 0; i < symbol->count; i++){
+        if (footer && i == symbol->count - 1){
+            symbol->min[i] = SPEC_GAP_MIN(pulse, symbol->length[i]);
+            symbol->max[i] = SPEC_GAP_MAX(pulse, symbol->length[i]);
+        }else{
+            symbol->min[i] = SPEC_MIN(pulse, tolerance, symbol->length[i]);
+            symbol->max[i] = SPEC_MAX(pulse, tolerance, symbol->length[i]);
+        }
+    }
+}
+
+static bool parse_symbol(char* value, spec_symbol_t* symbol){
+
+    char* end;
+
+    symbol->count = 0;
+    while (*value != '\0'){
+        unsigned long length = strtoul(value, &end, 10);
+        if (end == value || length == 0 || length > 0xFFFF || symbol->count == MAX_SPEC_SYMBOL || (*end != ',' && *end != '\0')){
+            return false;
+        }
+        symbol->length[symbol->count++] = (uint16_t)length;
+        value = (*end == ',') ? end + 1 : end;
+    }
+    return symbol->count > 0;
+}
+
+/* Split in place at sep, returns next part or NULL */
+static char* split(char* str, char sep){
+    char* next = strchr(str, sep);
+    if (next != NULL){
+        *next++ = '\0';
+    }
+    return next;
+}
+
+static bool parse_field(char* value, spec_field_t* field){
+
+    char* offset = split(value, ':');
+    char* width  = offset ? split(offset, ':') : NULL;
+    char* last   = width ? split(width, ':') : NULL;
+    char* end;
+
+    if (width == NULL || *value == '\0'){
+        return false;
+    }
+    field->name   = value;
+    field->offset = (uint8_t)strtoul(offset, &end, 10);
+    if (*end != '\0' || *offset == '\0'){
+        return false;
+    }
+    field->width  = (uint8_t)strtoul(width, &end, 10);
+    if (*end != '\0' || *width == '\0'){
+        return false;
+    }
+    field->flags  = 0;
+    field->value  = 0;
+    field->labels = NULL;
+
+    if (last == NULL){
+        return true;
+    }else if (strcmp(last, "r") == 0){
+        field->flags = SPEC_FIELD_REVERSE;
+    }else if (*last == '='){
+        field->flags = SPEC_FIELD_CONST;
+        field->value = (uint32_t)strtoul(last + 1, &end, 0);
+        return *end == '\0' && last[1] != '\0';
+    }else if (strchr(last, '/') != NULL){
+        field->flags  = SPEC_FIELD_LABELS;
+        field->labels = last;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+/* Parse spec line in place, strings of spec point to line */
+static bool spec_parse(char* line, spec_t* spec, char* error){
+
+    char* token = strtok(line, " \t");
+
+    memset(spec, 0, sizeof(*spec));
+    spec->protocol  = token;
+    spec->tolerance = DEFAULT_SPEC_TOLERANCE;
+
+    while ((token = strtok(NULL, " \t")) != NULL){
+
+        char* value = split(token, '=');
+        bool  valid = value != NULL;
+
+        if (!valid){
+            ;
+        }else if (strcmp(token, "pulse") == 0){
+            spec->pulse = (uint32_t)atol(value);
+        }else if (strcmp(token, "bits") == 0){
+            valid = atoi(value) > 0 && atoi(value) <= MAX_SPEC_BITS;
+            spec->bits = (uint8_t)atoi(value);
+        }else if (strcmp(token, "tolerance") == 0){
+            valid = atoi(value) >= 0 && atoi(value) < 100;
+            spec->tolerance = (uint8_t)atoi(value);
+        }else if (strcmp(token, "header") == 0){
+            valid = parse_symbol(value, &spec->header);
+        }else if (strcmp(token, "zero") == 0){
+            valid = parse_symbol(value, &spec->zero);
+        }else if (strcmp(token, "one") == 0){
+            valid = parse_symbol(value, &spec->one);
+        }else if (strcmp(token, "footer") == 0){
+            valid = parse_symbol(value, &spec->footer);
+        }else if (strcmp(token, "fields") == 0){
+            for (char* next; value != NULL; value = next){
+                next = split(value, ',');
+                if (spec->n_fields == MAX_SPEC_FIELDS){
+                    snprintf(error, SPEC_ERROR, "more than %d fields", MAX_SPEC_FIELDS);
+                    return false;
+                }
+                if (!parse_field(value, &spec->fields[spec->n_fields++])){
+                    snprintf(error, SPEC_ERROR, "field '%s' invalid", value);
+                    return false;
+                }
+            }
+        }else{
+            snprintf(error, SPEC_ERROR, "unknown key '%s'", token);
+            return false;
+        }
+        if (!valid){
+            snprintf(error, SPEC_ERROR, value ? "%s '%s' invalid" : "'%s' is not key=value", token, value);
+            return false;
+        }
+    }
+
+    symbol_bounds(&spec->header, spec->pulse, spec->tolerance, false);
+    symbol_bounds(&spec->zero,   spec->pulse, spec->tolerance, false);
+    symbol_bounds(&spec->one,    spec->pulse, spec->tolerance, false);
+    symbol_bounds(&spec->footer, spec->pulse, spec->tolerance, true);
+    spec->n_pulses = (uint16_t)(spec->header.count + spec->bits * spec->zero.count + spec->footer.count);
+
+    return spec_validate(spec, error);
+}
+
+const spec_t* spec_find(const spec_table_t* table, const char* protocol){
+    for (int s = 0; s < table->count; s++){
+        if (strcmp(table->specs[s].protocol, protocol) == 0){
+            return &table->specs[s];
+        }
+    }
+    return NULL;
+}
+
+/* Add or replace spec of same protocol */
+static bool spec_add(spec_table_t* table, const spec_t* spec){
+
+    spec_t* found = (spec_t*)spec_find(table, spec->protocol);
+
+    if (found != NULL){
+        free(found->text);
+        *found = *spec;
+        return true;
+    }
+    if (table->count == MAX_SPECS){
+        return false;
+    }
+    table->specs[table->count++] = *spec;
+    return true;
+}
+
+bool spec_table_init(spec_table_t* table){
+
+    char error[SPEC_ERROR];
+
+    table->count = 0;
+    table->specs = (spec_t*)malloc(sizeof(*table->specs) * MAX_SPECS);
+
+    if (table->specs == NULL){
+        return false;
+    }
+    for (const spec_t* spec = spec_builtin; spec->protocol != NULL; spec++){
+        if (!spec_validate(spec, error)){
+            fprintf(stderr,"error: builtin spec '%s' %s\n", spec->protocol, error);
+            return false;
+        }
+        if (!spec_add(table, spec)){
+            return false;
+        }
+    }
+    return true;
+}
+
+int spec_table_load(spec_table_t* table, const char* file, char* error){
+
+    FILE*         in     = fopen(file, "r");
+    char          line[MAX_SPEC_LINE];
+    unsigned long number = 0;
+    int           loaded = 0;
+
+    if (in == NULL){
+        snprintf(error, SPEC_ERROR, "unable to open '%s'", file);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), in) != NULL){
+
+        char*  start = line;
+        size_t len   = strlen(line);
+        spec_t spec;
+
+        number++;
+        while (len > 0 && isspace((unsigned char)line[len-1])){
+            line[--len] = '\0';
+        }
+        while (isspace((unsigned char)*start)){
+            start++;
+        }
+        if (*start == '\0' || *start == '#'){
+            continue;
+        }
+
+        char* text = strdup(start);
+        char  reason[SPEC_ERROR];
+
+        if (text == NULL){
+            snprintf(error, SPEC_ERROR, "malloc fail!");
+            loaded = -1;
+            break;
+        }
+        if (!spec_parse(text, &spec, reason)){
+            snprintf(error, SPEC_ERROR, "%.32s line %lu: %.64s", file, number, reason);
+            free(text);
+            loaded = -1;
+            break;
+        }
+        spec.text = text;
+        if (!spec_add(table, &spec)){
+            snprintf(error, SPEC_ERROR, "%s line %lu: more than %d specs", file, number, MAX_SPECS);
+            free(text);
+            loaded = -1;
+            break;
+        }
+        loaded++;
+    }
+    fclose(in);
+
+    return loaded;
+}
+
+void spec_table_free(spec_table_t* table){
+    for (int s = 0; s < table->count && table->specs != NULL; s++){
+        free(table->specs[s].text);
+    }
+    free(table->specs);
+    table->specs = NULL;
+    table->count = 0;
+}
+
+static struct option list_options[] = {
+  { "file",       required_argument, NULL,      'f' },
+  { "proto",      required_argument, NULL,      'p' },
+  { "check",      no_argument,       NULL,      'c' },
+  { "repeats",    required_argument, NULL,      'n' },
+  { "help",       no_argument,       NULL,      'h' },
+  { NULL, 0, NULL, 0 }
+ };
+
+void spec_help(FILE* out){
+    fprintf(out,"         spec [-h] [-f file] [-p protocol] [-c]       --> list table driven protocol timing specs\n");
+    fprintf(out,"              [-h | --help]                           --> show command options\n");
+    fprintf(out,"              [-f | --file specs]                     --> add specs of file to builtin ones, up to %d\n", MAX_SPEC_FILES);
+    fprintf(out,"              [-p | --proto protocol]                 --> show only spec of protocol\n");
+    fprintf(out,"              [-c | --check]                          --> decode and encode sample codes as PiCode, timing both\n");
+    fprintf(out,"              [-n | --repeats repeats]                --> timed decodes of every sample (default %d)\n", DEFAULT_SPEC_REPEATS);
+}
+
+/* Sample codes of a spec protocol, PiCode encoded */
+typedef struct {
+    const spec_t*  spec;
+    int            count;
+    int            n_pulses[MAX_SPEC_SAMPLES];
+    uint32_t       pulses[MAX_SPEC_SAMPLES][MAX_PULSES];
+    int            decoded;     /* same json as decodePulseTrain() */
+    int            encoded;     /* same pulses as encodeToPulseTrain() */
+} spec_check_t;
+
+static void spec_check_sample(void* ctx, protocol_t* protocol, const char* json, const uint32_t* pulses, int n_pulses){
+
+    spec_check_t* check = (spec_check_t*)ctx;
+    spec_table_t  one   = { (spec_t*)check->spec, 1 };
+    uint32_t      mine[MAX_PULSES];
+    char          error[SPEC_ERROR];
+
+    if (check->count == MAX_SPEC_SAMPLES || n_pulses <= 0 || n_pulses > MAX_PULSES){
+        return;
+    }
+    memcpy(check->pulses[check->count], pulses, sizeof(*pulses) * (size_t)n_pulses);
+    check->n_pulses[check->count++] = n_pulses;
+
+    char* expected = decodePulseTrain((uint32_t*)pulses, (uint8_t)n_pulses, NULL);
+    char* decoded  = spec_decode(&one, pulses, n_pulses, NULL);
+
+    if (expected != NULL && decoded != NULL && strcmp(expected, decoded) == 0){
+        check->decoded++;
+    }else{
+        fprintf(stderr,"mismatch: %s decode %s: %s, spec %s\n", check->spec->protocol, json, expected ? expected : "fail", decoded ? decoded : "no match");
+    }
+    free(expected);
+    free(decoded);
+
+    int n_mine = spec_encode(check->spec, json, mine, MAX_PULSES, error);
+
+    if (n_mine == n_pulses && memcmp(mine, pulses, sizeof(*pulses) * (size_t)n_pulses) == 0){
+        check->encoded++;
+    }else{
+        fprintf(stderr,"mismatch: %s encode %s: %s\n", check->spec->protocol, json, n_mine < 0 ? error : "other pulses");
+    }
+}
+
+/* usec per decode of every sample, by spec kernel or by PiCode parsers */
+static double spec_check_time(const spec_check_t* check, int repeats, bool picode){
+
+    spec_table_t one   = { (spec_t*)check->spec, 1 };
+    clock_t      start = clock();
+
+    for (int r = 0; r < repeats; r++){
+        for (int i = 0; i < check->count; i++){
+            char* json = picode ? decodePulseTrain((uint32_t*)check->pulses[i], (uint8_t)check->n_pulses[i], NULL)
+                                : spec_decode(&one, check->pulses[i], check->n_pulses[i], NULL);
+            free(json);
+        }
+    }
+    return (double)(clock() - start) * 1e6 / CLOCKS_PER_SEC / ((double)repeats * check->count);
+}
+
+static int spec_check(const spec_table_t* table, const spec_t* only, int repeats){
+
+    uint16_t  max_pulses = protocol_maxrawlen();
+    uint32_t* pulses     = (uint32_t*)malloc(sizeof(*pulses) * (max_pulses + 1));
+    int       error_flag = 0;
+
+    if (pulses == NULL){
+        fprintf(stderr,"error: malloc fail!\n");
+        return -1;
+    }
+
+    printf("protocol                        samples  decoded  encoded   usec spec  usec picode  speedup\n");
+
+    for (int s = 0; s < table->count; s++){
+
+        const spec_t*  spec     = &table->specs[s];
+        protocol_t*    protocol = findProtocol(spec->protocol);
+        spec_check_t*  check;
+
+        if (only != NULL && spec != only){
+            continue;
+        }
+        if (protocol == NULL || protocol->createCode == NULL){
+            printf("%-30s  no PiCode encoder to check\n", spec->protocol);
+            continue;
+        }
+        check = (spec_check_t*)calloc(1, sizeof(*check));
+        if (check == NULL){
+            fprintf(stderr,"error: malloc fail!\n");
+            error_flag--;
+            break;
+        }
+        check->spec = spec;
+
+        stats_phase(STATS_CODEC);
+        sample_codes(protocol, pulses, max_pulses, spec_check_sample, check);
+
+        if (check->count > 0){
+            double usec_spec   = spec_check_time(check, repeats, false);
+            double usec_picode = spec_check_time(check, repeats, true);
+            stats_phase(STATS_OUTPUT);
+
+            printf("%-30s  %7d  %7d  %7d  %10.3f  %11.3f  %6.1fx\n", spec->protocol, check->count, check->decoded, check->encoded,
+                   usec_spec, usec_picode, usec_spec > 0 ? usec_picode / usec_spec : 0);
+
+            if (check->decoded != check->count || check->encoded != check->count){
+                error_flag--;
+            }
+        }else{
+            stats_phase(STATS_OUTPUT);
+            printf("%-30s  no sample codes encoded\n", spec->protocol);
+        }
+        free(check);
+    }
+    free(pulses);
+
+    return error_flag;
+}
+
+static int print_symbol(const spec_symbol_t* symbol){
+    int len = 0;
+    for (int i = 0; i < symbol->count; i++){
+        len += printf("%s%u", i ? "," : "", symbol->length[i]);
+    }
+    return len;
+}
+
+static void spec_list(const spec_table_t* table, const spec_t* only){
+
+    printf("protocol                        pulses  bits  pulse  tol  zero     one      footer    fields\n");
+
+    for (int s = 0; s < table->count; s++){
+
+        const spec_t* spec = &table->specs[s];
+
+        if (only != NULL && spec != only){
+            continue;
+        }
+        printf("%-30s  %6d  %4d  %5u  %2d%%  ", spec->protocol, spec->n_pulses, spec->bits, spec->pulse, spec->tolerance);
+        printf("%*s", 9 - print_symbol(&spec->zero), "");
+        printf("%*s", 9 - print_symbol(&spec->one), "");
+        printf("%*s", 10 - print_symbol(&spec->footer), "");
+        for (int f = 0, n = 0; f < spec->n_fields; f++){
+            if (!(spec->fields[f].flags & SPEC_FIELD_CONST)){
+                printf("%s%s", n++ ? "," : "", spec->fields[f].name);
+            }
+        }
+        printf("%s\n", spec->text ? "" : " (builtin)");
+    }
+}
+
+int spec_cmd(int argc, char** argv){
+
+    spec_table_t  table     = { NULL, 0 };
+    const char*   files[MAX_SPEC_FILES];
+    int           n_files   = 0;
+    const char*   proto     = NULL;
+    bool          check     = false;
+    int           repeats   = DEFAULT_SPEC_REPEATS;
+    char          error[SPEC_ERROR];
+
+    int  error_flag = 0;
+    bool help_flag  = false;
+    int  ch         = 1;
+
+    while ((ch = getopt_long(argc, argv, "f:p:cn:h", list_options, NULL)) != -1) {
+
+        switch (ch) {
+            case 'f':
+                if (n_files < MAX_SPEC_FILES){
+                    files[n_files++] = optarg;
+                }else{
+                    fprintf(stderr,"error: max %d spec files are allowed\n",MAX_SPEC_FILES);
+                    error_flag--;
+                }
+                break;
+            case 'p':
+                if (proto == NULL){
+                    proto = optarg;
+                }else{
+                    fprintf(stderr,"error: only one protocol is allowed\n");
+                    error_flag--;
+                }
+                break;
+            case 'c':
+                check = true;
+                break;
+            case 'n':
+                if ((atoi(optarg) > 0) && (atoi(optarg) <= MAX_SPEC_REPEATS)){
+                    repeats = atoi(optarg);
+                }else{
+                    fprintf(stderr,"error: repeats must be > 0 and <= %d\n",MAX_SPEC_REPEATS);
+                    error_flag--;
+                }
+                break;
+            case 'h':
+                help_flag = true;
+                break;
+            case ':':   /* missing option argument */
+                error_flag--;
+                break;
+            case '?':
+            default:    /* invalid option */
+                error_flag--;
+                break;
+        }
+    }
+
+    if (optind < argc) {
+        fprintf(stderr,"error: invalid parameters (%d)", argc - optind );
+        while (optind < argc){
+            fprintf(stderr," %s", argv[optind++]);
+            error_flag--;
+        }
+        fprintf(stderr,"\n");
+    }
+
+    if (help_flag){
+        printf("command:\n");
+        spec_help(stdout);
+
+    }else if (error_flag == 0){
+
+        if (!spec_table_init(&table)){
+            fprintf(stderr,"error: unable to init builtin specs\n");
+            error_flag--;
+        }
+        for (int i = 0; i < n_files && error_flag == 0; i++){
+            if (spec_table_load(&table, files[i], error) < 0){
+                fprintf(stderr,"error: %s\n", error);
+                error_flag--;
+            }
+        }
+
+        const spec_t* only = (error_flag == 0 && proto != NULL) ? spec_find(&table, proto) : NULL;
+
+        if (error_flag == 0 && proto != NULL && only == NULL){
+            fprintf(stderr,"error: no spec of protocol '%s'\n", proto);
+            error_flag--;
+        }else if (error_flag == 0 && check){
+            error_flag = spec_check(&table, only, repeats);
+        }else if (error_flag == 0){
+            spec_list(&table, only);
+        }
+    }
+    spec_table_free(&table);
+
+    return error_flag;
+}
@@ -0,0 +1,146 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_SPEC_H
+#define PICODER_SPEC_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+/*
+    Timing spec of a pulse width protocol, one per line of a spec file:
+
+        protocol pulse=300 bits=13 zero=1,3 one=3,1 footer=1,30 fields=id:0:8,unit:8:4,state:12:1:off/on
+
+    pulse       base pulse length in uSecs, every length is a multiple of it
+    bits        number of data bits, up to MAX_SPEC_BITS
+    zero, one   pulses of each bit value, same count, up to MAX_SPEC_SYMBOL
+    header      optional pulses ahead of the bits
+    footer      pulses after the bits, the last one is the frame gap
+    tolerance   optional percent of each length a pulse may deviate
+    fields      name:offset:width, most significant bit first, with an
+                optional last part 'r' for least significant bit first,
+                '=value' for a constant not in json, or '/' separated labels
+                decoded as string and encoded from the "label":1 member
+
+    Lines starting with '#' are comments. Specs in specs/ are compiled to a
+    builtin table by CMake, see specs/specs.cmake.
+*/
+
+#define MAX_SPEC_SYMBOL      4
+#define MAX_SPEC_FIELDS      8
+#define MAX_SPEC_BITS       64
+
+#ifndef MAX_SPECS
+#define MAX_SPECS          128
+#endif
+
+#define DEFAULT_SPEC_TOLERANCE   35     /* percent */
+
+#define SPEC_ERROR         128
+
+#define SPEC_FIELD_REVERSE  0x01    /* least significant bit first */
+#define SPEC_FIELD_CONST    0x02    /* fixed value, not in json */
+#define SPEC_FIELD_LABELS   0x04    /* value is index of labels */
+
+typedef struct {
+    const char*  name;
+    uint8_t      offset;
+    uint8_t      width;
+    uint8_t      flags;
+    uint32_t     value;         /* SPEC_FIELD_CONST */
+    const char*  labels;        /* SPEC_FIELD_LABELS, '/' separated */
+} spec_field_t;
+
+/* Pulses in multiples of base pulse and their accepted length range */
+typedef struct {
+    uint8_t      count;
+    uint16_t     length[MAX_SPEC_SYMBOL];
+    uint32_t     min[MAX_SPEC_SYMBOL];
+    uint32_t     max[MAX_SPEC_SYMBOL];
+} spec_symbol_t;
+
+typedef struct {
+    const char*    protocol;
+    uint32_t       pulse;
+    uint8_t        tolerance;
+    uint8_t        bits;
+    uint16_t       n_pulses;    /* header, bits and footer */
+    spec_symbol_t  header;
+    spec_symbol_t  zero;
+    spec_symbol_t  one;
+    spec_symbol_t  footer;      /* last pulse is the gap */
+    uint8_t        n_fields;
+    spec_field_t   fields[MAX_SPEC_FIELDS];
+    char*          text;        /* line strings point to, NULL if builtin */
+} spec_t;
+
+/*
+    Bounds of pulses, shared by the generated table and the spec file loader.
+    A gap is accepted from half to twice its length.
+*/
+#define SPEC_MIN(pulse, tolerance, m)   ((uint32_t)(pulse) * (m) * (100 - (tolerance)) / 100)
+#define SPEC_MAX(pulse, tolerance, m)   ((uint32_t)(pulse) * (m) * (100 + (tolerance)) / 100)
+#define SPEC_GAP_MIN(pulse, m)          ((uint32_t)(pulse) * (m) / 2)
+#define SPEC_GAP_MAX(pulse, m)          ((uint32_t)(pulse) * (m) * 2)
+
+#define SPEC_SYMBOL(pulse, tolerance, count, a, b, c, d)                                           \
+    { count, { a, b, c, d },                                                                       \
+      { SPEC_MIN(pulse, tolerance, a), SPEC_MIN(pulse, tolerance, b),                              \
+        SPEC_MIN(pulse, tolerance, c), SPEC_MIN(pulse, tolerance, d) },                            \
+      { SPEC_MAX(pulse, tolerance, a), SPEC_MAX(pulse, tolerance, b),                              \
+        SPEC_MAX(pulse, tolerance, c), SPEC_MAX(pulse, tolerance, d) } }
+
+#define SPEC_FOOTER_MIN(pulse, tolerance, count, i, m) \
+    ((count) == (i) + 1 ? SPEC_GAP_MIN(pulse, m) : SPEC_MIN(pulse, tolerance, m))
+#define SPEC_FOOTER_MAX(pulse, tolerance, count, i, m) \
+    ((count) == (i) + 1 ? SPEC_GAP_MAX(pulse, m) : SPEC_MAX(pulse, tolerance, m))
+
+#define SPEC_FOOTER(pulse, tolerance, count, a, b, c, d)                                           \
+    { count, { a, b, c, d },                                                                       \
+      { SPEC_FOOTER_MIN(pulse, tolerance, count, 0, a), SPEC_FOOTER_MIN(pulse, tolerance, count, 1, b), \
+        SPEC_FOOTER_MIN(pulse, tolerance, count, 2, c), SPEC_FOOTER_MIN(pulse, tolerance, count, 3, d) }, \
+      { SPEC_FOOTER_MAX(pulse, tolerance, count, 0, a), SPEC_FOOTER_MAX(pulse, tolerance, count, 1, b), \
+        SPEC_FOOTER_MAX(pulse, tolerance, count, 2, c), SPEC_FOOTER_MAX(pulse, tolerance, count, 3, d) } }
+
+#define SPEC_FIELD(name, offset, width, flags, value, labels) \
+    { name, offset, width, flags, value, labels }
+
+/*
+    Specs by protocol name, builtin ones first. Loaded specs replace a
+    builtin one of the same protocol.
+*/
+typedef struct {
+    spec_t*  specs;
+    int      count;
+} spec_table_t;
+
+/* Init table with the builtin specs, returns false on fails */
+bool spec_table_init(spec_table_t* table);
+
+/* Add specs of file, returns number of specs loaded or -1 on fails, error set */
+int spec_table_load(spec_table_t* table, const char* file, char* error);
+
+void spec_table_free(spec_table_t* table);
+
+const spec_t* spec_find(const spec_table_t* table, const char* protocol);
+
+/* Match frame against spec, bits set most significant first. Shared kernel of every spec */
+bool spec_match(const spec_t* spec, const uint32_t* pulses, int n_pulses, uint64_t* bits);
+
+/* Decoded json as decodePulseTrain() of the first spec matching frame, NULL if none */
+char* spec_decode(const spec_table_t* table, const uint32_t* pulses, int n_pulses, const char* indent);
+
+/* Encode json data as encodeToPulseTrain(), returns number of pulses or -1, error set */
+int spec_encode(const spec_t* spec, const char* json_data, uint32_t* pulses, uint16_t max_pulses, char* error);
+
+void spec_help(FILE* out);
+
+int spec_cmd(int argc, char** argv);
+
+#endif
@@ -0,0 +1,142 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-stats.h"
+
+typedef size_t rsize_t;
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static const char* phase_names[STATS_PHASES] = { "startup", "parse", "codec", "output" };
+
+static bool             enabled = false;
+static stats_phase_t    current = STATS_STARTUP;
+static struct timespec  wall_start;
+static clock_t          cpu_start;
+static double           wall[STATS_PHASES];
+static double           cpu[STATS_PHASES];
+#ifdef STATS_WRAP_MALLOC
+
+static stats_alloc_t    allocs;
+
+/* Linked with -Wl,--wrap, calls of every object file land here */
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+/* Relaxed atomics, codebook workers allocate in parallel */
+#define STATS_ADD(counter, value)  __atomic_fetch_add(&(counter), (value), __ATOMIC_RELAXED)
+
+void* __wrap_malloc(size_t size){
+    if (enabled){
+        STATS_ADD(allocs.mallocs, 1);
+        STATS_ADD(allocs.bytes, size);
+    }
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    if (enabled){
+        STATS_ADD(allocs.callocs, 1);
+        STATS_ADD(allocs.bytes, count * size);
+    }
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size){
+    if (enabled){
+        STATS_ADD(allocs.reallocs, 1);
+        STATS_ADD(allocs.bytes, size);
+    }
+    return __real_realloc(ptr, size);
+}
+
+void __wrap_free(void* ptr){
+    if (enabled && ptr != NULL){
+        STATS_ADD(allocs.frees, 1);
+    }
+    __real_free(ptr);
+}
+
+#endif
+
+void stats_start(void){
+    enabled = true;
+    current = STATS_STARTUP;
+    timespec_get(&wall_start, TIME_UTC);
+    cpu_start = clock();
+}
+
+bool stats_enabled(void){
+    return enabled;
+}
+
+void stats_phase(stats_phase_t phase){
+
+    struct timespec now;
+    clock_t         cpu_now;
+
+    if (!enabled){
+        return;
+    }
+
+    timespec_get(&now, TIME_UTC);
+    cpu_now = clock();
+
+    wall[current] += (double)(now.tv_sec - wall_start.tv_sec) + (double)(now.tv_nsec - wall_start.tv_nsec) / 1e9;
+    cpu[current]  += (double)(cpu_now - cpu_start) / CLOCKS_PER_SEC;
+
+    wall_start = now;
+    cpu_start  = cpu_now;
+    current    = phase;
+}
+
+void stats_report(FILE* out){
+
+    double total_wall = 0;
+    double total_cpu  = 0;
+
+    if (!enabled){
+        return;
+    }
+
+    /* Close current phase */
+    stats_phase(current);
+
+    fprintf(out,"stats: phase        wall ms     cpu ms\n");
+    for (int i = 0; i < STATS_PHASES; i++){
+        fprintf(out,"stats: %-8s  %9.3f  %9.3f\n", phase_names[i], wall[i] * 1e3, cpu[i] * 1e3);
+        total_wall += wall[i];
+        total_cpu  += cpu[i];
+    }
+    fprintf(out,"stats: %-8s  %9.3f  %9.3f\n", "total", total_wall * 1e3, total_cpu * 1e3);
+
+#ifdef STATS_WRAP_MALLOC
+    fprintf(out,"stats: allocs %llu (malloc %llu, calloc %llu, realloc %llu), frees %llu, bytes %llu\n",
+            allocs.mallocs + allocs.callocs + allocs.reallocs, allocs.mallocs, allocs.callocs, allocs.reallocs,
+            allocs.frees, allocs.bytes);
+#else
+    fprintf(out,"stats: allocs not available, built without malloc wrappers\n");
+#endif
+
+#ifndef _WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0){
+#ifdef __APPLE__
+        fprintf(out,"stats: peak rss %ld kB\n", (long)(usage.ru_maxrss / 1024));   /* bytes on macOS */
+#else
+        fprintf(out,"stats: peak rss %ld kB\n", (long)usage.ru_maxrss);
+#endif
+    }
+#endif
+}
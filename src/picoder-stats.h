@@ -0,0 +1,47 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_STATS_H
+#define PICODER_STATS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* Command phases, time is accounted to current phase until next one starts */
+typedef enum {
+    STATS_STARTUP = 0,      /* until command dispatch, protocols registration */
+    STATS_PARSE,            /* command arguments */
+    STATS_CODEC,            /* PiCode encode, decode and convert calls */
+    STATS_OUTPUT,           /* format and write results */
+    STATS_PHASES
+} stats_phase_t;
+
+/*
+    Allocation counters, updated by the malloc family wrappers when built with
+    STATS_WRAP_MALLOC (GNU linker --wrap). Bytes are requested sizes.
+*/
+typedef struct {
+    unsigned long long  mallocs;
+    unsigned long long  callocs;
+    unsigned long long  reallocs;
+    unsigned long long  frees;
+    unsigned long long  bytes;
+} stats_alloc_t;
+
+/* Enable stats and start startup phase */
+void stats_start(void);
+
+bool stats_enabled(void);
+
+/* End current phase and start 'phase', no-op if not enabled */
+void stats_phase(stats_phase_t phase);
+
+/* Show phase times, allocations and peak RSS */
+void stats_report(FILE* out);
+
+#endif
@@ -0,0 +1,203 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-suggest.h"
+#include "picoder-sample.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifndef FINGERPRINT_MAX_PULSES
+#define FINGERPRINT_MAX_PULSES   512
+#endif
+
+#define CLUSTER_TOLERANCE     0.25    /* sorted pulse joins cluster if within 25% of its center */
+#define CLUSTER_MIN_SHARE     0.05    /* smaller clusters are glitches */
+
+/* Distance weights, every feature is compared as log ratio */
+#define WEIGHT_PULSES         4.0
+#define WEIGHT_FOOTER         1.0
+#define WEIGHT_BASE           2.0
+#define WEIGHT_RATIO          2.0
+#define WEIGHT_SHARE          1.0
+#define WEIGHT_CLUSTERS       0.5
+
+static int compare_pulses(const void* a, const void* b){
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+bool fingerprint_compute(const uint32_t* pulses, int n_pulses, fingerprint_t* fp){
+
+    uint32_t sorted[FINGERPRINT_MAX_PULSES];
+    double   centers[FINGERPRINT_RATIOS + 1];
+    int      counts[FINGERPRINT_RATIOS + 1];
+    int      n = n_pulses - 1;  /* footer out of clusters */
+
+    memset(fp, 0, sizeof(*fp));
+
+    if (n < 2){
+        return false;
+    }
+    if (n > FINGERPRINT_MAX_PULSES){
+        n = FINGERPRINT_MAX_PULSES;
+    }
+
+    fp->pulses = n_pulses;
+    fp->footer = pulses[n_pulses - 1];
+
+    memcpy(sorted, pulses, sizeof(*sorted) * (size_t)n);
+    qsort(sorted, (size_t)n, sizeof(*sorted), compare_pulses);
+
+    /* Group sorted pulses, keep the shortest clusters over min share */
+    double sum   = 0;
+    int    count = 0;
+    int    min   = (int)ceil(n * CLUSTER_MIN_SHARE);
+
+    for (int i = 0; i <= n; i++){
+        if (i < n && (count == 0 || sorted[i] <= (sum / count) * (1.0 + CLUSTER_TOLERANCE))){
+            sum += sorted[i];
+            count++;
+        }else{
+            if (count >= min && fp->clusters <= FINGERPRINT_RATIOS){
+                centers[fp->clusters] = sum / count;
+                counts[fp->clusters]  = count;
+                fp->clusters++;
+            }
+            if (i < n){
+                sum   = sorted[i];
+                count = 1;
+            }
+        }
+    }
+
+    if (fp->clusters == 0){
+        return false;
+    }
+
+    fp->base  = centers[0];
+    fp->share = (double)counts[0] / n;
+    for (int i = 1; i < fp->clusters; i++){
+        fp->ratios[i - 1] = centers[i] / centers[0];
+    }
+
+    return true;
+}
+
+static double log_distance(double a, double b){
+    if (a <= 0 || b <= 0){
+        return (a == b) ? 0 : 1.0;
+    }
+    return fabs(log(a / b));
+}
+
+static double fingerprint_distance(const fingerprint_t* a, const fingerprint_t* b){
+    double d = WEIGHT_PULSES   * log_distance(a->pulses, b->pulses)
+             + WEIGHT_FOOTER   * log_distance(a->footer, b->footer)
+             + WEIGHT_BASE     * log_distance(a->base, b->base)
+             + WEIGHT_SHARE    * fabs(a->share - b->share)
+             + WEIGHT_CLUSTERS * abs(a->clusters - b->clusters);
+    for (int i = 0; i < FINGERPRINT_RATIOS; i++){
+        d += WEIGHT_RATIO * log_distance(a->ratios[i], b->ratios[i]);
+    }
+    return d;
+}
+
+static void index_add(void* ctx, protocol_t* protocol, const char* json, const uint32_t* pulses, int n_pulses){
+
+    fingerprint_index_t* index = (fingerprint_index_t*)ctx;
+
+    if (index->count == index->size){
+        size_t size = index->size ? index->size * 2 : 256;
+        fingerprint_entry_t* entries = (fingerprint_entry_t*)realloc(index->entries, sizeof(*entries) * size);
+        if (entries == NULL){
+            return;
+        }
+        index->entries = entries;
+        index->size    = size;
+    }
+
+    fingerprint_entry_t* entry = &index->entries[index->count];
+    if (fingerprint_compute(pulses, n_pulses, &entry->fingerprint)){
+        entry->protocol = protocol;
+        index->count++;
+    }
+}
+
+fingerprint_index_t* fingerprint_index_build(void){
+
+    uint16_t             max_pulses = protocol_maxrawlen();
+    uint32_t*            pulses     = (uint32_t*)malloc(sizeof(*pulses) * (max_pulses + 1));
+    fingerprint_index_t* index      = (fingerprint_index_t*)calloc(1, sizeof(*index));
+
+    if (pulses == NULL || index == NULL){
+        free(pulses);
+        free(index);
+        return NULL;
+    }
+
+    for (protocols_t* pnode = usedProtocols(); pnode != NULL; pnode = pnode->next){
+        sample_codes(pnode->listener, pulses, max_pulses, index_add, index);
+    }
+
+    free(pulses);
+
+    return index;
+}
+
+void fingerprint_index_free(fingerprint_index_t* index){
+    if (index != NULL){
+        free(index->entries);
+        free(index);
+    }
+}
+
+int fingerprint_index_nearest(const fingerprint_index_t* index, const fingerprint_t* fp, suggestion_t* suggestions, int k){
+
+    int found = 0;
+
+    if (k > MAX_SUGGESTIONS){
+        k = MAX_SUGGESTIONS;
+    }
+
+    for (size_t i = 0; i < index->count; i++){
+
+        const fingerprint_entry_t* entry = &index->entries[i];
+        double distance = fingerprint_distance(fp, &entry->fingerprint);
+
+        /* Keep best distance per protocol */
+        int pos = 0;
+        while (pos < found && suggestions[pos].protocol != entry->protocol){
+            pos++;
+        }
+        if (pos < found){
+            if (distance >= suggestions[pos].distance){
+                continue;
+            }
+        }else if (found < k){
+            found++;
+        }else if (distance < suggestions[found - 1].distance){
+            pos = found - 1;
+        }else{
+            continue;
+        }
+
+        /* Insertion in ascending distance order */
+        while (pos > 0 && suggestions[pos - 1].distance > distance){
+            suggestions[pos] = suggestions[pos - 1];
+            pos--;
+        }
+        suggestions[pos].protocol = entry->protocol;
+        suggestions[pos].distance = distance;
+    }
+
+    return found;
+}
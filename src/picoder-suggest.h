@@ -0,0 +1,61 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_SUGGEST_H
+#define PICODER_SUGGEST_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#ifndef FINGERPRINT_RATIOS
+#define FINGERPRINT_RATIOS     2
+#endif
+
+#ifndef MAX_SUGGESTIONS
+#define MAX_SUGGESTIONS       10
+#endif
+
+/* Timing fingerprint of a pulse train */
+typedef struct {
+    double  pulses;                         /* number of pulses, footer included */
+    double  footer;                         /* footer gap */
+    double  base;                           /* shortest timing cluster center */
+    double  ratios[FINGERPRINT_RATIOS];     /* next cluster centers relative to base, 0 if none */
+    double  share;                          /* share of pulses in shortest cluster */
+    int     clusters;                       /* number of timing clusters */
+} fingerprint_t;
+
+typedef struct {
+    protocol_t*     protocol;
+    fingerprint_t   fingerprint;
+} fingerprint_entry_t;
+
+/* Fingerprints of generated trains of every encodable protocol */
+typedef struct {
+    size_t                count;
+    size_t                size;
+    fingerprint_entry_t*  entries;
+} fingerprint_index_t;
+
+typedef struct {
+    protocol_t*  protocol;
+    double       distance;
+} suggestion_t;
+
+/* Compute fingerprint of a pulse train, returns false if too short */
+bool fingerprint_compute(const uint32_t* pulses, int n_pulses, fingerprint_t* fp);
+
+/* Build index encoding sample codes of every encodable protocol, NULL on fails */
+fingerprint_index_t* fingerprint_index_build(void);
+
+void fingerprint_index_free(fingerprint_index_t* index);
+
+/* Find up to k nearest protocols, one entry per protocol, returns number found */
+int fingerprint_index_nearest(const fingerprint_index_t* index, const fingerprint_t* fp, suggestion_t* suggestions, int k);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-table.h"
+#include "picoder-codebook.h"
+#include "picoder-frame.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+
+#define CODEBOOK_HEADER    28   /* magic, version, counts, flags, codes, index offset */
+
+static uint16_t read_u16(const uint8_t* p){
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint64_t read_u64(const uint8_t* p){
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--){
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+/* FNV-1a of the 'c:' part, up to ';' */
+static uint64_t code_hash(const char* code){
+    uint64_t hash = 14695981039346656037ULL;
+    while (*code != '\0' && *code != ';'){
+        hash ^= (uint8_t)*code++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/* Skip string at offset, returns next offset or 0 if out of data */
+static size_t skip_string(const uint8_t* data, size_t size, size_t offset){
+    if (offset + 2 > size || offset + 2 + read_u16(data + offset) > size){
+        return 0;
+    }
+    return offset + 2 + read_u16(data + offset);
+}
+
+static char* read_file(const char* file, size_t* size){
+
+    FILE* in   = fopen(file, "rb");
+    char* data = NULL;
+    long  len;
+
+    if (in == NULL){
+        return NULL;
+    }
+    if (fseek(in, 0, SEEK_END) == 0 && (len = ftell(in)) > 0 && fseek(in, 0, SEEK_SET) == 0){
+        data = (char*)malloc((size_t)len);
+        if (data != NULL && fread(data, 1, (size_t)len, in) != (size_t)len){
+            free(data);
+            data = NULL;
+        }
+        *size = (size_t)len;
+    }
+    fclose(in);
+
+    return data;
+}
+
+long decode_table_load(decode_table_t* table, const char* file){
+
+    size_t   size   = 0;
+    uint8_t* data   = (uint8_t*)read_file(file, &size);
+    char*    arena  = NULL;
+    size_t   used   = 0;
+    long     loaded = 0;
+
+    if (data == NULL){
+        fprintf(stderr,"error: unable to read '%s'\n",file);
+        return -1;
+    }
+
+    if (size < CODEBOOK_HEADER || memcmp(data, CODEBOOK_MAGIC, 4) != 0 || read_u16(data + 4) != CODEBOOK_VERSION){
+        fprintf(stderr,"error: '%s' is not a codebook file\n",file);
+        free(data);
+        return -1;
+    }
+    if ((read_u16(data + 10) & CODEBOOK_FLAG_DECODED) == 0){
+        fprintf(stderr,"error: codebook '%s' has no decoded json, build it with -d\n",file);
+        free(data);
+        return -1;
+    }
+    if (table->n_arenas == MAX_DECODE_TABLES){
+        fprintf(stderr,"error: max %d tables are allowed\n",MAX_DECODE_TABLES);
+        free(data);
+        return -1;
+    }
+
+    uint64_t count = read_u64(data + 12);
+    uint64_t index = read_u64(data + 20);
+
+    if (index > size || count > (size - index) / 8){
+        fprintf(stderr,"error: codebook '%s' truncated\n",file);
+        free(data);
+        return -1;
+    }
+
+    /* Strings are copied with '\0', arena never exceeds file size */
+    arena = (char*)malloc(size);
+    if (arena == NULL || table->count + count > UINT32_MAX - 1){
+        fprintf(stderr,"error: malloc fail!\n");
+        free(arena);
+        free(data);
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < count; i++){
+
+        size_t offset = (size_t)read_u64(data + index + i * 8);
+        size_t next   = offset ? skip_string(data, index, offset) : 0;
+        size_t end    = next ? skip_string(data, index, next) : 0;
+
+        if (offset == 0){
+            continue;
+        }
+        if (end == 0){
+            fprintf(stderr,"error: codebook '%s' record %llu invalid\n",file,(unsigned long long)i);
+            loaded = -1;
+            break;
+        }
+        /* Codes not decoded back can not be served */
+        if (read_u16(data + next) == 0){
+            continue;
+        }
+
+        if (table->count == table->size){
+            size_t         new_size = table->size ? table->size * 2 : 4096;
+            table_entry_t* entries  = (table_entry_t*)realloc(table->entries, sizeof(*entries) * new_size);
+            if (entries == NULL){
+                fprintf(stderr,"error: malloc fail!\n");
+                loaded = -1;
+                break;
+            }
+            table->entries = entries;
+            table->size    = new_size;
+        }
+
+        table_entry_t* entry = &table->entries[table->count++];
+        size_t         len   = read_u16(data + offset);
+
+        entry->code = arena + used;
+        memcpy(arena + used, data + offset + 2, len);
+        used += len;
+        arena[used++] = '\0';
+
+        len = read_u16(data + next);
+        entry->json = arena + used;
+        memcpy(arena + used, data + next + 2, len);
+        used += len;
+        arena[used++] = '\0';
+
+        entry->hash = code_hash(entry->code);
+        loaded++;
+    }
+
+    free(data);
+
+    if (loaded < 0){
+        free(arena);
+        return -1;
+    }
+    table->arenas[table->n_arenas++] = arena;
+
+    return loaded;
+}
+
+bool decode_table_index(decode_table_t* table){
+
+    size_t n_slots = 16;
+
+    /* Load factor under 0.5 */
+    while (n_slots < table->count * 2){
+        n_slots *= 2;
+    }
+
+    free(table->slots);
+    table->slots = (uint32_t*)calloc(n_slots, sizeof(*table->slots));
+    if (table->slots == NULL){
+        return false;
+    }
+    table->mask = n_slots - 1;
+
+    for (size_t i = 0; i < table->count; i++){
+        size_t slot = (size_t)table->entries[i].hash & table->mask;
+        bool   dup  = false;
+        while (table->slots[slot] != 0 && !dup){
+            const table_entry_t* other = &table->entries[table->slots[slot] - 1];
+            dup  = other->hash == table->entries[i].hash && strcmp(other->code, table->entries[i].code) == 0;
+            slot = (slot + 1) & table->mask;
+        }
+        /* Same code of other combination, first decoded json is kept */
+        if (!dup){
+            table->slots[slot] = (uint32_t)(i + 1);
+        }
+    }
+
+    return true;
+}
+
+const char* decode_table_lookup(decode_table_t* table, const char* code){
+
+    uint64_t hash = code_hash(code);
+    size_t   slot = (size_t)hash & table->mask;
+
+    while (table->slots != NULL && table->slots[slot] != 0){
+        const table_entry_t* entry = &table->entries[table->slots[slot] - 1];
+        if (entry->hash == hash && frame_same_code(entry->code, code, TABLE_TOLERANCE)){
+            table->hits++;
+            return entry->json;
+        }
+        slot = (slot + 1) & table->mask;
+    }
+    table->misses++;
+
+    return NULL;
+}
+
+void decode_table_free(decode_table_t* table){
+    for (int i = 0; i < table->n_arenas; i++){
+        free(table->arenas[i]);
+    }
+    free(table->entries);
+    free(table->slots);
+    memset(table, 0, sizeof(*table));
+}
@@ -0,0 +1,55 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_TABLE_H
+#define PICODER_TABLE_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#ifndef MAX_DECODE_TABLES
+#define MAX_DECODE_TABLES     8
+#endif
+
+#define TABLE_TOLERANCE     0.15    /* received timings within 15% of table code */
+
+typedef struct {
+    uint64_t     hash;      /* hash of 'c:' part */
+    const char*  code;      /* pilight string */
+    const char*  json;      /* decoded json */
+} table_entry_t;
+
+/*
+    Reverse lookup table of codebooks built with decoded json. Entries are
+    hashed by the 'c:' part in an open addressing table, linear probing,
+    codes sharing 'c:' part are told apart by their 'p:' timings.
+*/
+typedef struct {
+    size_t          count;
+    size_t          size;
+    table_entry_t*  entries;
+    size_t          mask;       /* slots - 1, power of two */
+    uint32_t*       slots;      /* entry index + 1, 0 if empty */
+    int             n_arenas;
+    char*           arenas[MAX_DECODE_TABLES];
+    uint64_t        hits;
+    uint64_t        misses;
+} decode_table_t;
+
+/* Load codebook file records to table, returns loaded codes or -1 on fails */
+long decode_table_load(decode_table_t* table, const char* file);
+
+/* Build hash slots of loaded codes, returns false on fails */
+bool decode_table_index(decode_table_t* table);
+
+/* Decoded json of pilight string, NULL if not in table */
+const char* decode_table_lookup(decode_table_t* table, const char* code);
+
+void decode_table_free(decode_table_t* table);
+
+#endif
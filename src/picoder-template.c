@@ -0,0 +1,498 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-template.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define TEMPLATE_KEY     1024
+
+/* Numeric members of vary names in a json, as they appear */
+typedef struct {
+    int        count;
+    JsonNode*  nodes[MAX_TEMPLATE_VARY];
+    uint32_t   values[MAX_TEMPLATE_VARY];
+} template_vary_t;
+
+/* FNV-1a of template key */
+static uint64_t template_hash(const char* key){
+    uint64_t hash = 14695981039346656037ULL;
+    while (*key != '\0'){
+        hash ^= (uint8_t)*key++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool is_vary(const template_cache_t* cache, const char* name){
+    for (int i = 0; i < cache->n_vary; i++){
+        if (strcmp(cache->vary[i], name) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+    Key of protocol and json members, value of each fixed member and only
+    name of varying numeric ones, collected to vary. Returns false if key
+    does not fit.
+*/
+static bool template_key(const template_cache_t* cache, const char* protocol, JsonNode* data, char* key, template_vary_t* vary){
+
+    JsonNode* member;
+    size_t    len = (size_t)snprintf(key, TEMPLATE_KEY, "%s:", protocol);
+
+    vary->count = 0;
+
+    json_foreach(member, data){
+
+        int n = 0;
+
+        if (member->key == NULL || len >= TEMPLATE_KEY){
+            return false;
+        }
+        if (member->tag == JSON_NUMBER && vary->count < MAX_TEMPLATE_VARY && is_vary(cache, member->key)
+            && member->number_ >= 0 && member->number_ <= 4294967295.0 && member->number_ == floor(member->number_)){
+            vary->nodes[vary->count]    = member;
+            vary->values[vary->count++] = (uint32_t)member->number_;
+            n = snprintf(key + len, TEMPLATE_KEY - len, "%s#,", member->key);
+        }else if (member->tag == JSON_NUMBER){
+            n = snprintf(key + len, TEMPLATE_KEY - len, "%s=%.17g,", member->key, member->number_);
+        }else if (member->tag == JSON_STRING){
+            n = snprintf(key + len, TEMPLATE_KEY - len, "%s=\"%s\",", member->key, member->string_);
+        }else{
+            char* value = json_encode(member);
+            if (value == NULL){
+                return false;
+            }
+            n = snprintf(key + len, TEMPLATE_KEY - len, "%s=%s,", member->key, value);
+            free(value);
+        }
+        len += (size_t)n;
+    }
+
+    return len < TEMPLATE_KEY;
+}
+
+/* Encode json data by PiCode encoder, returns number of pulses or -1 */
+static int template_full(const template_cache_t* cache, protocol_t* protocol, JsonNode* data, uint32_t* pulses){
+
+    char* json_data = json_encode(data);
+    int   n_pulses  = -1;
+
+    if (json_data != NULL){
+        n_pulses = encodeToPulseTrain(pulses, cache->max_pulses, protocol, json_data);
+        free(json_data);
+    }
+
+    return n_pulses < 0 ? -1 : n_pulses;
+}
+
+/* Pilight string of pulses with cache repeats */
+static char* template_code(const template_cache_t* cache, const uint32_t* pulses, int n_pulses){
+    return pulseTrainToString(pulses, (uint16_t)n_pulses, cache->repeats);
+}
+
+static template_t* template_find(const template_cache_t* cache, const char* key, uint64_t hash){
+
+    template_t* t = cache->slots[hash & (TEMPLATE_SLOTS - 1)];
+
+    while (t != NULL && (t->hash != hash || strcmp(t->key, key) != 0)){
+        t = t->next;
+    }
+
+    return t;
+}
+
+static void template_free(template_t* t){
+
+    for (int m = 0; m < t->n_members; m++){
+        for (int k = 0; k < TEMPLATE_BITS; k++){
+            template_bit_t* bit = &t->members[m].bits[k];
+            free(bit->positions);
+            free(bit->values);
+            free(bit->offsets);
+            free(bit->chars);
+        }
+    }
+    if (t->json != NULL){
+        json_delete(t->json);
+    }
+    free(t->key);
+    free(t->pulses);
+    free(t->owner);
+    free(t->code);
+    free(t);
+}
+
+/*
+    New template of json taking its ownership, base pulses encoded. Returns
+    NULL if json is not encodable, json kept by caller.
+*/
+static template_t* template_new(template_cache_t* cache, const char* key, uint64_t hash, protocol_t* protocol, JsonNode* json, JsonNode* data, const template_vary_t* vary){
+
+    template_t* t        = (template_t*)calloc(1, sizeof(*t));
+    int         n_pulses = -1;
+
+    if (t == NULL){
+        return NULL;
+    }
+    t->key    = strdup(key);
+    t->pulses = (uint32_t*)malloc(sizeof(*t->pulses) * ((size_t)cache->max_pulses + 1));
+    if (t->key != NULL && t->pulses != NULL){
+        n_pulses = template_full(cache, protocol, data, t->pulses);
+    }
+    if (n_pulses >= 0){
+        t->owner = (uint16_t*)calloc((size_t)n_pulses + 1, sizeof(*t->owner));
+        t->code  = template_code(cache, t->pulses, n_pulses);
+    }
+    if (n_pulses < 0 || t->owner == NULL || t->code == NULL){
+        template_free(t);
+        return NULL;
+    }
+
+    t->hash      = hash;
+    t->protocol  = protocol;
+    t->json      = json;
+    t->data      = data;
+    t->n_pulses  = n_pulses;
+    t->code_len  = strlen(t->code);
+    t->code_ok   = true;
+    t->n_members = vary->count;
+    for (int m = 0; m < vary->count; m++){
+        t->members[m].node = vary->nodes[m];
+        t->members[m].base = vary->values[m];
+    }
+
+    t->next = cache->slots[hash & (TEMPLATE_SLOTS - 1)];
+    cache->slots[hash & (TEMPLATE_SLOTS - 1)] = t;
+    cache->n_templates++;
+    cache->closed = cache->n_templates >= MAX_TEMPLATES;
+
+    return t;
+}
+
+/*
+    Learn pulses and string chars bit k of member m changes, by encoding base
+    json with the bit flipped. Pulses changed by more than one bit, or a
+    different number of pulses, break the template.
+*/
+static void template_learn(template_cache_t* cache, template_t* t, int m, int k){
+
+    template_member_t* member  = &t->members[m];
+    template_bit_t*    bit     = &member->bits[k];
+    uint16_t           id      = (uint16_t)(m * TEMPLATE_BITS + k + 1);
+    uint32_t*          flipped = cache->scratch;
+    int                n_pulses;
+    int                count   = 0;
+
+    member->node->number_ = (double)(member->base ^ (1UL << k));
+    n_pulses = template_full(cache, t->protocol, t->data, flipped);
+    member->node->number_ = (double)member->base;
+    cache->learned++;
+
+    if (n_pulses < 0){
+        bit->state = TEMPLATE_BIT_FAILED;
+        return;
+    }
+    if (n_pulses != t->n_pulses){
+        t->broken = true;
+        return;
+    }
+
+    for (int i = 0; i < n_pulses; i++){
+        if (flipped[i] != t->pulses[i]){
+            if (t->owner[i] != 0){
+                t->broken = true;
+                return;
+            }
+            count++;
+        }
+    }
+    bit->positions = (uint16_t*)malloc(sizeof(*bit->positions) * (size_t)(count + 1));
+    bit->values    = (uint32_t*)malloc(sizeof(*bit->values) * (size_t)(count + 1));
+    if (bit->positions == NULL || bit->values == NULL){
+        bit->state = TEMPLATE_BIT_FAILED;
+        return;
+    }
+    for (int i = 0; i < n_pulses; i++){
+        if (flipped[i] != t->pulses[i]){
+            t->owner[i]                = id;
+            bit->positions[bit->count] = (uint16_t)i;
+            bit->values[bit->count++]  = flipped[i];
+        }
+    }
+
+    /* String chars patched only if 'p:' and every other part stay the same */
+    char* code = template_code(cache, flipped, n_pulses);
+    if (code != NULL && strlen(code) == t->code_len && t->code_len <= UINT16_MAX){
+        const char* end = strchr(t->code, ';');
+        size_t      c_len = (end != NULL) ? (size_t)(end - t->code) : 0;
+        int         n_chars = 0;
+        bool        c_only  = (c_len > 0);
+
+        for (size_t i = 0; i < t->code_len && c_only; i++){
+            if (code[i] != t->code[i]){
+                c_only = (i < c_len);
+                n_chars++;
+            }
+        }
+        if (c_only){
+            bit->offsets = (uint16_t*)malloc(sizeof(*bit->offsets) * (size_t)(n_chars + 1));
+            bit->chars   = (char*)malloc((size_t)(n_chars + 1));
+        }
+        if (bit->offsets != NULL && bit->chars != NULL){
+            for (size_t i = 0; i < c_len; i++){
+                if (code[i] != t->code[i]){
+                    bit->offsets[bit->n_chars] = (uint16_t)i;
+                    bit->chars[bit->n_chars++] = code[i];
+                }
+            }
+            bit->code_ok = true;
+        }
+    }
+    free(code);
+
+    bit->state = TEMPLATE_BIT_LEARNED;
+}
+
+/*
+    Patch base pulses with bits of vary values changed from base, and the
+    pilight string to cache code if every bit allows it. Returns number of
+    pulses or -1 if a full encode is required.
+*/
+static int template_patch(template_cache_t* cache, template_t* t, const template_vary_t* vary, uint32_t* pulses, bool* code_ok){
+
+    bool patch_code = t->code_ok;
+
+    for (int m = 0; m < t->n_members && !t->broken; m++){
+        uint32_t diff = vary->values[m] ^ t->members[m].base;
+        while (diff != 0){
+            int k = 0;
+            while (((diff >> k) & 1) == 0) k++;
+            if (t->members[m].bits[k].state == TEMPLATE_BIT_UNKNOWN){
+                template_learn(cache, t, m, k);
+            }
+            if (t->members[m].bits[k].state != TEMPLATE_BIT_LEARNED){
+                return -1;
+            }
+            patch_code = patch_code && t->members[m].bits[k].code_ok;
+            diff &= diff - 1;
+        }
+    }
+    if (t->broken){
+        return -1;
+    }
+
+    if (patch_code && cache->code_size < t->code_len + 1){
+        char* code = (char*)realloc(cache->code, t->code_len + 1);
+        if (code == NULL){
+            patch_code = false;
+        }else{
+            cache->code      = code;
+            cache->code_size = t->code_len + 1;
+        }
+    }
+
+    memcpy(pulses, t->pulses, sizeof(*pulses) * (size_t)t->n_pulses);
+    if (patch_code){
+        memcpy(cache->code, t->code, t->code_len + 1);
+    }
+
+    for (int m = 0; m < t->n_members; m++){
+        uint32_t diff = vary->values[m] ^ t->members[m].base;
+        while (diff != 0){
+            int k = 0;
+            while (((diff >> k) & 1) == 0) k++;
+            const template_bit_t* bit = &t->members[m].bits[k];
+            for (int i = 0; i < bit->count; i++){
+                pulses[bit->positions[i]] = bit->values[i];
+            }
+            if (patch_code){
+                for (int i = 0; i < bit->n_chars; i++){
+                    cache->code[bit->offsets[i]] = bit->chars[i];
+                }
+            }
+            diff &= diff - 1;
+        }
+    }
+    *code_ok = patch_code;
+
+    return t->n_pulses;
+}
+
+/* Check first patches of template against a full encode, the full one is kept on mismatch */
+static int template_verify(template_cache_t* cache, template_t* t, JsonNode* data, uint32_t* pulses, int n_pulses, bool* code_ok){
+
+    int n_full = template_full(cache, t->protocol, data, cache->scratch);
+
+    t->verified++;
+    if (n_full != n_pulses || memcmp(pulses, cache->scratch, sizeof(*pulses) * (size_t)n_pulses) != 0){
+        t->broken = true;
+        *code_ok  = false;
+        if (n_full > 0){
+            memcpy(pulses, cache->scratch, sizeof(*pulses) * (size_t)n_full);
+        }
+        return n_full;
+    }
+    if (*code_ok){
+        char* code = template_code(cache, pulses, n_pulses);
+        if (code == NULL || strcmp(code, cache->code) != 0){
+            t->code_ok = false;
+            *code_ok   = false;
+        }
+        free(code);
+    }
+
+    return n_pulses;
+}
+
+bool template_cache_init(template_cache_t* cache, const char* vary, validator_t* validator, const spec_table_t* specs, uint16_t max_pulses, uint8_t repeats){
+
+    char* names = strdup(vary);
+    char* name  = NULL;
+
+    memset(cache, 0, sizeof(*cache));
+    cache->validator  = validator;
+    cache->specs      = specs;
+    cache->max_pulses = max_pulses;
+    cache->repeats    = repeats;
+    cache->scratch    = (uint32_t*)malloc(sizeof(*cache->scratch) * ((size_t)max_pulses + 1));
+
+    if (names == NULL || cache->scratch == NULL){
+        free(names);
+        return false;
+    }
+    name = strtok(names, ",");
+    while (name != NULL){
+        if (cache->n_vary == MAX_TEMPLATE_VARY || (cache->vary[cache->n_vary] = strdup(name)) == NULL){
+            free(names);
+            return false;
+        }
+        cache->n_vary++;
+        name = strtok(NULL, ",");
+    }
+    free(names);
+
+    return cache->n_vary > 0;
+}
+
+int template_encode(template_cache_t* cache, const char* full_json, uint32_t* pulses, const char** code, char* error){
+
+    JsonNode*       root_json  = json_decode(full_json);
+    JsonNode*       child_json = (root_json != NULL) ? json_first_child(root_json) : NULL;
+    bool            has_key    = (child_json != NULL && child_json->key != NULL);
+    protocol_t*     protocol   = has_key ? findProtocol(child_json->key) : NULL;
+    const spec_t*   spec       = (has_key && cache->specs != NULL) ? spec_find(cache->specs, child_json->key) : NULL;
+    template_t*     t          = NULL;
+    template_vary_t vary;
+    char            key[TEMPLATE_KEY];
+    uint64_t        hash       = 0;
+    bool            keyed      = false;
+    bool            code_ok    = false;
+    int             n_pulses   = -1;
+
+    *code = NULL;
+
+    if (has_key && spec == NULL && protocol != NULL && protocol->createCode != NULL){
+        keyed = template_key(cache, child_json->key, child_json, key, &vary);
+        hash  = keyed ? template_hash(key) : 0;
+        t     = keyed ? template_find(cache, key, hash) : NULL;
+        if (keyed && !cache->closed){
+            cache->misses += (t == NULL) ? 1 : 0;
+            if (++cache->lookups == TEMPLATE_WINDOW){
+                cache->closed  = cache->misses > TEMPLATE_WINDOW / 2;
+                cache->lookups = 0;
+                cache->misses  = 0;
+            }
+        }
+    }
+
+    if (!has_key){
+        snprintf(error, VALIDATE_ERROR, "full json invalid");
+    }else if (protocol == NULL && spec == NULL){
+        snprintf(error, VALIDATE_ERROR, "protocol '%s' invalid", child_json->key);
+    }else if (spec == NULL && protocol->createCode == NULL){
+        snprintf(error, VALIDATE_ERROR, "protocol '%s' no encode support", child_json->key);
+    }else if (t != NULL){
+
+        /* Fixed members were validated with the template */
+        bool valid = true;
+        for (int m = 0; m < vary.count && valid; m++){
+            valid = validate_member(cache->validator, protocol, vary.nodes[m], error);
+        }
+        if (valid){
+            n_pulses = t->broken ? -1 : template_patch(cache, t, &vary, pulses, &code_ok);
+            if (n_pulses >= 0 && t->verified < TEMPLATE_VERIFY){
+                n_pulses = template_verify(cache, t, child_json, pulses, n_pulses, &code_ok);
+            }
+            if (n_pulses >= 0){
+                cache->patched++;
+            }else{
+                n_pulses = template_full(cache, protocol, child_json, pulses);
+                cache->encoded++;
+            }
+            if (n_pulses < 0){
+                snprintf(error, VALIDATE_ERROR, "unable to encode (%d)", n_pulses);
+            }
+        }
+
+    }else if (protocol == NULL || validate_json(cache->validator, protocol, child_json, error)){
+
+        if (spec != NULL){
+            char* json_data = json_encode(child_json);
+            n_pulses = (json_data != NULL) ? spec_encode(spec, json_data, pulses, cache->max_pulses, error) : -1;
+            if (json_data) free(json_data);
+        }else if (keyed && !cache->closed && (t = template_new(cache, key, hash, protocol, root_json, child_json, &vary)) != NULL){
+            root_json = NULL;
+            n_pulses  = t->n_pulses;
+            memcpy(pulses, t->pulses, sizeof(*pulses) * (size_t)n_pulses);
+            *code = t->code;
+        }else{
+            n_pulses = template_full(cache, protocol, child_json, pulses);
+        }
+        if (spec == NULL){
+            cache->encoded++;
+            if (n_pulses < 0){
+                snprintf(error, VALIDATE_ERROR, "unable to encode (%d)", n_pulses);
+            }
+        }
+    }
+
+    if (code_ok){
+        *code = cache->code;
+    }
+    if (root_json != NULL){
+        json_delete(root_json);
+    }
+
+    return n_pulses;
+}
+
+void template_cache_free(template_cache_t* cache){
+
+    for (int s = 0; s < TEMPLATE_SLOTS; s++){
+        template_t* t = cache->slots[s];
+        while (t != NULL){
+            template_t* next = t->next;
+            template_free(t);
+            t = next;
+        }
+        cache->slots[s] = NULL;
+    }
+    for (int i = 0; i < cache->n_vary; i++){
+        free(cache->vary[i]);
+    }
+    free(cache->scratch);
+    free(cache->code);
+    memset(cache, 0, sizeof(*cache));
+}
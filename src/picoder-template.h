@@ -0,0 +1,121 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_TEMPLATE_H
+#define PICODER_TEMPLATE_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#include "picoder-validate.h"
+#include "picoder-spec.h"
+
+#ifndef MAX_TEMPLATE_VARY
+#define MAX_TEMPLATE_VARY       8
+#endif
+
+#define TEMPLATE_BITS          32       /* bits of a patched numeric member */
+#define TEMPLATE_VERIFY        16       /* patched encodes checked against a full encode */
+#define TEMPLATE_SLOTS        256       /* hash chains, power of two */
+#define TEMPLATE_WINDOW      1024       /* lookups between hit rate checks */
+
+#ifndef MAX_TEMPLATES
+#define MAX_TEMPLATES        4096
+#endif
+
+#define TEMPLATE_BIT_UNKNOWN    0
+#define TEMPLATE_BIT_LEARNED    1
+#define TEMPLATE_BIT_FAILED     2       /* not encodable, full encode when it changes */
+
+/*
+    Pulses and pilight string chars changed by one bit of a numeric member,
+    their values with the bit flipped from base
+*/
+typedef struct {
+    uint8_t    state;
+    uint16_t   count;
+    uint16_t*  positions;
+    uint32_t*  values;
+    bool       code_ok;     /* only 'c:' chars change */
+    uint16_t   n_chars;
+    uint16_t*  offsets;
+    char*      chars;
+} template_bit_t;
+
+typedef struct {
+    uint32_t        base;       /* member value of base pulses */
+    JsonNode*       node;       /* member of json, flipped to learn bits */
+    template_bit_t  bits[TEMPLATE_BITS];
+} template_member_t;
+
+/*
+    Base pulses of a protocol and its fixed json members, with the pulse
+    positions each bit of every varying numeric member changes. Member
+    names, so state members like on/off, and non numeric values of varying
+    members select a different template.
+*/
+typedef struct template_t {
+    uint64_t            hash;
+    char*               key;
+    protocol_t*         protocol;
+    JsonNode*           json;       /* base json, owned */
+    JsonNode*           data;       /* protocol child of json */
+    int                 n_pulses;
+    uint32_t*           pulses;     /* base pulses */
+    uint16_t*           owner;      /* member bit + 1 patching each position, 0 if none */
+    char*               code;       /* pilight string of base pulses */
+    size_t              code_len;
+    int                 n_members;
+    template_member_t   members[MAX_TEMPLATE_VARY];
+    bool                broken;     /* not patchable, full encode */
+    bool                code_ok;    /* pilight string patched as pulses */
+    int                 verified;
+    struct template_t*  next;
+} template_t;
+
+/*
+    Cache of templates by protocol and fixed members. Json members of vary
+    names change between encodes, every other member is fixed. No new
+    templates are created after MAX_TEMPLATES, or once most lookups of a
+    window miss (fixed members seldom repeat), misses are full encodes.
+*/
+typedef struct {
+    int                  n_vary;
+    char*                vary[MAX_TEMPLATE_VARY];
+    validator_t*         validator;
+    const spec_table_t*  specs;     /* spec protocols are encoded by spec, may be NULL */
+    uint16_t             max_pulses;
+    uint8_t              repeats;
+    uint32_t*            scratch;   /* learn and verify encodes */
+    char*                code;      /* pilight string of last patch */
+    size_t               code_size;
+    template_t*          slots[TEMPLATE_SLOTS];
+    unsigned long        n_templates;
+    bool                 closed;    /* no new templates */
+    unsigned             lookups;   /* of current window */
+    unsigned             misses;
+    unsigned long        patched;
+    unsigned long        encoded;
+    unsigned long        learned;
+} template_cache_t;
+
+/* Init cache of ',' separated vary names, returns false on fails */
+bool template_cache_init(template_cache_t* cache, const char* vary, validator_t* validator, const spec_table_t* specs, uint16_t max_pulses, uint8_t repeats);
+
+/*
+    Encode full json '{"protocol":{json-data}}' as encode_full_json(), by
+    patching pulses of its template when possible. Returns number of pulses
+    or -1 with error message set. Code is set to the pilight string of
+    pulses with cache repeats, or NULL if it has to be built by
+    pulseTrainToString().
+*/
+int template_encode(template_cache_t* cache, const char* full_json, uint32_t* pulses, const char** code, char* error);
+
+void template_cache_free(template_cache_t* cache);
+
+#endif
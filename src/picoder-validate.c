@@ -0,0 +1,137 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#include "picoder-validate.h"
+
+typedef size_t rsize_t;
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* Compile masks of every protocol option */
+static validate_protocol_t* validate_compile(protocol_t* protocol){
+
+    validate_protocol_t* vp = (validate_protocol_t*)calloc(1, sizeof(*vp));
+    int                  option_index = 0;
+    char*                option_id    = NULL;
+
+    if (vp == NULL){
+        return NULL;
+    }
+    vp->protocol = protocol;
+
+    while (options_list(protocol->options, option_index++, &option_id) == 0 && vp->n_options < MAX_VALIDATE_OPTIONS){
+
+        validate_option_t* option = &vp->options[vp->n_options];
+        char*              mask   = NULL;
+
+        options_get_name_by_id(protocol->options, option_id, &option->name);
+        if (option->name == NULL){
+            continue;
+        }
+#ifndef _WIN32
+        options_get_mask(protocol->options, option_id, 0, &mask);
+        if (mask != NULL && *mask != '\0'){
+            /* Masks pilight fails to compile are not checked */
+            option->has_mask = regcomp(&option->mask, mask, REG_EXTENDED | REG_NOSUB) == 0;
+        }
+#else
+        (void)mask;
+#endif
+        vp->n_options++;
+    }
+
+    return vp;
+}
+
+static validate_protocol_t* validate_protocol(validator_t* validator, protocol_t* protocol){
+
+    validate_protocol_t* vp = validator->protocols;
+
+    while (vp != NULL && vp->protocol != protocol){
+        vp = vp->next;
+    }
+    if (vp == NULL){
+        vp = validate_compile(protocol);
+        if (vp != NULL){
+            vp->next             = validator->protocols;
+            validator->protocols = vp;
+        }
+    }
+    return vp;
+}
+
+bool validate_member(validator_t* validator, protocol_t* protocol, const JsonNode* member, char* error){
+
+    validate_protocol_t* vp = validate_protocol(validator, protocol);
+    char                 number[32];
+    char*                value = NULL;
+
+    if (vp == NULL || member->key == NULL){
+        return true;
+    }
+    if (member->tag == JSON_STRING){
+        value = member->string_;
+    }else if (member->tag == JSON_NUMBER){
+        /* As pilight shows numbers, integers without decimals */
+        if (member->number_ == floor(member->number_) && fabs(member->number_) < 1e15){
+            snprintf(number, sizeof(number), "%.0f", member->number_);
+        }else{
+            snprintf(number, sizeof(number), "%g", member->number_);
+        }
+        value = number;
+    }else{
+        return true;
+    }
+
+    for (int i = 0; i < vp->n_options; i++){
+        if (strcmp(vp->options[i].name, member->key) == 0){
+#ifndef _WIN32
+            if (vp->options[i].has_mask && regexec(&vp->options[i].mask, value, 0, NULL, 0) != 0){
+                snprintf(error, VALIDATE_ERROR, "%s '%s' invalid", member->key, value);
+                return false;
+            }
+#endif
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool validate_json(validator_t* validator, protocol_t* protocol, const JsonNode* json, char* error){
+
+    JsonNode* member;
+
+    json_foreach(member, (JsonNode*)json){
+        if (!validate_member(validator, protocol, member, error)){
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void validator_free(validator_t* validator){
+
+    validate_protocol_t* vp = validator->protocols;
+
+    while (vp != NULL){
+        validate_protocol_t* next = vp->next;
+#ifndef _WIN32
+        for (int i = 0; i < vp->n_options; i++){
+            if (vp->options[i].has_mask){
+                regfree(&vp->options[i].mask);
+            }
+        }
+#endif
+        free(vp);
+        vp = next;
+    }
+    validator->protocols = NULL;
+}
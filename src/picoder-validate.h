@@ -0,0 +1,58 @@
+/*
+    Simple standalone command line tool to manage OOK protocols
+    supported by "pilight" project, PiCode library based.
+
+    Copyright (c) 2021 Jorge Rivera. All right reserved.
+    License GNU Lesser General Public License v3.0.
+*/
+
+#ifndef PICODER_VALIDATE_H
+#define PICODER_VALIDATE_H
+
+#include <cPiCode.h>
+#include <stdio.h>
+
+#ifndef _WIN32
+#include <regex.h>
+#endif
+
+#ifndef MAX_VALIDATE_OPTIONS
+#define MAX_VALIDATE_OPTIONS    32
+#endif
+
+#define VALIDATE_ERROR         128
+
+/* Protocol option with its mask compiled */
+typedef struct {
+    char*    name;
+    bool     has_mask;
+#ifndef _WIN32
+    regex_t  mask;
+#endif
+} validate_option_t;
+
+typedef struct validate_protocol_t {
+    protocol_t*                  protocol;
+    int                          n_options;
+    validate_option_t            options[MAX_VALIDATE_OPTIONS];
+    struct validate_protocol_t*  next;
+} validate_protocol_t;
+
+/*
+    Cache of compiled option masks, each protocol masks are compiled on its
+    first validation and reused by every next one. Without POSIX regex
+    (Windows) values are not validated.
+*/
+typedef struct {
+    validate_protocol_t*  protocols;
+} validator_t;
+
+/* Check json data values against protocol option masks, error set if invalid */
+bool validate_json(validator_t* validator, protocol_t* protocol, const JsonNode* json, char* error);
+
+/* Check one json data member, as validate_json() */
+bool validate_member(validator_t* validator, protocol_t* protocol, const JsonNode* member, char* error);
+
+void validator_free(validator_t* validator);
+
+#endif
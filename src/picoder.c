@@ -23,6 +23,13 @@ enum {
     ENCODE,
     DECODE,
     CONVERT,
+    ANALYZE,
+    CODEBOOK,
+    REPLAY,
+    SERVE,
+    LOADTEST,
+    BENCH,
+    SPEC,
     VERSION,
     VERSION_v,
     VERSION__v,
@@ -37,6 +44,13 @@ char *const cmds[] = {
     (char*) "encode",
     (char*) "decode",
     (char*) "convert",
+    (char*) "analyze",
+    (char*) "codebook",
+    (char*) "replay",
+    (char*) "serve",
+    (char*) "loadtest",
+    (char*) "bench",
+    (char*) "spec",
     (char*) "version",  
     (char*) "-v",  
     (char*) "--version",  
@@ -48,7 +62,38 @@ char *const cmds[] = {
 
 int main(int argc, char** argv){
 
-    int result = 0;
+    int   result    = 0;
+    char* force_isa = NULL;
+
+    /* Universal --stats and --force-isa options, removed before command options parsing */
+    for (int i = 2; i < argc; i++){
+        int remove = 0;
+        if (strcmp(argv[i], "--stats") == 0){
+            if (!stats_enabled()){
+                stats_start();
+            }
+            remove = 1;
+        }else if (strncmp(argv[i], "--force-isa=", 12) == 0){
+            force_isa = argv[i] + 12;
+            remove    = 1;
+        }else if (strcmp(argv[i], "--force-isa") == 0 && i + 1 < argc){
+            force_isa = argv[i + 1];
+            remove    = 2;
+        }
+        for (int r = 0; r < remove; r++){
+            for (int j = i; j < argc - 1; j++){
+                argv[j] = argv[j + 1];
+            }
+            argv[--argc] = NULL;
+        }
+        i -= (remove > 0);
+    }
+
+    /* SIMD kernels of the running CPU, or up to the forced instruction set */
+    if (!cpu_select(force_isa)){
+        fprintf(stderr,"error: isa '%s' unknown or not supported by this CPU\n", force_isa);
+        return -1;
+    }
 
     if ( argc > 1){
 
@@ -57,6 +102,12 @@ int main(int argc, char** argv){
         char*  saved  =  argv[1];
         char** params = &argv[1];
 
+        if (stats_enabled()){
+            /* Protocols registration out of first command call */
+            usedProtocols();
+            stats_phase(STATS_PARSE);
+        }
+
         switch (getsubopt(params, cmds, &cmd)){
             case LIST:
               result = list_cmd(n_args,params);
@@ -73,10 +124,36 @@ int main(int argc, char** argv){
             case CONVERT:
               result = convert_cmd(n_args,params);
               break;
+            case ANALYZE:
+              result = analyze_cmd(n_args,params);
+              break;
+            case CODEBOOK:
+              result = codebook_cmd(n_args,params);
+              break;
+            case REPLAY:
+              result = replay_cmd(n_args,params);
+              break;
+            case SERVE:
+              result = serve_cmd(n_args,params);
+              break;
+            case LOADTEST:
+              result = loadtest_cmd(n_args,params);
+              break;
+            case BENCH:
+              result = bench_cmd(n_args,params);
+              break;
+            case SPEC:
+              result = spec_cmd(n_args,params);
+              break;
             case VERSION:
             case VERSION_v:
             case VERSION__v:
-              show_version();
+              if (n_args > 1 && (strcmp(params[1], "-c") == 0 || strcmp(params[1], "--check") == 0)){
+                  /* Every SIMD variant against scalar kernels */
+                  result = -cpu_check(stdout);
+              }else{
+                  show_version();
+              }
               break;
             case HELP:
             case HELP_h:
@@ -89,7 +166,17 @@ int main(int argc, char** argv){
               encode_help(default_output);
               decode_help(default_output);
               convert_help(default_output);
-              printf("         version | -v | --version                     --> show version details\n");
+              analyze_help(default_output);
+              codebook_help(default_output);
+              replay_help(default_output);
+              serve_help(default_output);
+              loadtest_help(default_output);
+              bench_help(default_output);
+              spec_help(default_output);
+              printf("         version | -v | --version                     --> show version details and active SIMD kernels\n");
+              printf("         version -c | --check                         --> check every SIMD kernel against scalar one\n");
+              printf("         <command> [options] --stats                  --> show phase times, allocs and peak RSS on stderr\n");
+              printf("         <command> [options] --force-isa isa          --> use SIMD kernels up to scalar, sse4.2, avx2 or neon\n");
               break;
             default:
               /* unknown command as suboption */
@@ -104,5 +191,7 @@ int main(int argc, char** argv){
       printf("  try: \"%s -h\" for commands help\n",argv[0]);
     }
 
+    stats_report(stderr);
+
     return result;
 }
\ No newline at end of file
@@ -38,6 +38,15 @@
 #include "picoder-encode.h"
 #include "picoder-decode.h"
 #include "picoder-convert.h"
+#include "picoder-analyze.h"
+#include "picoder-codebook.h"
+#include "picoder-replay.h"
+#include "picoder-serve.h"
+#include "picoder-loadtest.h"
+#include "picoder-bench.h"
+#include "picoder-spec.h"
+#include "picoder-stats.h"
+#include "picoder-cpu.h"
 
 
 #define STRINGIFY2(X) #X
@@ -61,10 +70,14 @@ void show_version(){
 
     /* Get cPiCode library version (new from v1.2) */
     char* picode_version = getPiCodeVersion();
+    char  kernels[256];
+
+    cpu_describe(kernels, sizeof(kernels));
 
     printf("picoder v%d.%d (%s)\n",MAYOR_VERSION, MINOR_VERSION, STRINGIFY(BUILD_VERSION));
     printf("Compiled at " __DATE__ " " __TIME__ " %s (%s)\n",STRINGIFY(BUILD_COMPILER), BUILD_TYPE );
     printf("PiCode library version: %s\n", picode_version ? picode_version : "unknow");
+    printf("SIMD kernels: %s\n", kernels);
     printf("Copyright (c) 2021-2024 Jorge Rivera. All right reserved.\n");
     printf("See https://github.com/latchdevel/picoder\n\n");
 